@@ -0,0 +1,67 @@
+/*
+
+  FILE: AllocHooks.cpp
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Plugin operator new/delete for REXT_ALLOC_TRACKING builds. Plain malloc/free so
+    memory may still be freed by a delete that is not ours. exports.txt keeps them local
+    to the plugin, so they count the plugin's and its static C++ runtime's heap traffic
+    and never the host's.
+
+*/
+
+#ifdef REXT_ALLOC_TRACKING
+
+#include <stdlib.h>
+#include <new>
+
+#include "AllocTracker.h"
+
+//--------------------------------------------------------------------------------------------------------------------
+// CountedMalloc -
+//--------------------------------------------------------------------------------------------------------------------
+static void *CountedMalloc(size_t size)
+{
+  AllocTracker::Count(size);
+  return malloc(size ? size : 1);
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Replacements. The aligned forms are left to the runtime, nothing here uses over-aligned types.
+//--------------------------------------------------------------------------------------------------------------------
+void *operator new(size_t size)
+{
+  void *ptr = CountedMalloc(size);
+  if (ptr == NULL)
+    {
+      throw std::bad_alloc();
+    }
+  return ptr;
+}
+
+void *operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+  return CountedMalloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+  return CountedMalloc(size);
+}
+
+void operator delete(void *ptr) noexcept                    { free(ptr); }
+void operator delete[](void *ptr) noexcept                  { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept            { free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept          { free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { free(ptr); }
+
+#endif // REXT_ALLOC_TRACKING
@@ -0,0 +1,88 @@
+/*
+
+  FILE: AllocTracker.cpp
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+*/
+
+#include <atomic>
+
+#include "AllocTracker.h"
+
+using namespace std;
+
+static atomic<uint64_t>         sAllocs[kNumAllocPhases * ALLOC_NUM_TYPES];
+static atomic<uint64_t>         sBytes[kNumAllocPhases * ALLOC_NUM_TYPES];
+static thread_local unsigned    tAllocTag = 0;      // phase * ALLOC_NUM_TYPES + type
+
+//--------------------------------------------------------------------------------------------------------------------
+// IsEnabled - whether this build counts at all
+//--------------------------------------------------------------------------------------------------------------------
+bool AllocTracker::IsEnabled()
+{
+#ifdef REXT_ALLOC_TRACKING
+  return true;
+#else
+  return false;
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// SetTag / GetTag -
+//--------------------------------------------------------------------------------------------------------------------
+void AllocTracker::SetTag(AllocPhase phase, RecordType type)
+{
+  tAllocTag = (unsigned)phase * ALLOC_NUM_TYPES + ((unsigned)type % ALLOC_NUM_TYPES);
+}
+
+unsigned AllocTracker::GetTag()
+{
+  return tAllocTag;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Count -
+//--------------------------------------------------------------------------------------------------------------------
+void AllocTracker::Count(size_t bytes)
+{
+  sAllocs[tAllocTag].fetch_add(1, memory_order_relaxed);
+  sBytes[tAllocTag].fetch_add(bytes, memory_order_relaxed);
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Get -
+//--------------------------------------------------------------------------------------------------------------------
+AllocCounts AllocTracker::Get(AllocPhase phase, RecordType type)
+{
+  unsigned    tag = (unsigned)phase * ALLOC_NUM_TYPES + ((unsigned)type % ALLOC_NUM_TYPES);
+  AllocCounts counts;
+
+  counts.allocs = sAllocs[tag].load(memory_order_relaxed);
+  counts.bytes  = sBytes[tag].load(memory_order_relaxed);
+  return counts;
+}
+
+AllocCounts AllocTracker::Get(AllocPhase phase)
+{
+  AllocCounts total = { 0, 0 };
+
+  for (int t = 0; t < ALLOC_NUM_TYPES; t++)
+    {
+      AllocCounts counts = Get(phase, (RecordType)t);
+      total.allocs += counts.allocs;
+      total.bytes  += counts.bytes;
+    }
+  return total;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// PhaseName - as used in the dataref names
+//--------------------------------------------------------------------------------------------------------------------
+const char *AllocTracker::PhaseName(AllocPhase phase)
+{
+  static const char *names[kNumAllocPhases] = { "other", "register", "record", "replay", "restore", "seek", "worker" };
+  return names[phase];
+}
@@ -0,0 +1,109 @@
+/*
+
+  FILE: AllocTracker.h
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Heap allocation counts per flight loop phase and channel type, for profiling builds
+    (REXT_ALLOC_TRACKING, see CMakeLists.txt and Makefile). Code marks what it is doing
+    with ALLOC_SCOPE / ALLOC_TAG; the plugin's operator new (AllocHooks.cpp) counts every
+    allocation against the calling thread's current tag. In normal builds the macros are
+    empty and nothing is counted.
+
+*/
+
+#ifndef __ALLOC_TRACKER__
+#define __ALLOC_TRACKER__
+
+//--------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//--------------------------------------------------------------------------------------------------------------------
+#include <stddef.h>
+#include <stdint.h>
+
+#include "RecordingFormat.h"
+#include "TraceBuffer.h"
+
+//--------------------------------------------------------------------------------------------------------------------
+// DEFINES
+//--------------------------------------------------------------------------------------------------------------------
+enum AllocPhase
+{
+  kAllocOther = 0,        // Untagged: plugin start, menus, stats readers, ...
+  kAllocRegister,
+  kAllocRecord,           // Sim thread snapshot
+  kAllocReplay,
+  kAllocRestore,
+  kAllocSeek,             // Sim thread and seek pool
+  kAllocWorker,           // Record workers: change detection and storage
+  kNumAllocPhases
+};
+
+#define ALLOC_NUM_TYPES     4       // RecordType: none, float, int, bytes
+
+#ifdef REXT_ALLOC_TRACKING
+#define ALLOC_SCOPE(phase, type)    AllocScope TRACE_CONCAT(allocScope, __LINE__)(phase, type)
+#define ALLOC_TAG(phase, type)      AllocTracker::SetTag(phase, type)
+#else
+#define ALLOC_SCOPE(phase, type)
+#define ALLOC_TAG(phase, type)
+#endif
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT AllocCounts
+//--------------------------------------------------------------------------------------------------------------------
+struct AllocCounts
+{
+  uint64_t allocs;
+  uint64_t bytes;
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS AllocTracker - process wide counters, all static
+//--------------------------------------------------------------------------------------------------------------------
+class AllocTracker
+{
+  public:
+    static bool IsEnabled();
+
+    static void SetTag(AllocPhase phase, RecordType type);
+    static unsigned GetTag();
+
+    //-----------------------------------------------------------------------------
+    // Called from operator new, must not allocate
+    //-----------------------------------------------------------------------------
+    static void Count(size_t bytes);
+
+    //-----------------------------------------------------------------------------
+    // Totals since the plugin was loaded
+    //-----------------------------------------------------------------------------
+    static AllocCounts Get(AllocPhase phase, RecordType type);
+    static AllocCounts Get(AllocPhase phase);
+
+    static const char *PhaseName(AllocPhase phase);
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS AllocScope - tags the calling thread until the end of the scope
+//--------------------------------------------------------------------------------------------------------------------
+class AllocScope
+{
+  protected:
+    unsigned m_saved;
+
+  public:
+    AllocScope(AllocPhase phase, RecordType type)
+    {
+      m_saved = AllocTracker::GetTag();
+      AllocTracker::SetTag(phase, type);
+    }
+
+    ~AllocScope()
+    {
+      AllocTracker::SetTag((AllocPhase)(m_saved / ALLOC_NUM_TYPES), (RecordType)(m_saved % ALLOC_NUM_TYPES));
+    }
+};
+
+#endif // __ALLOC_TRACKER__
@@ -0,0 +1,104 @@
+/*
+
+  FILE: BenchAlloc.cpp
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Global operator new/delete replacements counting heap traffic for the benchmarks.
+    Every block carries its size in a header so live bytes can be tracked portably.
+
+*/
+
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+#include "BenchUtil.h"
+
+#define ALLOC_HEADER_SIZE   16      // Keeps the default new alignment
+
+static atomic<uint64_t> sAllocs(0);
+static atomic<uint64_t> sBytesAllocated(0);
+static atomic<int64_t>  sBytesLive(0);
+
+//--------------------------------------------------------------------------------------------------------------------
+// GetHeapCounters -
+//--------------------------------------------------------------------------------------------------------------------
+HeapCounters GetHeapCounters()
+{
+  HeapCounters counters;
+
+  counters.allocs         = sAllocs.load(memory_order_relaxed);
+  counters.bytesAllocated = sBytesAllocated.load(memory_order_relaxed);
+  counters.bytesLive      = sBytesLive.load(memory_order_relaxed);
+
+  return counters;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// CountedAlloc / CountedFree -
+//--------------------------------------------------------------------------------------------------------------------
+static void *CountedAlloc(size_t size)
+{
+  char *block = (char *)malloc(size + ALLOC_HEADER_SIZE);
+  if (block == NULL)
+    {
+      return NULL;
+    }
+
+  *(size_t *)block = size;
+  sAllocs.fetch_add(1, memory_order_relaxed);
+  sBytesAllocated.fetch_add(size, memory_order_relaxed);
+  sBytesLive.fetch_add((int64_t)size, memory_order_relaxed);
+
+  return block + ALLOC_HEADER_SIZE;
+}
+
+static void CountedFree(void *ptr)
+{
+  if (ptr == NULL)
+    {
+      return;
+    }
+
+  char *block = (char *)ptr - ALLOC_HEADER_SIZE;
+  sBytesLive.fetch_sub((int64_t)*(size_t *)block, memory_order_relaxed);
+  free(block);
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Replacements. The aligned forms are left to the runtime, nothing here uses over-aligned types.
+//--------------------------------------------------------------------------------------------------------------------
+void *operator new(size_t size)
+{
+  void *ptr = CountedAlloc(size);
+  if (ptr == NULL)
+    {
+      throw bad_alloc();
+    }
+  return ptr;
+}
+
+void *operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void *operator new(size_t size, const nothrow_t &) noexcept
+{
+  return CountedAlloc(size);
+}
+
+void *operator new[](size_t size, const nothrow_t &) noexcept
+{
+  return CountedAlloc(size);
+}
+
+void operator delete(void *ptr) noexcept                            { CountedFree(ptr); }
+void operator delete[](void *ptr) noexcept                          { CountedFree(ptr); }
+void operator delete(void *ptr, size_t) noexcept                    { CountedFree(ptr); }
+void operator delete[](void *ptr, size_t) noexcept                  { CountedFree(ptr); }
+void operator delete(void *ptr, const nothrow_t &) noexcept         { CountedFree(ptr); }
+void operator delete[](void *ptr, const nothrow_t &) noexcept       { CountedFree(ptr); }
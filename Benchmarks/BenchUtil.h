@@ -0,0 +1,133 @@
+/*
+
+  FILE: BenchUtil.h
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Shared bits of the benchmark programs: a clock, heap counters fed by the operator
+    new/delete replacements in BenchAlloc.cpp, and one JSON object per result line so
+    runs can be diffed and parsed by scripts.
+
+*/
+
+#ifndef __BENCH_UTIL__
+#define __BENCH_UTIL__
+
+//--------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//--------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <string>
+
+using namespace std;
+
+//--------------------------------------------------------------------------------------------------------------------
+// Heap counters, totals since the program started
+//--------------------------------------------------------------------------------------------------------------------
+struct HeapCounters
+{
+  uint64_t allocs;
+  uint64_t bytesAllocated;
+  int64_t  bytesLive;
+};
+
+HeapCounters GetHeapCounters();
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS BenchTimer
+//--------------------------------------------------------------------------------------------------------------------
+class BenchTimer
+{
+  protected:
+    chrono::steady_clock::time_point m_start;
+
+  public:
+    BenchTimer() { this->Restart(); }
+
+    void Restart() { m_start = chrono::steady_clock::now(); }
+
+    double ElapsedNs() const
+    {
+      return (double)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - m_start).count();
+    }
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS BenchResult - builds one {"key": value, ...} line
+//--------------------------------------------------------------------------------------------------------------------
+class BenchResult
+{
+  protected:
+    string m_line;
+
+    void Key(const char *key)
+    {
+      m_line += m_line.empty() ? "{" : ", ";
+      m_line += "\"";
+      m_line += key;
+      m_line += "\": ";
+    }
+
+  public:
+    BenchResult &Add(const char *key, const char *val)
+    {
+      this->Key(key);
+      m_line += "\"";
+      m_line += val;
+      m_line += "\"";
+      return *this;
+    }
+
+    BenchResult &Add(const char *key, double val)
+    {
+      char buf[64];
+      snprintf(buf, sizeof(buf), "%.6g", val);
+      this->Key(key);
+      m_line += buf;
+      return *this;
+    }
+
+    BenchResult &Add(const char *key, uint64_t val)
+    {
+      char buf[32];
+      snprintf(buf, sizeof(buf), "%llu", (unsigned long long)val);
+      this->Key(key);
+      m_line += buf;
+      return *this;
+    }
+
+    void Print(FILE *out = stdout)
+    {
+      fprintf(out, "%s}\n", m_line.c_str());
+      fflush(out);
+      m_line.clear();
+    }
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// Small deterministic generator so runs are repeatable (xorshift64*)
+//--------------------------------------------------------------------------------------------------------------------
+class BenchRandom
+{
+  protected:
+    uint64_t m_state;
+
+  public:
+    explicit BenchRandom(uint64_t seed) { m_state = seed ? seed : 0x9E3779B97F4A7C15ULL; }
+
+    uint64_t Next()
+    {
+      m_state ^= m_state >> 12;
+      m_state ^= m_state << 25;
+      m_state ^= m_state >> 27;
+      return m_state * 0x2545F4914F6CDD1DULL;
+    }
+
+    double Uniform() { return (this->Next() >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+#endif // __BENCH_UTIL__
@@ -0,0 +1,810 @@
+/*
+
+  FILE: FlightLoopBench.cpp
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    End to end benchmark of the plugin's flight loop. Loads the built plugin against the
+    mock XPLM with a synthetic workload (Workload.h) and its generated rextconfig.txt,
+    then flies: dataref registration, recording, and a few replay sessions (enter, play,
+    scrub forward and back, exit). Reports the flight loop time per phase as one JSON
+    line each with p50/p99/max.
+
+    With --soak the same setup records for hours of sim time as fast as it can instead.
+    Every sample interval it prints RSS, the storage held per channel type (read from the
+    plugin's rext/stats/storage datarefs), the record tick cost and the cost of a second
+    of replay. At the end the second half of the run is checked: memory still growing or
+    tick cost drifting up is flagged, and the exit code is 2.
+
+    With --check-alloc, after the flight a further N steady state record ticks are counted
+    against the plugin's rext/stats/alloc datarefs (plugin built with REXT_ALLOC_TRACKING).
+    Allocations per tick are reported per phase and channel type; any allocation in the
+    sim thread's record phase fails the check with exit code 3.
+
+    usage: rext_flightloop_bench [--plugin <lin.xpl>] [--channels N] [--seed N] [--mix <mix>]
+                                 [--record <sim s>] [--fps N] [--cycles N] [--set <directive>]...
+                                 [--keep-config <path>] [--verbose]
+                                 [--soak <sim hours>] [--sample <sim minutes>] [--max-samples N]
+                                 [--trace <path>] [--check-alloc N] [--slow-rate <s>]
+
+    --set adds an @ line to the conf file, e.g. --set workers0
+    --mix sets behavior percentages, e.g. switch=25,enum=15,gauge=25,sensor=10,array=20,bytes=5,
+          wholearrays=1 lists the arrays without an index so they are recorded whole
+    --keep-config copies the generated conf file to path
+    --max-samples writes a $ line, soak runs default to $2000, 0 leaves it out
+    --trace turns on the plugin's trace buffer and copies its Chrome trace dump to path
+    --slow-rate records the switches and enum selectors in an @rate group of that interval
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Workload.h"
+#include "XPLMMock.h"
+#include "XPLMPlugin.h"
+#include "XPLMDataAccess.h"
+
+#ifndef REXT_PLUGIN_PATH
+#define REXT_PLUGIN_PATH        "Deploy/rext/64/lin.xpl"
+#endif
+
+#define MAX_REGISTER_TICKS      250
+#define SOAK_DEFAULT_MAX_SAMPLES 2000
+#define SOAK_GROWTH_FRACTION    0.05    // Growth over the checked half of the run that is flagged
+#define SOAK_GROWTH_MIN_KB      256.0   // ... when it is also at least this much
+#define SOAK_CHANNEL_GROWTH_KB  4.0     // A channel growing by more than this is still filling up
+#define SOAK_DRIFT_RATIO        1.25    // Tick cost of the last quarter over the third quarter
+#define ALLOC_NUM_TYPES         4       // rext/stats/alloc arrays are indexed by RecordType
+
+enum SoakStorage
+{
+  kSoakFloat = 0,
+  kSoakInt,
+  kSoakBytes,
+  kNumSoakStorage
+};
+
+static const char *sSoakStorageNames[kNumSoakStorage] = { "float", "int", "bytes" };
+static const char *sAllocPhases[]                     = { "other", "register", "record", "replay",
+                                                          "restore", "seek", "worker" };
+static const char *sAllocTypes[ALLOC_NUM_TYPES]       = { "none", "float", "int", "bytes" };
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT SoakSample
+//--------------------------------------------------------------------------------------------------------------------
+struct SoakSample
+{
+  double  hours;
+  double  rssKb;
+  double  storageKb[kNumSoakStorage];
+  double  tickMeanUs;
+  double  tickP99Us;
+  double  replayMeanUs;
+};
+
+static map<string, vector<double> >    sPhaseTimes;
+static vector<string>                  sPhaseOrder;
+static unsigned                        sRegistered = 0;
+static bool                            sVerbose = false;
+static float                           sSimTime = 0.0f;
+static Workload                        sWorkload;
+
+//--------------------------------------------------------------------------------------------------------------------
+// CountLog - count registrations, the log is dropped unless --verbose
+//--------------------------------------------------------------------------------------------------------------------
+static void CountLog(const char *inString)
+{
+  if (strstr(inString, " registered ") != NULL)
+    {
+      sRegistered++;
+    }
+
+  if (sVerbose)
+    {
+      fputs(inString, stderr);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Tick - one sim frame, the flight loop time goes to phase (if not NULL) and is returned if the plugin's
+//        loop ran, -1 otherwise
+//--------------------------------------------------------------------------------------------------------------------
+static double Tick(const char *phase, float dt, bool updateValues)
+{
+  if (updateValues)
+    {
+      sWorkload.Update(sSimTime);
+    }
+  MockSetTime(sSimTime);
+
+  BenchTimer timer;
+  int        ran = MockRunFlightLoops(dt);
+  double     ns  = timer.ElapsedNs();
+
+  if (ran <= 0)
+    {
+      return -1.0;
+    }
+
+  if (phase != NULL)
+    {
+      if (sPhaseTimes.find(phase) == sPhaseTimes.end())
+        {
+          sPhaseOrder.push_back(phase);
+        }
+      sPhaseTimes[phase].push_back(ns);
+    }
+
+  return ns;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ReportPhases -
+//--------------------------------------------------------------------------------------------------------------------
+static void ReportPhases(unsigned channels)
+{
+  for (size_t p = 0; p < sPhaseOrder.size(); p++)
+    {
+      vector<double> &times = sPhaseTimes[sPhaseOrder[p]];
+      sort(times.begin(), times.end());
+
+      double sum = 0.0;
+      for (size_t i = 0; i < times.size(); i++)
+        {
+          sum += times[i];
+        }
+
+      BenchResult result;
+      result.Add("phase", sPhaseOrder[p].c_str())
+            .Add("channels", (uint64_t)channels)
+            .Add("ticks", (uint64_t)times.size())
+            .Add("mean_us", sum / times.size() / 1000.0)
+            .Add("p50_us", times[times.size() / 2] / 1000.0)
+            .Add("p99_us", times[min(times.size() - 1, times.size() * 99 / 100)] / 1000.0)
+            .Add("max_us", times.back() / 1000.0)
+            .Print();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ReportPluginStats - the plugin's own view of its tick cost, from its rext/stats datarefs
+//--------------------------------------------------------------------------------------------------------------------
+static void ReportPluginStats()
+{
+  static const char *phases[] = { "register", "record", "replay", "restore", "seek" };
+
+  for (size_t p = 0; p < sizeof(phases) / sizeof(phases[0]); p++)
+    {
+      string prefix = string("rext/stats/") + phases[p] + "/";
+      int    ticks  = XPLMGetDatai(XPLMFindDataRef((prefix + "ticks").c_str()));
+
+      if (ticks > 0)
+        {
+          BenchResult result;
+          result.Add("plugin_phase", phases[p])
+                .Add("ticks", (uint64_t)ticks)
+                .Add("p50_us", (double)XPLMGetDataf(XPLMFindDataRef((prefix + "p50_us").c_str())))
+                .Add("p99_us", (double)XPLMGetDataf(XPLMFindDataRef((prefix + "p99_us").c_str())))
+                .Add("max_us", (double)XPLMGetDataf(XPLMFindDataRef((prefix + "max_us").c_str())))
+                .Print();
+        }
+    }
+
+  BenchResult result;
+  result.Add("plugin_storage_kb", (uint64_t)XPLMGetDatai(XPLMFindDataRef("rext/stats/storage_kb")))
+        .Add("last_tick_channels", (uint64_t)XPLMGetDatai(XPLMFindDataRef("rext/stats/tick/channels")))
+        .Add("last_tick_xplm_calls", (uint64_t)XPLMGetDatai(XPLMFindDataRef("rext/stats/tick/xplm_calls")))
+        .Print();
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ReadAllocCounts - rext/stats/alloc/<phase>/<field> per channel type, false if the plugin does not track
+//--------------------------------------------------------------------------------------------------------------------
+static bool ReadAllocCounts(const char *phase, const char *field, uint32_t outCounts[ALLOC_NUM_TYPES])
+{
+  XPLMDataRef ref = XPLMFindDataRef((string("rext/stats/alloc/") + phase + "/" + field).c_str());
+  int         values[ALLOC_NUM_TYPES] = { 0 };
+
+  if (ref == NULL)
+    {
+      return false;
+    }
+
+  XPLMGetDatavi(ref, values, 0, ALLOC_NUM_TYPES);
+  for (int t = 0; t < ALLOC_NUM_TYPES; t++)
+    {
+      outCounts[t] = (uint32_t)values[t];
+    }
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// CheckAllocations - allocations over ticks more record ticks, 0 if the sim thread record phase made none,
+//                    3 if it did, 1 if the plugin was built without allocation tracking
+//--------------------------------------------------------------------------------------------------------------------
+static int CheckAllocations(unsigned ticks, float dt)
+{
+  const size_t numPhases = sizeof(sAllocPhases) / sizeof(sAllocPhases[0]);
+  uint32_t     allocs[numPhases][ALLOC_NUM_TYPES];
+  uint32_t     bytes[numPhases][ALLOC_NUM_TYPES];
+
+  for (size_t p = 0; p < numPhases; p++)
+    {
+      if (!ReadAllocCounts(sAllocPhases[p], "allocs", allocs[p]) || !ReadAllocCounts(sAllocPhases[p], "bytes", bytes[p]))
+        {
+          fprintf(stderr, "The plugin was built without REXT_ALLOC_TRACKING\n");
+          return 1;
+        }
+    }
+
+  for (unsigned i = 0; i < ticks; i++)
+    {
+      sSimTime += dt;
+      Tick("alloc_check", dt, true);
+    }
+
+  uint64_t recordAllocs = 0;
+
+  for (size_t p = 0; p < numPhases; p++)
+    {
+      uint32_t allocsNow[ALLOC_NUM_TYPES];
+      uint32_t bytesNow[ALLOC_NUM_TYPES];
+
+      ReadAllocCounts(sAllocPhases[p], "allocs", allocsNow);
+      ReadAllocCounts(sAllocPhases[p], "bytes", bytesNow);
+
+      for (int t = 0; t < ALLOC_NUM_TYPES; t++)
+        {
+          uint32_t n = allocsNow[t] - allocs[p][t];
+          if (n == 0)
+            {
+              continue;
+            }
+
+          BenchResult result;
+          result.Add("alloc_phase", sAllocPhases[p])
+                .Add("type", sAllocTypes[t])
+                .Add("ticks", (uint64_t)ticks)
+                .Add("allocs", (uint64_t)n)
+                .Add("allocs_per_tick", (double)n / ticks)
+                .Add("bytes_per_tick", (double)(uint32_t)(bytesNow[t] - bytes[p][t]) / ticks)
+                .Print();
+
+          recordAllocs += strcmp(sAllocPhases[p], "record") ? 0 : n;
+        }
+    }
+
+  BenchResult verdict;
+  verdict.Add("alloc_check", recordAllocs ? "record_allocates" : "ok")
+         .Add("ticks", (uint64_t)ticks)
+         .Add("record_allocs", recordAllocs)
+         .Print();
+
+  return recordAllocs ? 3 : 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// CopyTrace - have the plugin dump its trace next to the conf file and keep it
+//--------------------------------------------------------------------------------------------------------------------
+static void CopyTrace(const filesystem::path &top, const string &tracePath)
+{
+  if (!MockSelectMenuItem("Dump Trace"))
+    {
+      fprintf(stderr, "The plugin has no Dump Trace menu item\n");
+      return;
+    }
+
+  for (filesystem::directory_iterator iter(top); iter != filesystem::directory_iterator(); ++iter)
+    {
+      if (iter->path().filename().string().find("rext_trace_") == 0)
+        {
+          filesystem::copy_file(iter->path(), tracePath, filesystem::copy_options::overwrite_existing);
+          return;
+        }
+    }
+
+  fprintf(stderr, "No trace file was written\n");
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// RunPhases - the benchmark flight
+//--------------------------------------------------------------------------------------------------------------------
+static void RunPhases(float recordSecs, float dt, float fps, unsigned cycles)
+{
+  //
+  // Record, then replay sessions separated by more recording
+  //
+  BenchRandom random((uint64_t)sWorkload.NumChannels());
+
+  for (float end = sSimTime + recordSecs; sSimTime < end; )
+    {
+      sSimTime += dt;
+      Tick("record", dt, true);
+    }
+
+  for (unsigned c = 0; c < cycles; c++)
+    {
+      float liveTime = sSimTime;
+
+      sSimTime = (float)(random.Uniform() * liveTime * 0.5);
+      MockSetInReplay(1);
+      Tick("enter_replay", dt, false);
+
+      for (int i = 0; i < (int)fps * 2; i++)
+        {
+          sSimTime += dt;
+          Tick("replay", dt, false);
+        }
+
+      for (int i = 0; i < 10; i++)
+        {
+          float from = sSimTime;
+          sSimTime = (float)(random.Uniform() * liveTime);
+          Tick((sSimTime > from) ? "scrub_forward" : "scrub_back", dt, false);
+        }
+
+      sSimTime = liveTime + dt;
+      MockSetInReplay(0);
+      Tick("exit_replay", dt, true);
+
+      for (int i = 0; i < (int)fps * 5; i++)
+        {
+          sSimTime += dt;
+          Tick("record", dt, true);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ReadRssKb - resident set size of the whole process, plugin included
+//--------------------------------------------------------------------------------------------------------------------
+static double ReadRssKb()
+{
+  long  size     = 0;
+  long  resident = 0;
+  FILE *statm    = fopen("/proc/self/statm", "r");
+
+  if (statm != NULL)
+    {
+      if (fscanf(statm, "%ld %ld", &size, &resident) != 2)
+        {
+          resident = 0;
+        }
+      fclose(statm);
+    }
+
+  return (double)resident * (double)sysconf(_SC_PAGESIZE) / 1024.0;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ReadStorage - per channel storage bytes of one type from the plugin's stats datarefs
+//--------------------------------------------------------------------------------------------------------------------
+static double ReadStorage(SoakStorage storage, vector<int> &outBytes)
+{
+  string      name = string("rext/stats/storage/") + sSoakStorageNames[storage];
+  XPLMDataRef ref  = XPLMFindDataRef(name.c_str());
+  double      kb   = 0.0;
+
+  outBytes.clear();
+  if (ref == NULL)
+    {
+      return 0.0;
+    }
+
+  outBytes.resize(XPLMGetDatavi(ref, NULL, 0, 0));
+  if (!outBytes.empty())
+    {
+      XPLMGetDatavi(ref, &outBytes[0], 0, (int)outBytes.size());
+    }
+
+  for (size_t i = 0; i < outBytes.size(); i++)
+    {
+      kb += outBytes[i] / 1024.0;
+    }
+  return kb;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Median - of samples [begin, end) of one field
+//--------------------------------------------------------------------------------------------------------------------
+static double Median(const vector<SoakSample> &samples, size_t begin, size_t end, double SoakSample::*field)
+{
+  vector<double> values;
+  for (size_t i = begin; i < end; i++)
+    {
+      values.push_back(samples[i].*field);
+    }
+  if (values.empty())
+    {
+      return 0.0;
+    }
+
+  sort(values.begin(), values.end());
+  return values[values.size() / 2];
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// CheckGrowth - first and last of the checked half, flagged if it keeps growing
+//--------------------------------------------------------------------------------------------------------------------
+static bool CheckGrowth(const char *metric, double first, double last, double hours)
+{
+  double growthKb = last - first;
+  bool   flagged  = (growthKb > SOAK_GROWTH_MIN_KB) && (growthKb > first * SOAK_GROWTH_FRACTION);
+
+  BenchResult result;
+  result.Add("soak_check", metric)
+        .Add("first_kb", first)
+        .Add("last_kb", last)
+        .Add("kb_per_hour", (hours > 0.0) ? growthKb / hours : 0.0)
+        .Add("flag", flagged ? "growth" : "ok")
+        .Print();
+
+  return flagged;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// CheckDrift - median of the last quarter against the third quarter
+//--------------------------------------------------------------------------------------------------------------------
+static bool CheckDrift(const char *metric, const vector<SoakSample> &samples, double SoakSample::*field)
+{
+  size_t n      = samples.size();
+  double before = Median(samples, n / 2, n * 3 / 4, field);
+  double after  = Median(samples, n * 3 / 4, n, field);
+  double ratio  = (before > 0.0) ? after / before : 1.0;
+  bool   flagged = ratio > SOAK_DRIFT_RATIO;
+
+  BenchResult result;
+  result.Add("soak_check", metric)
+        .Add("third_quarter_us", before)
+        .Add("last_quarter_us", after)
+        .Add("ratio", ratio)
+        .Add("flag", flagged ? "drift" : "ok")
+        .Print();
+
+  return flagged;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// CheckChannels - channels of one type whose storage still grew over the checked half
+//--------------------------------------------------------------------------------------------------------------------
+static bool CheckChannels(SoakStorage storage, const vector<int> &first, const vector<int> &last)
+{
+  static const XPLMDataTypeID types[kNumSoakStorage] = { xplmType_Float, xplmType_Int, xplmType_Data };
+
+  vector<string> names;
+  sWorkload.ChannelNames(types[storage], names);
+
+  size_t growing  = 0;
+  size_t worst    = 0;
+  double worstKb  = 0.0;
+
+  for (size_t i = 0; (i < first.size()) && (i < last.size()); i++)
+    {
+      double growthKb = (last[i] - first[i]) / 1024.0;
+      if ((growthKb > SOAK_CHANNEL_GROWTH_KB) && (growthKb > first[i] / 1024.0 * SOAK_GROWTH_FRACTION))
+        {
+          growing++;
+        }
+      if (growthKb > worstKb)
+        {
+          worst   = i;
+          worstKb = growthKb;
+        }
+    }
+
+  string metric = string("channels_") + sSoakStorageNames[storage];
+
+  BenchResult result;
+  result.Add("soak_check", metric.c_str())
+        .Add("channels", (uint64_t)last.size())
+        .Add("growing", (uint64_t)growing)
+        .Add("worst", (worst < names.size()) ? names[worst].c_str() : "")
+        .Add("worst_growth_kb", worstKb)
+        .Add("flag", growing ? "growth" : "ok")
+        .Print();
+
+  return growing > 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// RunSoak - record for hours of sim time, sampling memory and tick cost. Returns 2 if anything was flagged.
+//--------------------------------------------------------------------------------------------------------------------
+static int RunSoak(float hours, float sampleMinutes, float dt)
+{
+  BenchRandom        random((uint64_t)sWorkload.NumChannels());
+  vector<SoakSample> samples;
+  vector<double>     tickNs;
+  vector<double>     replayNs;
+  vector<int>        bytes[kNumSoakStorage];
+  vector<int>        checkStart[kNumSoakStorage];
+  size_t             checkFrom  = 0;
+  bool               checking   = false;
+  double             startTime  = sSimTime;
+  double             soakSecs   = hours * 3600.0;
+  double             sampleSecs = max(sampleMinutes * 60.0, 1.0);
+  double             nextSample = sampleSecs;
+  uint64_t           tick       = 0;
+  BenchTimer         wallClock;
+
+  tickNs.reserve((size_t)(sampleSecs / dt) + 16);
+
+  while (tick * (double)dt < soakSecs)
+    {
+      sSimTime = (float)(startTime + (++tick) * (double)dt);
+
+      double ns = Tick(NULL, dt, true);
+      if (ns >= 0.0)
+        {
+          tickNs.push_back(ns);
+        }
+
+      if (tick * (double)dt < nextSample)
+        {
+          continue;
+        }
+      nextSample += sampleSecs;
+
+      //
+      // One second of replay somewhere in the history, then back to where recording left off
+      //
+      float liveTime = sSimTime;
+
+      sSimTime = (float)(startTime + random.Uniform() * (liveTime - startTime));
+      MockSetInReplay(1);
+      Tick(NULL, dt, false);
+
+      replayNs.clear();
+      for (int i = 0; i < (int)(1.0f / dt); i++)
+        {
+          sSimTime += dt;
+          double replay = Tick(NULL, dt, false);
+          if (replay >= 0.0)
+            {
+              replayNs.push_back(replay);
+            }
+        }
+
+      sSimTime = (float)(startTime + (++tick) * (double)dt);
+      MockSetInReplay(0);
+      Tick(NULL, dt, true);
+
+      SoakSample sample;
+      double     sum = 0.0;
+
+      sort(tickNs.begin(), tickNs.end());
+      for (size_t i = 0; i < tickNs.size(); i++)
+        {
+          sum += tickNs[i];
+        }
+      sample.tickMeanUs = tickNs.empty() ? 0.0 : sum / tickNs.size() / 1000.0;
+      sample.tickP99Us  = tickNs.empty() ? 0.0 : tickNs[min(tickNs.size() - 1, tickNs.size() * 99 / 100)] / 1000.0;
+      tickNs.clear();
+
+      sum = 0.0;
+      for (size_t i = 0; i < replayNs.size(); i++)
+        {
+          sum += replayNs[i];
+        }
+      sample.replayMeanUs = replayNs.empty() ? 0.0 : sum / replayNs.size() / 1000.0;
+
+      sample.hours = tick * (double)dt / 3600.0;
+      sample.rssKb = ReadRssKb();
+      for (int k = 0; k < kNumSoakStorage; k++)
+        {
+          sample.storageKb[k] = ReadStorage((SoakStorage)k, bytes[k]);
+        }
+      samples.push_back(sample);
+
+      BenchResult result;
+      result.Add("soak_sample", (uint64_t)samples.size())
+            .Add("sim_hours", sample.hours)
+            .Add("wall_s", wallClock.ElapsedNs() / 1e9)
+            .Add("rss_kb", sample.rssKb)
+            .Add("float_kb", sample.storageKb[kSoakFloat])
+            .Add("int_kb", sample.storageKb[kSoakInt])
+            .Add("bytes_kb", sample.storageKb[kSoakBytes])
+            .Add("tick_mean_us", sample.tickMeanUs)
+            .Add("tick_p99_us", sample.tickP99Us)
+            .Add("replay_mean_us", sample.replayMeanUs)
+            .Print();
+
+      //
+      // The second half of the run is what gets checked, the first is for caps to fill up
+      //
+      if (!checking && (tick * (double)dt >= soakSecs / 2.0))
+        {
+          checking  = true;
+          checkFrom = samples.size() - 1;
+          for (int k = 0; k < kNumSoakStorage; k++)
+            {
+              checkStart[k] = bytes[k];
+            }
+        }
+    }
+
+  if (!checking || (samples.size() - checkFrom < 2) || (samples.size() < 4))
+    {
+      BenchResult result;
+      result.Add("soak_verdict", "too_short").Add("samples", (uint64_t)samples.size()).Print();
+      return 0;
+    }
+
+  const SoakSample &first = samples[checkFrom];
+  const SoakSample &last  = samples.back();
+  double           span   = last.hours - first.hours;
+  unsigned         flags  = 0;
+
+  flags += CheckGrowth("rss", first.rssKb, last.rssKb, span);
+  for (int k = 0; k < kNumSoakStorage; k++)
+    {
+      string metric = string("storage_") + sSoakStorageNames[k];
+      flags += CheckGrowth(metric.c_str(), first.storageKb[k], last.storageKb[k], span);
+      flags += CheckChannels((SoakStorage)k, checkStart[k], bytes[k]);
+    }
+  flags += CheckDrift("tick_mean", samples, &SoakSample::tickMeanUs);
+  flags += CheckDrift("tick_p99", samples, &SoakSample::tickP99Us);
+  flags += CheckDrift("replay_mean", samples, &SoakSample::replayMeanUs);
+
+  BenchResult result;
+  result.Add("soak_verdict", flags ? "flagged" : "ok")
+        .Add("flags", (uint64_t)flags)
+        .Add("sim_hours", last.hours)
+        .Add("wall_s", wallClock.ElapsedNs() / 1e9)
+        .Print();
+
+  return flags ? 2 : 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// main -
+//--------------------------------------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  string         pluginPath = REXT_PLUGIN_PATH;
+  unsigned       channels   = 2000;
+  float          recordSecs = 120.0f;
+  float          fps        = 60.0f;
+  unsigned       cycles     = 5;
+  vector<string> settings;
+  uint64_t       seed       = 1;
+  WorkloadMix    mix;
+  string         keepConfig;
+  float          soakHours  = 0.0f;
+  float          sampleMins = 15.0f;
+  long           maxSamples = -1;
+  string         tracePath;
+  unsigned       allocTicks = 0;
+  float          slowRate   = 0.0f;
+
+  for (int i = 1; i < argc; i++)
+    {
+      if (!strcmp(argv[i], "--plugin") && (i + 1 < argc))        pluginPath = argv[++i];
+      else if (!strcmp(argv[i], "--channels") && (i + 1 < argc)) channels = (unsigned)atoi(argv[++i]);
+      else if (!strcmp(argv[i], "--record") && (i + 1 < argc))   recordSecs = (float)atof(argv[++i]);
+      else if (!strcmp(argv[i], "--fps") && (i + 1 < argc))      fps = (float)atof(argv[++i]);
+      else if (!strcmp(argv[i], "--cycles") && (i + 1 < argc))   cycles = (unsigned)atoi(argv[++i]);
+      else if (!strcmp(argv[i], "--set") && (i + 1 < argc))      settings.push_back(string("@") + argv[++i]);
+      else if (!strcmp(argv[i], "--seed") && (i + 1 < argc))     seed = strtoull(argv[++i], NULL, 10);
+      else if (!strcmp(argv[i], "--mix") && (i + 1 < argc) && mix.Parse(argv[i + 1])) i++;
+      else if (!strcmp(argv[i], "--keep-config") && (i + 1 < argc)) keepConfig = argv[++i];
+      else if (!strcmp(argv[i], "--soak") && (i + 1 < argc))     soakHours = (float)atof(argv[++i]);
+      else if (!strcmp(argv[i], "--sample") && (i + 1 < argc))   sampleMins = (float)atof(argv[++i]);
+      else if (!strcmp(argv[i], "--max-samples") && (i + 1 < argc)) maxSamples = atol(argv[++i]);
+      else if (!strcmp(argv[i], "--trace") && (i + 1 < argc))    tracePath = argv[++i];
+      else if (!strcmp(argv[i], "--check-alloc") && (i + 1 < argc)) allocTicks = (unsigned)atoi(argv[++i]);
+      else if (!strcmp(argv[i], "--slow-rate") && (i + 1 < argc)) slowRate = (float)atof(argv[++i]);
+      else if (!strcmp(argv[i], "--verbose"))                    sVerbose = true;
+      else
+        {
+          fprintf(stderr, "usage: %s [--plugin <lin.xpl>] [--channels N] [--seed N] [--mix <mix>] [--record <sim s>] "
+                          "[--fps N] [--cycles N] [--set <directive>]... [--keep-config <path>] [--verbose] "
+                          "[--soak <sim hours>] [--sample <sim minutes>] [--max-samples N] [--trace <path>] "
+                          "[--check-alloc N] [--slow-rate <s>]\n", argv[0]);
+          return 1;
+        }
+    }
+
+  //
+  // The plugin looks for its conf file two levels above the .xpl it is told it is
+  //
+  filesystem::path top = filesystem::temp_directory_path() / ("rext_bench_" + to_string(getpid()));
+  filesystem::create_directories(top / "64");
+
+  MockReset();
+  MockSetDebugStringHandler(CountLog);
+  MockSetPluginPath((top / "64" / "lin.xpl").string().c_str());
+
+  if ((maxSamples < 0) && (soakHours > 0.0f))
+    {
+      maxSamples = SOAK_DEFAULT_MAX_SAMPLES;       // Recording every frame for hours would not fit otherwise
+    }
+  if (maxSamples > 0)
+    {
+      settings.push_back("$" + to_string(maxSamples));
+    }
+  if (!tracePath.empty())
+    {
+      settings.push_back("@trace65536");
+    }
+
+  sWorkload.Generate(channels, seed, mix);
+  sWorkload.WriteConfig((top / "rextconfig.txt").string(), settings, slowRate);
+  if (!keepConfig.empty())
+    {
+      filesystem::copy_file(top / "rextconfig.txt", keepConfig, filesystem::copy_options::overwrite_existing);
+    }
+
+  unsigned numChannels = (unsigned)sWorkload.NumChannels();
+
+  if (!MockLoadPlugin(pluginPath.c_str()))
+    {
+      filesystem::remove_all(top);
+      return 1;
+    }
+
+  float dt = 1.0f / fps;
+
+  MockSendMessage(XPLM_MSG_PLANE_LOADED, NULL);
+  MockSelectMenuItem("Start Recorder");
+
+  //
+  // Registration happens lazily in the flight loop
+  //
+  for (unsigned i = 0; (i < MAX_REGISTER_TICKS) && (sRegistered < numChannels); i++)
+    {
+      sSimTime += dt;
+      Tick("register", dt, true);
+    }
+  if (sRegistered < numChannels)
+    {
+      fprintf(stderr, "Only %u of %u datarefs registered\n", sRegistered, numChannels);
+    }
+
+  int result = 0;
+
+  if (soakHours > 0.0f)
+    {
+      result = RunSoak(soakHours, sampleMins, dt);
+    }
+  else
+    {
+      RunPhases(recordSecs, dt, fps, cycles);
+    }
+
+  if ((allocTicks > 0) && (result == 0))
+    {
+      result = CheckAllocations(allocTicks, dt);
+    }
+
+  if (soakHours <= 0.0f)
+    {
+      ReportPluginStats();
+    }
+
+  if (!tracePath.empty())
+    {
+      CopyTrace(top, tracePath);
+    }
+
+  MockUnloadPlugin();
+
+  if (soakHours <= 0.0f)
+    {
+      ReportPhases(numChannels);
+    }
+
+  filesystem::remove_all(top);
+  return result;
+}
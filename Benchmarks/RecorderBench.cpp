@@ -0,0 +1,674 @@
+/*
+
+  FILE: RecorderBench.cpp
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Microbenchmarks of the recorder paths: record, sequential replay, seek (with and
+    without a keyframe position), eviction at the sample limit, clear, and byte arrays,
+    over channel counts, history lengths and change rates. One JSON line per case with
+    ns/op, allocs/op and heap bytes per stored sample. The smooth cases record sine
+    gauges step and piecewise linear at the same tolerance and add the worst replay error,
+    the codec cases pack the sealed blocks of the same gauges, and of 0/1 switches, with
+    each block codec. The array cases record 1024 element arrays with a few elements
+    changing per tick whole and sparse, then replay them forwards and backwards checking
+    every array rebuilt.
+
+    usage: rext_recorder_bench [--quick] [--filter <text>]
+
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "ValueRecorder.h"
+#include "DataRecorder.h"
+
+#define TICK_SECONDS            0.01f
+#define MAX_STORED_SAMPLES      20000000    // Skip cases that would need more
+#define MAX_REPLAY_TICKS        1000
+#define NUM_SEEKS               64
+#define KEYFRAME_TICKS          1000        // 10 s, the plugin default
+#define BYTES_PAYLOAD           64
+#define MAX_BYTES_CHANNELS      10000
+#define SMOOTH_TOLERANCE        0.05f
+#define MAX_SMOOTH_CHANNELS     10000
+#define ARRAY_ELEMENTS          1024
+#define ARRAY_CHANGE_SCALE      0.05        // Fraction of a change rate the elements of an array change at
+#define MAX_WHOLE_ARRAY_TICKS   20000       // Arrays x ticks recorded whole, 4 KB each
+
+static const char *sFilter = NULL;
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT BenchCase
+//--------------------------------------------------------------------------------------------------------------------
+struct BenchCase
+{
+  size_t channels;
+  size_t history;         // Recorded ticks
+  double changeRate;      // Fraction of ticks a channel changes on
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// Changes - whether channel c changes on tick t. A cheap hash, not a generator, so it costs nothing in the loop.
+//--------------------------------------------------------------------------------------------------------------------
+static inline bool Changes(size_t t, size_t c, unsigned threshold)
+{
+  uint32_t h = (uint32_t)(t * 2654435761u) ^ (uint32_t)(c * 40503u);
+  h ^= h >> 15;
+  h *= 0x2C1B3C6Du;
+  h ^= h >> 12;
+  return (h % 1000) < threshold;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Report -
+//--------------------------------------------------------------------------------------------------------------------
+static void Report(const char *name, const BenchCase &bc, uint64_t ops, double ns,
+                   const HeapCounters &before, const HeapCounters &after, uint64_t samples = 0)
+{
+  BenchResult result;
+
+  result.Add("bench", name)
+        .Add("channels", (uint64_t)bc.channels)
+        .Add("history", (uint64_t)bc.history)
+        .Add("change_rate", bc.changeRate)
+        .Add("ops", ops)
+        .Add("ns_per_op", ops ? ns / ops : 0.0)
+        .Add("allocs_per_op", ops ? (double)(after.allocs - before.allocs) / ops : 0.0);
+
+  if (samples > 0)
+    {
+      result.Add("samples", samples)
+            .Add("bytes_per_sample", (double)(after.bytesLive - before.bytesLive) / samples);
+    }
+
+  result.Print();
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Wanted -
+//--------------------------------------------------------------------------------------------------------------------
+static bool Wanted(const char *name)
+{
+  return (sFilter == NULL) || (strstr(name, sFilter) != NULL);
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// RecordTicks - record ticks [first, first + count) on every channel, returns the samples stored
+//--------------------------------------------------------------------------------------------------------------------
+static uint64_t RecordTicks(vector<ValueRecorder<float> > &recorders, vector<float> &values,
+                            size_t first, size_t count, unsigned threshold)
+{
+  uint64_t stored = 0;
+
+  for (size_t t = first; t < first + count; t++)
+    {
+      float time = t * TICK_SECONDS;
+
+      for (size_t c = 0; c < recorders.size(); c++)
+        {
+          if (Changes(t, c, threshold))
+            {
+              values[c] += 1.0f;
+            }
+          stored += recorders[c].RecordValue(time, values[c]) ? 1 : 0;
+        }
+    }
+
+  return stored;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// BenchFloat - record, replay, seek and clear on float channels
+//--------------------------------------------------------------------------------------------------------------------
+static void BenchFloat(const BenchCase &bc)
+{
+  unsigned                     threshold = (unsigned)(bc.changeRate * 1000);
+  vector<ValueRecorder<float> > recorders(bc.channels);
+  vector<float>                values(bc.channels, 0.0f);
+  vector<vector<uint64_t> >    keyframes;
+  BenchTimer                   timer;
+  HeapCounters                 before, after;
+  float                        out;
+
+  //
+  // Record from empty. Keyframe capture is kept out of the timing and the heap counts.
+  //
+  HeapCounters recordHeap = { 0, 0, 0 };
+  double       recordNs   = 0.0;
+  uint64_t     stored     = 0;
+  for (size_t t = 0; t < bc.history; t += KEYFRAME_TICKS)
+    {
+      size_t count = min((size_t)KEYFRAME_TICKS, bc.history - t);
+
+      before = GetHeapCounters();
+      timer.Restart();
+      stored += RecordTicks(recorders, values, t, count, threshold);
+      recordNs += timer.ElapsedNs();
+      after = GetHeapCounters();
+
+      recordHeap.allocs    += after.allocs - before.allocs;
+      recordHeap.bytesLive += after.bytesLive - before.bytesLive;
+
+      keyframes.push_back(vector<uint64_t>(bc.channels));
+      for (size_t c = 0; c < bc.channels; c++)
+        {
+          keyframes.back()[c] = recorders[c].LastPosition();
+        }
+    }
+  if (Wanted("record_float"))
+    {
+      HeapCounters zero = { 0, 0, 0 };
+      Report("record_float", bc, (uint64_t)bc.channels * bc.history, recordNs, zero, recordHeap, stored);
+    }
+
+  //
+  // Sequential replay
+  //
+  if (Wanted("replay_float"))
+    {
+      size_t ticks = min(bc.history, (size_t)MAX_REPLAY_TICKS);
+
+      before = GetHeapCounters();
+      timer.Restart();
+      for (size_t t = 0; t < ticks; t++)
+        {
+          for (size_t c = 0; c < bc.channels; c++)
+            {
+              recorders[c].ReplayValue(t * TICK_SECONDS, out);
+            }
+        }
+      double ns = timer.ElapsedNs();
+      after = GetHeapCounters();
+      Report("replay_float", bc, (uint64_t)bc.channels * ticks, ns, before, after);
+    }
+
+  //
+  // Random seeks, from scratch and from the keyframe at or before the target
+  //
+  BenchRandom  random(bc.channels * 31 + bc.history);
+  vector<size_t> seekTicks;
+  for (int i = 0; i < NUM_SEEKS; i++)
+    {
+      seekTicks.push_back((size_t)(random.Uniform() * bc.history));
+    }
+
+  if (Wanted("seek_float"))
+    {
+      before = GetHeapCounters();
+      timer.Restart();
+      for (size_t s = 0; s < seekTicks.size(); s++)
+        {
+          for (size_t c = 0; c < bc.channels; c++)
+            {
+              recorders[c].Reset();
+              recorders[c].ReplayValue(seekTicks[s] * TICK_SECONDS, out);
+            }
+        }
+      double ns = timer.ElapsedNs();
+      after = GetHeapCounters();
+      Report("seek_float", bc, (uint64_t)bc.channels * seekTicks.size(), ns, before, after);
+    }
+
+  if (Wanted("seek_keyframe_float"))
+    {
+      before = GetHeapCounters();
+      timer.Restart();
+      for (size_t s = 0; s < seekTicks.size(); s++)
+        {
+          size_t k = seekTicks[s] / KEYFRAME_TICKS;
+          const vector<uint64_t> *key = (k > 0) ? &keyframes[k - 1] : NULL;
+
+          for (size_t c = 0; c < bc.channels; c++)
+            {
+              recorders[c].Reset();
+              recorders[c].ReplayValue(seekTicks[s] * TICK_SECONDS, out, key ? (*key)[c] : SAMPLE_NO_POSITION);
+            }
+        }
+      double ns = timer.ElapsedNs();
+      after = GetHeapCounters();
+      Report("seek_keyframe_float", bc, (uint64_t)bc.channels * seekTicks.size(), ns, before, after);
+    }
+
+  if (Wanted("clear_float"))
+    {
+      before = GetHeapCounters();
+      timer.Restart();
+      for (size_t c = 0; c < bc.channels; c++)
+        {
+          recorders[c].Clear();
+        }
+      double ns = timer.ElapsedNs();
+      after = GetHeapCounters();
+      Report("clear_float", bc, bc.channels, ns, before, after);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// BenchEvict - steady state recording at the $ sample limit
+//--------------------------------------------------------------------------------------------------------------------
+static void BenchEvict(const BenchCase &bc)
+{
+  if (!Wanted("evict_float"))
+    {
+      return;
+    }
+
+  unsigned threshold = (unsigned)(bc.changeRate * 1000);
+  size_t   limit     = max((size_t)(bc.history * bc.changeRate / 2), (size_t)1);
+
+  vector<ValueRecorder<float> > recorders;
+  recorders.reserve(bc.channels);
+  for (size_t c = 0; c < bc.channels; c++)
+    {
+      recorders.push_back(ValueRecorder<float>(limit, 0.0f));
+    }
+  vector<float> values(bc.channels, 0.0f);
+
+  RecordTicks(recorders, values, 0, bc.history, threshold);     // Fill up to the limit
+
+  HeapCounters before = GetHeapCounters();
+  BenchTimer   timer;
+  RecordTicks(recorders, values, bc.history, bc.history, threshold);
+  double       ns    = timer.ElapsedNs();
+  HeapCounters after = GetHeapCounters();
+
+  Report("evict_float", bc, (uint64_t)bc.channels * bc.history, ns, before, after);
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// BenchBytes - byte array record and replay
+//--------------------------------------------------------------------------------------------------------------------
+static void BenchBytes(const BenchCase &bc)
+{
+  if (!Wanted("bytes") || (bc.channels > MAX_BYTES_CHANNELS))
+    {
+      return;
+    }
+
+  unsigned                 threshold = (unsigned)(bc.changeRate * 1000);
+  vector<DataRecorder>     recorders(bc.channels);
+  vector<vector<uint8_t> > values(bc.channels, vector<uint8_t>(BYTES_PAYLOAD, 0));
+  vector<uint8_t>          out;
+  uint64_t                 stored = 0;
+
+  HeapCounters before = GetHeapCounters();
+  BenchTimer   timer;
+  for (size_t t = 0; t < bc.history; t++)
+    {
+      for (size_t c = 0; c < bc.channels; c++)
+        {
+          if (Changes(t, c, threshold))
+            {
+              values[c][t % BYTES_PAYLOAD]++;
+            }
+          stored += recorders[c].RecordValue(t * TICK_SECONDS, values[c]) ? 1 : 0;
+        }
+    }
+  double       ns    = timer.ElapsedNs();
+  HeapCounters after = GetHeapCounters();
+  Report("record_bytes", bc, (uint64_t)bc.channels * bc.history, ns, before, after, stored);
+
+  size_t ticks = min(bc.history, (size_t)MAX_REPLAY_TICKS);
+  before = GetHeapCounters();
+  timer.Restart();
+  for (size_t t = 0; t < ticks; t++)
+    {
+      for (size_t c = 0; c < bc.channels; c++)
+        {
+          recorders[c].ReplayValue(t * TICK_SECONDS, out);
+        }
+    }
+  ns    = timer.ElapsedNs();
+  after = GetHeapCounters();
+  Report("replay_bytes", bc, (uint64_t)bc.channels * ticks, ns, before, after);
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// SmoothValue - sine gauge of channel c at tick t, periods of 5 to 60 s
+//--------------------------------------------------------------------------------------------------------------------
+static inline float SmoothValue(size_t t, size_t c)
+{
+  return 50.0f * sinf(6.2831853f * (t * TICK_SECONDS) / (5.0f + (float)(c % 56)) + (float)c);
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// BenchSmooth - smooth gauges recorded as steps and as line segments, replayed at every recorded tick
+//--------------------------------------------------------------------------------------------------------------------
+static void BenchSmooth(const BenchCase &bc)
+{
+  if (!Wanted("smooth") || (bc.channels > MAX_SMOOTH_CHANNELS) || (bc.changeRate < 1.0))
+    {
+      return;
+    }
+
+  for (int linear = 0; linear < 2; linear++)
+    {
+      vector<ValueRecorder<float> > recorders;
+      uint64_t                      stored = 0;
+
+      recorders.reserve(bc.channels);
+      for (size_t c = 0; c < bc.channels; c++)
+        {
+          recorders.push_back(ValueRecorder<float>(0, SMOOTH_TOLERANCE));
+          recorders.back().SetLinear(linear != 0);
+        }
+
+      HeapCounters before = GetHeapCounters();
+      BenchTimer   timer;
+      for (size_t t = 0; t < bc.history; t++)
+        {
+          for (size_t c = 0; c < bc.channels; c++)
+            {
+              stored += recorders[c].RecordValue(t * TICK_SECONDS, SmoothValue(t, c)) ? 1 : 0;
+            }
+        }
+      double       ns    = timer.ElapsedNs();
+      HeapCounters after = GetHeapCounters();
+
+      size_t samples = 0;
+      float  maxErr  = 0.0f;
+      float  out     = 0.0f;
+      for (size_t c = 0; c < bc.channels; c++)
+        {
+          samples += recorders[c].NumEventsRecorded();
+          recorders[c].Reset();
+          for (size_t t = 0; t < bc.history; t++)
+            {
+              recorders[c].ReplayValue(t * TICK_SECONDS, out);
+              maxErr = max(maxErr, fabsf(out - SmoothValue(t, c)));
+            }
+        }
+
+      BenchResult result;
+      result.Add("bench", linear ? "record_smooth_linear" : "record_smooth_step")
+            .Add("channels", (uint64_t)bc.channels)
+            .Add("history", (uint64_t)bc.history)
+            .Add("ns_per_op", ns / ((double)bc.channels * bc.history))
+            .Add("samples", (uint64_t)samples)
+            .Add("samples_per_tick", (double)samples / ((double)bc.channels * bc.history))
+            .Add("bytes_per_tick", (double)(after.bytesLive - before.bytesLive) / ((double)bc.channels * bc.history))
+            .Add("tolerance", (double)SMOOTH_TOLERANCE)
+            .Add("max_error", (double)maxErr)
+            .Print();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// SwitchValue - 0/1 switch of channel c at tick t, flipping every 3 to 7 ticks so blocks fill up
+//--------------------------------------------------------------------------------------------------------------------
+static inline int SwitchValue(size_t t, size_t c)
+{
+  return (int)(((t + c) / (3 + c % 5)) & 1);
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// EnumValue - selector of channel c at tick t, one of 5 scattered values, stepping every 2 to 5 ticks
+//--------------------------------------------------------------------------------------------------------------------
+static inline int EnumValue(size_t t, size_t c)
+{
+  static const int positions[] = { 0, 7, 120, -3, 65536 };
+  return positions[((t + c) / (2 + c % 4) * 2654435761u >> 7) % 5];
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// BenchCodecCase - one kind of channel recorded every tick with sealed blocks packed by codec id, then replayed
+//--------------------------------------------------------------------------------------------------------------------
+template <typename T> static void BenchCodecCase(const BenchCase &bc, BlockCodecId id, const char *kind,
+                                                 T (*value)(size_t, size_t))
+{
+  if ((id != kCodecNone) && (id != kCodecAuto) && (GetBlockCodec<T>(id) == NULL))
+    {
+      return;
+    }
+
+  vector<ValueRecorder<T> > recorders;
+  CodecParams               params;
+  size_t                    stored = 0;
+
+  recorders.reserve(bc.channels);
+  for (size_t c = 0; c < bc.channels; c++)
+    {
+      recorders.push_back(ValueRecorder<T>(0, 0));
+      recorders.back().SetBlockCodec(id, params);
+    }
+
+  HeapCounters before = GetHeapCounters();
+  BenchTimer   timer;
+  for (size_t t = 0; t < bc.history; t++)
+    {
+      for (size_t c = 0; c < bc.channels; c++)
+        {
+          stored += recorders[c].RecordValue(t * TICK_SECONDS, value(t, c)) ? 1 : 0;
+        }
+    }
+  double       recordNs = timer.ElapsedNs();
+  HeapCounters after    = GetHeapCounters();
+
+  T     out    = 0;
+  float maxErr = 0.0f;
+  timer.Restart();
+  for (size_t c = 0; c < bc.channels; c++)
+    {
+      for (size_t t = 0; t < bc.history; t++)
+        {
+          recorders[c].ReplayValue(t * TICK_SECONDS, out);
+          maxErr = max(maxErr, fabsf((float)out - (float)value(t, c)));
+        }
+    }
+  double replayNs = timer.ElapsedNs();
+  double ops      = (double)bc.channels * bc.history;
+
+  BenchResult result;
+  string      name = string("codec_") + kind + "_" + BlockCodecName(id);
+  result.Add("bench", name.c_str())
+        .Add("channels", (uint64_t)bc.channels)
+        .Add("history", (uint64_t)bc.history)
+        .Add("record_ns_per_op", recordNs / ops)
+        .Add("replay_ns_per_op", replayNs / ops)
+        .Add("bytes_per_sample", (double)(after.bytesLive - before.bytesLive) / max(stored, (size_t)1))
+        .Add("max_error", (double)maxErr)
+        .Print();
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// BenchCodec - sine gauges, 0/1 switches and enum selectors with each block codec their type has, and auto
+//--------------------------------------------------------------------------------------------------------------------
+static void BenchCodec(const BenchCase &bc)
+{
+  if (!Wanted("codec") || (bc.channels > MAX_SMOOTH_CHANNELS) || (bc.changeRate < 1.0))
+    {
+      return;
+    }
+
+  for (int id = kCodecNone; id < kNumBlockCodecs; id++)
+    {
+      BenchCodecCase<float>(bc, (BlockCodecId)id, "gauge", SmoothValue);
+    }
+  for (int id = kCodecNone; id < kNumBlockCodecs; id++)
+    {
+      BenchCodecCase<int>(bc, (BlockCodecId)id, "switch", SwitchValue);
+    }
+  for (int id = kCodecNone; id < kNumBlockCodecs; id++)
+    {
+      BenchCodecCase<int>(bc, (BlockCodecId)id, "enum", EnumValue);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ReplayArrays - replays ticks [0, ticks) forwards, then backwards, comparing every array with the one recorded.
+//                Returns the mismatches.
+//--------------------------------------------------------------------------------------------------------------------
+static uint64_t ReplayArrays(vector<DataRecorder> &recorders, size_t ticks, unsigned threshold, double &outNs)
+{
+  vector<vector<float> > expected(recorders.size(), vector<float>(ARRAY_ELEMENTS, 0.0f));
+  vector<vector<float> > replayed(recorders.size(), vector<float>(ARRAY_ELEMENTS, 0.0f));
+  vector<uint8_t>        out;
+  uint64_t               mismatches = 0;
+  BenchTimer             timer;
+
+  outNs = 0.0;
+  for (int pass = 0; pass < 2; pass++)
+    {
+      for (size_t step = 0; step < ticks; step++)
+        {
+          size_t t = pass ? ticks - 1 - step : step;
+
+          for (size_t a = 0; a < recorders.size(); a++)
+            {
+              for (size_t e = 0; e < ARRAY_ELEMENTS; e++)
+                {
+                  if (pass == 0)
+                    {
+                      expected[a][e] += Changes(t, a * ARRAY_ELEMENTS + e, threshold) ? 1.0f : 0.0f;
+                    }
+                  else if (step > 0)
+                    {
+                      expected[a][e] -= Changes(t + 1, a * ARRAY_ELEMENTS + e, threshold) ? 1.0f : 0.0f;
+                    }
+                }
+
+              timer.Restart();
+              bool changed = recorders[a].ReplayValue(t * TICK_SECONDS, out);
+              outNs += timer.ElapsedNs();
+
+              if (changed && (out.size() == ARRAY_ELEMENTS * sizeof(float)))
+                {
+                  memcpy(&replayed[a][0], &out[0], out.size());
+                }
+              mismatches += (replayed[a] != expected[a]) ? 1 : 0;
+            }
+        }
+    }
+
+  return mismatches;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// BenchArray - float arrays with a few elements changing per tick, recorded whole and as sparse channels
+//--------------------------------------------------------------------------------------------------------------------
+static void BenchArray(const BenchCase &bc)
+{
+  size_t numArrays = bc.channels / 1000;
+
+  if (!Wanted("array") || (bc.channels > MAX_SMOOTH_CHANNELS) || (numArrays == 0))
+    {
+      return;
+    }
+
+  unsigned threshold = (unsigned)(bc.changeRate * 1000 * ARRAY_CHANGE_SCALE);
+
+  for (int sparse = 0; sparse < 2; sparse++)
+    {
+      if (!sparse && (numArrays * bc.history > MAX_WHOLE_ARRAY_TICKS))
+        {
+          continue;
+        }
+
+      vector<DataRecorder> recorders(numArrays);
+      vector<vector<float> > values(numArrays, vector<float>(ARRAY_ELEMENTS, 0.0f));
+      vector<uint8_t>        bytes(ARRAY_ELEMENTS * sizeof(float));
+
+      for (size_t a = 0; a < numArrays; a++)
+        {
+          recorders[a].SetSparse(sparse ? sizeof(float) : 0);
+        }
+
+      HeapCounters before = GetHeapCounters();
+      BenchTimer   timer;
+      for (size_t t = 0; t < bc.history; t++)
+        {
+          for (size_t a = 0; a < numArrays; a++)
+            {
+              for (size_t e = 0; e < ARRAY_ELEMENTS; e++)
+                {
+                  values[a][e] += Changes(t, a * ARRAY_ELEMENTS + e, threshold) ? 1.0f : 0.0f;
+                }
+              memcpy(&bytes[0], &values[a][0], bytes.size());
+              recorders[a].RecordValue(t * TICK_SECONDS, bytes);
+            }
+        }
+      double       recordNs = timer.ElapsedNs();
+      HeapCounters after    = GetHeapCounters();
+
+      double   replayNs;
+      size_t   ticks      = min(bc.history, (size_t)MAX_REPLAY_TICKS);
+      uint64_t mismatches = ReplayArrays(recorders, ticks, threshold, replayNs);
+      double   ops        = (double)numArrays * bc.history;
+
+      BenchResult result;
+      result.Add("bench", sparse ? "array_sparse" : "array_whole")
+            .Add("arrays", (uint64_t)numArrays)
+            .Add("history", (uint64_t)bc.history)
+            .Add("changed_per_tick", threshold * ARRAY_ELEMENTS / 1000.0)
+            .Add("record_ns_per_array", recordNs / ops)
+            .Add("replay_ns_per_array", replayNs / (2.0 * numArrays * ticks))
+            .Add("bytes_per_tick", (double)(after.bytesLive - before.bytesLive) / ops)
+            .Add("mismatches", mismatches)
+            .Print();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// main -
+//--------------------------------------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  bool quick = false;
+
+  for (int i = 1; i < argc; i++)
+    {
+      if (!strcmp(argv[i], "--quick"))
+        {
+          quick = true;
+        }
+      else if (!strcmp(argv[i], "--filter") && (i + 1 < argc))
+        {
+          sFilter = argv[++i];
+        }
+      else
+        {
+          fprintf(stderr, "usage: %s [--quick] [--filter <text>]\n", argv[0]);
+          return 1;
+        }
+    }
+
+  const size_t channelCounts[] = { 100, 1000, 10000, 100000 };
+  const size_t histories[]     = { 1000, 10000 };
+  const double changeRates[]   = { 0.05, 0.5, 1.0 };
+
+  for (size_t ci = 0; ci < sizeof(channelCounts) / sizeof(channelCounts[0]); ci++)
+    {
+      for (size_t hi = 0; hi < sizeof(histories) / sizeof(histories[0]); hi++)
+        {
+          for (size_t ri = 0; ri < sizeof(changeRates) / sizeof(changeRates[0]); ri++)
+            {
+              BenchCase bc = { channelCounts[ci], histories[hi], changeRates[ri] };
+
+              if (quick && ((bc.channels > 10000) || (bc.history > 1000)))
+                {
+                  continue;
+                }
+              if (bc.channels * bc.history * bc.changeRate > MAX_STORED_SAMPLES)
+                {
+                  continue;
+                }
+
+              BenchFloat(bc);
+              BenchEvict(bc);
+              BenchBytes(bc);
+              BenchSmooth(bc);
+              BenchCodec(bc);
+              BenchArray(bc);
+            }
+        }
+    }
+
+  return 0;
+}
@@ -0,0 +1,357 @@
+/*
+
+  FILE: Workload.cpp
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fstream>
+
+#include "Workload.h"
+
+#define TWO_PI                  6.2831853f
+
+static const char *sBehaviorNames[kNumBehaviors] = { "switch", "enum", "gauge", "sensor", "array", "bytes" };
+
+//--------------------------------------------------------------------------------------------------------------------
+// WorkloadMix - the default is roughly what an airliner cockpit conf file looks like
+//--------------------------------------------------------------------------------------------------------------------
+WorkloadMix::WorkloadMix()
+{
+  percent[kBehaviorSwitch] = 25;
+  percent[kBehaviorEnum]   = 15;
+  percent[kBehaviorGauge]  = 25;
+  percent[kBehaviorSensor] = 10;
+  percent[kBehaviorArray]  = 20;
+  percent[kBehaviorBytes]  = 5;
+  arraySize = 64;
+  bytesSize = 64;
+  numPages  = 8;
+  wholeArrays = false;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Parse -
+//--------------------------------------------------------------------------------------------------------------------
+bool WorkloadMix::Parse(const string &text)
+{
+  size_t start = 0;
+
+  while (start < text.size())
+    {
+      size_t end = text.find(',', start);
+      if (end == string::npos)
+        {
+          end = text.size();
+        }
+
+      string entry = text.substr(start, end - start);
+      size_t eq    = entry.find('=');
+      if (eq == string::npos)
+        {
+          return false;
+        }
+
+      string   key   = entry.substr(0, eq);
+      unsigned value = (unsigned)atoi(entry.c_str() + eq + 1);
+      bool     found = false;
+
+      for (int b = 0; b < kNumBehaviors; b++)
+        {
+          if (key == sBehaviorNames[b])
+            {
+              percent[b] = value;
+              found = true;
+            }
+        }
+
+      if (key == "arraysize")  { arraySize = max(value, 1u); found = true; }
+      if (key == "bytessize")  { bytesSize = max(value, 1u); found = true; }
+      if (key == "pages")      { numPages  = max(value, 1u); found = true; }
+      if (key == "wholearrays") { wholeArrays = (value != 0); found = true; }
+
+      if (!found)
+        {
+          return false;
+        }
+
+      start = end + 1;
+    }
+
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// BehaviorName -
+//--------------------------------------------------------------------------------------------------------------------
+const char *Workload::BehaviorName(WorkloadBehavior behavior)
+{
+  return sBehaviorNames[behavior];
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ScheduleNext - time of the next step for the behaviors that change in steps
+//--------------------------------------------------------------------------------------------------------------------
+void Workload::ScheduleNext(Channel &ch, float time)
+{
+  double u = ch.random.Uniform();
+
+  switch (ch.behavior)
+    {
+      case kBehaviorSwitch: ch.nextChange = time + (float)(30.0 + u * 270.0); break;
+      case kBehaviorEnum:   ch.nextChange = time + (float)(2.0 + u * 18.0);   break;
+      case kBehaviorArray:  ch.nextChange = time + (float)(1.0 + u * 19.0);   break;
+      case kBehaviorBytes:  ch.nextChange = time + (float)(1.0 + u * 9.0);    break;
+      default:              ch.nextChange = 0.0f;                             break;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Generate -
+//--------------------------------------------------------------------------------------------------------------------
+void Workload::Generate(unsigned numChannels, uint64_t seed, const WorkloadMix &mix)
+{
+  m_mix = mix;
+  m_channels.clear();
+  m_pages.clear();
+
+  unsigned totalPercent = 0;
+  for (int b = 0; b < kNumBehaviors; b++)
+    {
+      totalPercent += mix.percent[b];
+    }
+  if (totalPercent == 0)
+    {
+      return;
+    }
+
+  unsigned counts[kNumBehaviors];
+  unsigned assigned = 0;
+  for (int b = 0; b < kNumBehaviors; b++)
+    {
+      counts[b] = (unsigned)((uint64_t)numChannels * mix.percent[b] / totalPercent);
+      assigned += counts[b];
+    }
+  counts[mix.percent[kBehaviorGauge] ? kBehaviorGauge : 0] += numChannels - assigned;
+
+  BenchRandom pageRandom(seed ^ 0x5851F42D4C957F2DULL);
+  for (unsigned p = 0; p < mix.numPages; p++)
+    {
+      m_pages.push_back(vector<uint8_t>(mix.bytesSize));
+      for (unsigned k = 0; k < mix.bytesSize; k++)
+        {
+          m_pages.back()[k] = (uint8_t)(' ' + pageRandom.Next() % 95);
+        }
+    }
+
+  char name[128];
+  for (int b = 0; b < kNumBehaviors; b++)
+    {
+      WorkloadBehavior behavior = (WorkloadBehavior)b;
+      XPLMDataRef      arrayRef = NULL;
+
+      for (unsigned i = 0; i < counts[b]; i++)
+        {
+          Channel ch;
+
+          ch.behavior = behavior;
+          ch.random   = BenchRandom(seed + (m_channels.size() + 1) * 0x9E3779B97F4A7C15ULL);
+          ch.index    = -1;
+          ch.state    = 0;
+
+          switch (behavior)
+            {
+              case kBehaviorSwitch:
+              case kBehaviorEnum:
+              case kBehaviorGauge:
+              case kBehaviorSensor:
+                snprintf(name, sizeof(name), "synth/%s/%u", BehaviorName(behavior), i);
+                ch.name = name;
+                ch.ref  = MockDefineDataRef(name, (b <= kBehaviorEnum) ? xplmType_Int : xplmType_Float, 1, 1);
+                break;
+
+              case kBehaviorArray:
+                if (i % mix.arraySize == 0)
+                  {
+                    snprintf(name, sizeof(name), "synth/array/%u", i / mix.arraySize);
+                    arrayRef = MockDefineDataRef(name, xplmType_FloatArray, mix.arraySize, 1);
+                  }
+                snprintf(name, sizeof(name), "synth/array/%u[%u]", i / mix.arraySize, i % mix.arraySize);
+                ch.name  = name;
+                ch.ref   = arrayRef;
+                ch.index = (int)(i % mix.arraySize);
+                break;
+
+              case kBehaviorBytes:
+                snprintf(name, sizeof(name), "synth/bytes/%u", i);
+                ch.name = name;
+                ch.ref  = MockDefineDataRef(name, xplmType_Data, mix.bytesSize, 1);
+                break;
+
+              default:
+                break;
+            }
+
+          ch.period    = (float)(5.0 + ch.random.Uniform() * 115.0);
+          ch.phase     = (float)(ch.random.Uniform() * TWO_PI);
+          ch.amplitude = (float)(1.0 + ch.random.Uniform() * 99.0);
+          if (behavior == kBehaviorEnum)
+            {
+              ch.amplitude = (float)(3 + ch.random.Next() % 6);        // Number of positions
+            }
+
+          this->ScheduleNext(ch, 0.0f);
+          m_channels.push_back(ch);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// WriteConfig -
+//--------------------------------------------------------------------------------------------------------------------
+bool Workload::WriteConfig(const string &path, const vector<string> &settings, float slowRate) const
+{
+  ofstream conf(path.c_str());
+  if (!conf.is_open())
+    {
+      return false;
+    }
+
+  conf << "#Generated synthetic workload, " << m_channels.size() << " channels\n";
+  for (size_t i = 0; i < settings.size(); i++)
+    {
+      conf << settings[i] << "\n";
+    }
+  bool slow = false;
+  for (size_t i = 0; i < m_channels.size(); i++)
+    {
+      bool slowChannel = (slowRate > 0.0f) && (m_channels[i].behavior <= kBehaviorEnum);
+      if (slowChannel != slow)
+        {
+          conf << "@rate" << (slowChannel ? slowRate : 0.0f) << "\n";
+          slow = slowChannel;
+        }
+      if ((m_channels[i].behavior == kBehaviorArray) && m_mix.wholeArrays)
+        {
+          if (m_channels[i].index == 0)
+            {
+              conf << m_channels[i].name.substr(0, m_channels[i].name.find('[')) << "\n";
+            }
+          continue;
+        }
+      conf << m_channels[i].name << "\n";
+    }
+
+  return conf.good();
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Update -
+//--------------------------------------------------------------------------------------------------------------------
+void Workload::Update(float time)
+{
+  for (size_t i = 0; i < m_channels.size(); i++)
+    {
+      Channel &ch = m_channels[i];
+
+      switch (ch.behavior)
+        {
+          case kBehaviorGauge:
+            MockFloatData(ch.ref)[0] = ch.amplitude * sinf(TWO_PI * time / ch.period + ch.phase);
+            break;
+
+          case kBehaviorSensor:
+            MockFloatData(ch.ref)[0] = ch.amplitude * sinf(TWO_PI * time / ch.period + ch.phase) +
+                                       ch.amplitude * 0.02f * (float)(ch.random.Uniform() - 0.5);
+            break;
+
+          default:
+            if (time < ch.nextChange)
+              {
+                break;
+              }
+
+            switch (ch.behavior)
+              {
+                case kBehaviorSwitch:
+                  ch.state = !ch.state;
+                  MockIntData(ch.ref)[0] = ch.state;
+                  break;
+
+                case kBehaviorEnum:
+                  ch.state = (int)(ch.random.Next() % (uint64_t)ch.amplitude);
+                  MockIntData(ch.ref)[0] = ch.state;
+                  break;
+
+                case kBehaviorArray:
+                  MockFloatData(ch.ref)[ch.index] += (float)((ch.random.Uniform() - 0.5) * ch.amplitude);
+                  break;
+
+                case kBehaviorBytes:
+                  ch.state = (int)(ch.random.Next() % m_pages.size());
+                  memcpy(MockByteData(ch.ref), &m_pages[ch.state][0], m_pages[ch.state].size());
+                  break;
+
+                default:
+                  break;
+              }
+
+            this->ScheduleNext(ch, time);
+            break;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ChannelNames -
+//--------------------------------------------------------------------------------------------------------------------
+void Workload::ChannelNames(XPLMDataTypeID type, vector<string> &outNames) const
+{
+  outNames.clear();
+
+  for (size_t i = 0; i < m_channels.size(); i++)
+    {
+      XPLMDataTypeID recordedAs;
+
+      switch (m_channels[i].behavior)
+        {
+          case kBehaviorSwitch:
+          case kBehaviorEnum:   recordedAs = xplmType_Int;   break;
+          case kBehaviorBytes:  recordedAs = xplmType_Data;  break;
+          case kBehaviorArray:  recordedAs = m_mix.wholeArrays ? xplmType_Data : xplmType_Float; break;
+          default:              recordedAs = xplmType_Float; break;
+        }
+
+      if ((m_channels[i].behavior == kBehaviorArray) && m_mix.wholeArrays)
+        {
+          if ((recordedAs == type) && (m_channels[i].index == 0))
+            {
+              outNames.push_back(m_channels[i].name.substr(0, m_channels[i].name.find('[')));
+            }
+        }
+      else if (recordedAs == type)
+        {
+          outNames.push_back(m_channels[i].name);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// NumChannels -
+//--------------------------------------------------------------------------------------------------------------------
+size_t Workload::NumChannels(WorkloadBehavior behavior) const
+{
+  size_t n = 0;
+  for (size_t i = 0; i < m_channels.size(); i++)
+    {
+      n += (m_channels[i].behavior == behavior) ? 1 : 0;
+    }
+  return n;
+}
@@ -0,0 +1,120 @@
+/*
+
+  FILE: Workload.h
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Synthetic cockpit traffic for the mock XPLM: datarefs that behave like switches,
+    enum selectors, smooth gauges, noisy sensors, wide arrays with a few members moving,
+    and byte strings flipping between a set of pages. Everything comes from the seed,
+    so the same seed and mix give the same datarefs, conf file and values every run.
+
+*/
+
+#ifndef __WORKLOAD__
+#define __WORKLOAD__
+
+//--------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//--------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "XPLMMock.h"
+
+using namespace std;
+
+//--------------------------------------------------------------------------------------------------------------------
+// DEFINES
+//--------------------------------------------------------------------------------------------------------------------
+enum WorkloadBehavior
+{
+  kBehaviorSwitch = 0,    // int 0/1, flips every few minutes
+  kBehaviorEnum,          // int selector stepping every few seconds
+  kBehaviorGauge,         // float, smooth, changes every frame
+  kBehaviorSensor,        // float, gauge plus noise
+  kBehaviorArray,         // float array member, mostly still
+  kBehaviorBytes,         // byte string cycling through pages
+  kNumBehaviors
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT WorkloadMix - percentage of channels per behavior
+//--------------------------------------------------------------------------------------------------------------------
+struct WorkloadMix
+{
+  unsigned percent[kNumBehaviors];
+  unsigned arraySize;
+  unsigned bytesSize;
+  unsigned numPages;
+  bool     wholeArrays;     // Arrays listed without an index, recorded whole
+
+  WorkloadMix();
+
+  // "switch=25,enum=15,gauge=25,sensor=10,array=20,bytes=5", returns false on a bad entry. Also
+  // arraysize=, bytessize=, pages= and wholearrays=1.
+  bool Parse(const string &text);
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS Workload
+//--------------------------------------------------------------------------------------------------------------------
+class Workload
+{
+  protected:
+    struct Channel
+    {
+      string            name;           // As written to the conf file, with [index] for array members
+      WorkloadBehavior  behavior;
+      XPLMDataRef       ref;
+      int               index;
+      BenchRandom       random;
+      float             nextChange;     // Switch, enum, array, bytes
+      float             period;
+      float             phase;
+      float             amplitude;
+      int               state;
+
+      Channel() : random(1) {}
+    };
+
+    vector<Channel>                 m_channels;
+    vector<vector<uint8_t> >        m_pages;
+    WorkloadMix                     m_mix;
+
+    static const char *BehaviorName(WorkloadBehavior behavior);
+    void ScheduleNext(Channel &ch, float time);
+
+  public:
+
+    //-----------------------------------------------------------------------------
+    // Defines the mock datarefs. Call after MockReset.
+    //-----------------------------------------------------------------------------
+    void Generate(unsigned numChannels, uint64_t seed, const WorkloadMix &mix);
+
+    //-----------------------------------------------------------------------------
+    // Conf file listing every channel after the setting lines (@..., $..., %...).
+    // slowRate > 0 puts the switches and enum selectors in an @rate section.
+    //-----------------------------------------------------------------------------
+    bool WriteConfig(const string &path, const vector<string> &settings, float slowRate = 0.0f) const;
+
+    //-----------------------------------------------------------------------------
+    // Sets the dataref values for the sim time of this frame, time must not go back
+    //-----------------------------------------------------------------------------
+    void Update(float time);
+
+    size_t NumChannels() const { return m_channels.size(); }
+    size_t NumChannels(WorkloadBehavior behavior) const;
+
+    //-----------------------------------------------------------------------------
+    // Channels the plugin records as type (xplmType_Float, _Int or _Data) in conf
+    // file order, which is also the order of its per channel rext/stats arrays
+    //-----------------------------------------------------------------------------
+    void ChannelNames(XPLMDataTypeID type, vector<string> &outNames) const;
+};
+
+#endif // __WORKLOAD__
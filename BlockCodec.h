@@ -0,0 +1,732 @@
+/*
+
+  FILE: BlockCodec.h
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Encodings of the values of a sealed sample block. The block store packs the sample
+    times itself, as varint deltas of deltas of their bit patterns, so samples taken
+    every frame cost about a byte of time each, and hands the values to the
+    channel's codec. A codec may refuse a block, e.g. a value outside a declared range,
+    and the block is then packed raw.
+
+    Quant8 and Quant16 store floats as steps of a range, the declared one or the block's
+    own, so the error is at most half a step. With a tolerance set, a block whose steps
+    would exceed it is refused. The recorder passes half the channel's tolerance and
+    records with the other half, the stored values being off by up to that already. Decoding is one multiply-add per sample over a contiguous
+    array, which compilers vectorize.
+
+    Bits stores an int block holding only 0 and 1, switches and annunciators, as one bit
+    per sample. Xor keeps the bytes of each value that differ from the one before, which
+    is little for smooth floats. Rle stores runs of a repeated value. Dict lists the few
+    distinct values of a block, enum selectors or paged byte strings, and indexes them
+    with 1 to 8 bits per sample.
+
+    Auto, the default, has the block store try every lossless codec the type has on each
+    sealed block within a time budget and keep the smallest. Adding a codec to the type's
+    GetBlockCodec makes it a candidate. CodecStats counts what every codec was picked for.
+
+*/
+
+#ifndef __BLOCK_CODEC__
+#define __BLOCK_CODEC__
+
+//--------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//--------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+using namespace std;
+
+//--------------------------------------------------------------------------------------------------------------------
+// DEFINES
+//--------------------------------------------------------------------------------------------------------------------
+enum BlockCodecId
+{
+  kCodecNone = 0,         // Sealed blocks are kept as sample vectors
+  kCodecRaw,
+  kCodecQuant8,
+  kCodecQuant16,
+  kCodecBits,
+  kCodecXor,
+  kCodecRle,
+  kCodecDict,
+  kCodecAuto,             // Not a packing, the block store picks one of the above per block
+  kNumBlockCodecs
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// BlockCodecName / BlockCodecFromName - as written in the conf file, kNumBlockCodecs for an unknown name
+//--------------------------------------------------------------------------------------------------------------------
+inline const char *BlockCodecName(BlockCodecId id)
+{
+  static const char *names[kNumBlockCodecs] = { "none", "raw", "q8", "q16", "bits", "xor", "rle", "dict", "auto" };
+
+  return (id < kNumBlockCodecs) ? names[id] : "unknown";
+}
+
+inline BlockCodecId BlockCodecFromName(const char *name)
+{
+  int id = 0;
+  while ((id < kNumBlockCodecs) && strcmp(name, BlockCodecName((BlockCodecId)id)))
+    {
+      id++;
+    }
+  return (BlockCodecId)id;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT CodecParams - what a channel allows its codec
+//--------------------------------------------------------------------------------------------------------------------
+struct CodecParams
+{
+  float maxError;         // Largest change lossy codecs may make to a value, 0 - half a step
+  float rangeLo;          // Declared value range, rangeLo >= rangeHi - the block's own
+  float rangeHi;
+  float budgetMicros;     // Auto, time to spend trying codecs on a block, 0 tries them all
+
+  CodecParams() : maxError(0.0f), rangeLo(0.0f), rangeHi(0.0f), budgetMicros(0.0f) {}
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT CodecStats - blocks packed by each codec and their sizes before and after, totals since the start
+//--------------------------------------------------------------------------------------------------------------------
+struct CodecStats
+{
+  atomic<uint64_t> blocks[kNumBlockCodecs];
+  atomic<uint64_t> rawBytes[kNumBlockCodecs];
+  atomic<uint64_t> packedBytes[kNumBlockCodecs];
+
+  void Add(BlockCodecId id, size_t raw, size_t packed)
+  {
+    blocks[id].fetch_add(1, memory_order_relaxed);
+    rawBytes[id].fetch_add(raw, memory_order_relaxed);
+    packedBytes[id].fetch_add(packed, memory_order_relaxed);
+  }
+};
+
+inline CodecStats &GetCodecStats()
+{
+  static CodecStats stats;
+  return stats;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Varints, zigzag for signed deltas
+//--------------------------------------------------------------------------------------------------------------------
+inline void PutVarint(vector<uint8_t> &out, uint64_t val)
+{
+  while (val >= 0x80)
+    {
+      out.push_back((uint8_t)(val | 0x80));
+      val >>= 7;
+    }
+  out.push_back((uint8_t)val);
+}
+
+inline uint64_t GetVarint(const uint8_t *&data)
+{
+  uint64_t val   = 0;
+  int      shift = 0;
+
+  while (*data & 0x80)
+    {
+      val |= (uint64_t)(*data++ & 0x7F) << shift;
+      shift += 7;
+    }
+  val |= (uint64_t)(*data++) << shift;
+
+  return val;
+}
+
+inline uint64_t ZigZag(int64_t val)    { return ((uint64_t)val << 1) ^ (uint64_t)(val >> 63); }
+inline int64_t UnZigZag(uint64_t val)  { return (int64_t)(val >> 1) ^ -(int64_t)(val & 1); }
+
+//--------------------------------------------------------------------------------------------------------------------
+// PackTimes / UnpackTimes - increasing positive floats have increasing bit patterns, at a steady frame rate the
+// deltas of those barely change
+//--------------------------------------------------------------------------------------------------------------------
+inline void PackTimes(const vector<float> &times, vector<uint8_t> &out)
+{
+  int64_t prev  = 0;
+  int64_t delta = 0;
+
+  for (size_t i = 0; i < times.size(); i++)
+    {
+      uint32_t bits;
+      memcpy(&bits, &times[i], sizeof(bits));
+      PutVarint(out, ZigZag((int64_t)bits - prev - delta));
+      delta = (int64_t)bits - prev;
+      prev  = bits;
+    }
+}
+
+inline const uint8_t *UnpackTimes(const uint8_t *data, size_t count, vector<float> &outTimes)
+{
+  int64_t prev  = 0;
+  int64_t delta = 0;
+
+  outTimes.resize(count);
+  for (size_t i = 0; i < count; i++)
+    {
+      delta += UnZigZag(GetVarint(data));
+      prev  += delta;
+
+      uint32_t bits = (uint32_t)prev;
+      memcpy(&outTimes[i], &bits, sizeof(bits));
+    }
+
+  return data;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS BlockCodec
+//--------------------------------------------------------------------------------------------------------------------
+template <typename T> class BlockCodec
+{
+  public:
+    virtual ~BlockCodec() {}
+
+    //-----------------------------------------------------------------------------
+    // Appends the encoded values to out, false leaves out as it was
+    //-----------------------------------------------------------------------------
+    virtual bool Encode(const vector<T> &values, const CodecParams &params, vector<uint8_t> &out) const = 0;
+    virtual void Decode(const uint8_t *data, size_t count, vector<T> &outValues) const = 0;
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS RawCodec - values as they are in memory
+//--------------------------------------------------------------------------------------------------------------------
+template <typename T> class RawCodec : public BlockCodec<T>
+{
+  public:
+    virtual bool Encode(const vector<T> &values, const CodecParams &params, vector<uint8_t> &out) const
+    {
+      size_t at = out.size();
+      out.resize(at + values.size() * sizeof(T));
+      if (!values.empty())
+        {
+          memcpy(&out[at], &values[0], values.size() * sizeof(T));
+        }
+      return true;
+    }
+
+    virtual void Decode(const uint8_t *data, size_t count, vector<T> &outValues) const
+    {
+      outValues.resize(count);
+      if (count > 0)
+        {
+          memcpy(&outValues[0], data, count * sizeof(T));
+        }
+    }
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS RawCodec<vector<uint8_t> > - each value length prefixed
+//--------------------------------------------------------------------------------------------------------------------
+template <> class RawCodec<vector<uint8_t> > : public BlockCodec<vector<uint8_t> >
+{
+  public:
+    virtual bool Encode(const vector<vector<uint8_t> > &values, const CodecParams &params, vector<uint8_t> &out) const
+    {
+      for (size_t i = 0; i < values.size(); i++)
+        {
+          PutVarint(out, values[i].size());
+          out.insert(out.end(), values[i].begin(), values[i].end());
+        }
+      return true;
+    }
+
+    virtual void Decode(const uint8_t *data, size_t count, vector<vector<uint8_t> > &outValues) const
+    {
+      outValues.resize(count);
+      for (size_t i = 0; i < count; i++)
+        {
+          size_t length = (size_t)GetVarint(data);
+          outValues[i].assign(data, data + length);
+          data += length;
+        }
+    }
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS QuantCodec - floats as Q (uint8_t or uint16_t) steps from the bottom of the range
+//--------------------------------------------------------------------------------------------------------------------
+template <typename Q> class QuantCodec : public BlockCodec<float>
+{
+  public:
+    virtual bool Encode(const vector<float> &values, const CodecParams &params, vector<uint8_t> &out) const
+    {
+      float lo = params.rangeLo;
+      float hi = params.rangeHi;
+
+      if (values.empty())
+        {
+          return false;
+        }
+      if (lo >= hi)
+        {
+          lo = hi = values[0];
+          for (size_t i = 1; i < values.size(); i++)
+            {
+              lo = min(lo, values[i]);
+              hi = max(hi, values[i]);
+            }
+        }
+      if (!isfinite(lo) || !isfinite(hi))
+        {
+          return false;
+        }
+
+      float levels = (float)(Q)~(Q)0;
+      float step   = (hi - lo) / levels;
+      float limit  = (params.maxError > 0.0f) ? params.maxError : 0.5f * step * 1.0001f;
+
+      size_t at = out.size();
+      out.resize(at + 2 * sizeof(float) + values.size() * sizeof(Q));
+      memcpy(&out[at], &lo, sizeof(float));
+      memcpy(&out[at + sizeof(float)], &step, sizeof(float));
+
+      Q *steps = (Q *)&out[at + 2 * sizeof(float)];
+      for (size_t i = 0; i < values.size(); i++)
+        {
+          float q = (step > 0.0f) ? floorf((values[i] - lo) / step + 0.5f) : 0.0f;
+
+          //
+          // Outside a declared range, or rounding costing more than allowed
+          //
+          if (!(q >= 0.0f) || (q > levels) || !(fabsf(lo + q * step - values[i]) <= limit))
+            {
+              out.resize(at);
+              return false;
+            }
+
+          Q qv = (Q)q;
+          memcpy(steps + i, &qv, sizeof(Q));
+        }
+
+      return true;
+    }
+
+    virtual void Decode(const uint8_t *data, size_t count, vector<float> &outValues) const
+    {
+      float lo, step;
+      memcpy(&lo, data, sizeof(float));
+      memcpy(&step, data + sizeof(float), sizeof(float));
+
+      const Q *steps = (const Q *)(data + 2 * sizeof(float));
+      outValues.resize(count);
+      for (size_t i = 0; i < count; i++)
+        {
+          outValues[i] = lo + (float)steps[i] * step;
+        }
+    }
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS BitsCodec - ints that are all 0 or 1, eight to a byte
+//--------------------------------------------------------------------------------------------------------------------
+class BitsCodec : public BlockCodec<int>
+{
+  public:
+    virtual bool Encode(const vector<int> &values, const CodecParams &params, vector<uint8_t> &out) const
+    {
+      size_t at = out.size();
+      out.resize(at + (values.size() + 7) / 8, 0);
+
+      for (size_t i = 0; i < values.size(); i++)
+        {
+          if (values[i] & ~1)
+            {
+              out.resize(at);
+              return false;
+            }
+          out[at + i / 8] |= (uint8_t)(values[i] << (i % 8));
+        }
+
+      return true;
+    }
+
+    virtual void Decode(const uint8_t *data, size_t count, vector<int> &outValues) const
+    {
+      outValues.resize(count);
+      for (size_t i = 0; i < count; i++)
+        {
+          outValues[i] = (data[i / 8] >> (i % 8)) & 1;
+        }
+    }
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// Bit patterns of 4 byte values, floats and ints
+//--------------------------------------------------------------------------------------------------------------------
+template <typename T> inline uint32_t ValueBits(const T &val)
+{
+  uint32_t bits;
+  memcpy(&bits, &val, sizeof(bits));
+  return bits;
+}
+
+template <typename T> inline T BitsValue(uint32_t bits)
+{
+  T val;
+  memcpy(&val, &bits, sizeof(val));
+  return val;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// PutIndices / GetIndices - indices below 1 << width, width 1, 2, 4 or 8, packed without straddling a byte
+//--------------------------------------------------------------------------------------------------------------------
+inline void PutIndices(const vector<uint8_t> &indices, int width, vector<uint8_t> &out)
+{
+  size_t at = out.size();
+  out.resize(at + (indices.size() * width + 7) / 8, 0);
+
+  for (size_t i = 0; i < indices.size(); i++)
+    {
+      out[at + i * width / 8] |= (uint8_t)(indices[i] << (i * width % 8));
+    }
+}
+
+inline uint8_t GetIndex(const uint8_t *data, size_t i, int width)
+{
+  return (uint8_t)((data[i * width / 8] >> (i * width % 8)) & ((1 << width) - 1));
+}
+
+inline int IndexWidth(size_t numEntries)
+{
+  return (numEntries <= 2) ? 1 : (numEntries <= 4) ? 2 : (numEntries <= 16) ? 4 : 8;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS XorCodec - each 4 byte value xor the one before, as a nibble with the count of low bytes kept and those bytes
+//--------------------------------------------------------------------------------------------------------------------
+template <typename T> class XorCodec : public BlockCodec<T>
+{
+  public:
+    virtual bool Encode(const vector<T> &values, const CodecParams &params, vector<uint8_t> &out) const
+    {
+      size_t   control = out.size();
+      uint32_t prev    = 0;
+
+      out.resize(control + (values.size() + 1) / 2, 0);
+      for (size_t i = 0; i < values.size(); i++)
+        {
+          uint32_t bits = ValueBits(values[i]);
+          uint32_t x    = bits ^ prev;
+          int      n    = 0;
+
+          while ((n < 4) && (x >> (8 * n)))
+            {
+              out.push_back((uint8_t)(x >> (8 * n)));
+              n++;
+            }
+          out[control + i / 2] |= (uint8_t)(n << (4 * (i % 2)));
+          prev = bits;
+        }
+
+      return true;
+    }
+
+    virtual void Decode(const uint8_t *data, size_t count, vector<T> &outValues) const
+    {
+      const uint8_t *bytes = data + (count + 1) / 2;
+      uint32_t       prev  = 0;
+
+      outValues.resize(count);
+      for (size_t i = 0; i < count; i++)
+        {
+          int      n = (data[i / 2] >> (4 * (i % 2))) & 0xF;
+          uint32_t x = 0;
+
+          for (int b = 0; b < n; b++)
+            {
+              x |= (uint32_t)*bytes++ << (8 * b);
+            }
+          prev ^= x;
+          outValues[i] = BitsValue<T>(prev);
+        }
+    }
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS RleCodec - runs of one 4 byte value, as the varint run length less one and the value
+//--------------------------------------------------------------------------------------------------------------------
+template <typename T> class RleCodec : public BlockCodec<T>
+{
+  public:
+    virtual bool Encode(const vector<T> &values, const CodecParams &params, vector<uint8_t> &out) const
+    {
+      size_t i = 0;
+
+      while (i < values.size())
+        {
+          uint32_t bits = ValueBits(values[i]);
+          size_t   run  = 1;
+
+          while ((i + run < values.size()) && (ValueBits(values[i + run]) == bits))
+            {
+              run++;
+            }
+
+          PutVarint(out, run - 1);
+          out.insert(out.end(), (const uint8_t *)&bits, (const uint8_t *)&bits + sizeof(bits));
+          i += run;
+        }
+
+      return true;
+    }
+
+    virtual void Decode(const uint8_t *data, size_t count, vector<T> &outValues) const
+    {
+      outValues.resize(count);
+      for (size_t i = 0; i < count; )
+        {
+          size_t   run = (size_t)GetVarint(data) + 1;
+          uint32_t bits;
+
+          memcpy(&bits, data, sizeof(bits));
+          data += sizeof(bits);
+
+          fill(outValues.begin() + i, outValues.begin() + min(i + run, count), BitsValue<T>(bits));
+          i += run;
+        }
+    }
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS DictCodec - up to 256 distinct 4 byte values: their count less one, the values, then the indices
+//--------------------------------------------------------------------------------------------------------------------
+template <typename T> class DictCodec : public BlockCodec<T>
+{
+  public:
+    virtual bool Encode(const vector<T> &values, const CodecParams &params, vector<uint8_t> &out) const
+    {
+      static thread_local vector<uint8_t> indices;
+      uint32_t slots[512];                  // Open addressing on the bit pattern, entry index + 1 beside it
+      uint16_t slotIndex[512] = { 0 };
+      vector<uint32_t> entries;
+
+      indices.resize(values.size());
+      for (size_t i = 0; i < values.size(); i++)
+        {
+          uint32_t bits = ValueBits(values[i]);
+          size_t   slot = (bits * 2654435761u) >> 23;
+
+          while (slotIndex[slot] && (slots[slot] != bits))
+            {
+              slot = (slot + 1) & 511;
+            }
+          if (!slotIndex[slot])
+            {
+              if (entries.size() == 256)
+                {
+                  return false;
+                }
+              entries.push_back(bits);
+              slots[slot]     = bits;
+              slotIndex[slot] = (uint16_t)entries.size();
+            }
+          indices[i] = (uint8_t)(slotIndex[slot] - 1);
+        }
+      if (entries.empty())
+        {
+          return false;
+        }
+
+      out.push_back((uint8_t)(entries.size() - 1));
+      out.insert(out.end(), (const uint8_t *)&entries[0], (const uint8_t *)&entries[0] + entries.size() * sizeof(uint32_t));
+      PutIndices(indices, IndexWidth(entries.size()), out);
+      return true;
+    }
+
+    virtual void Decode(const uint8_t *data, size_t count, vector<T> &outValues) const
+    {
+      size_t         numEntries = (size_t)data[0] + 1;
+      const uint8_t *entries    = data + 1;
+      const uint8_t *indices    = entries + numEntries * sizeof(uint32_t);
+      int            width      = IndexWidth(numEntries);
+
+      outValues.resize(count);
+      for (size_t i = 0; i < count; i++)
+        {
+          memcpy(&outValues[i], entries + GetIndex(indices, i, width) * sizeof(uint32_t), sizeof(uint32_t));
+        }
+    }
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS DictCodec<vector<uint8_t> > - up to 256 distinct byte strings, each length prefixed, then the indices
+//--------------------------------------------------------------------------------------------------------------------
+template <> class DictCodec<vector<uint8_t> > : public BlockCodec<vector<uint8_t> >
+{
+  public:
+    virtual bool Encode(const vector<vector<uint8_t> > &values, const CodecParams &params, vector<uint8_t> &out) const
+    {
+      static thread_local vector<uint8_t> indices;
+      vector<size_t> entries;               // Index of the first value holding each entry
+
+      indices.resize(values.size());
+      for (size_t i = 0; i < values.size(); i++)
+        {
+          size_t e = 0;
+          while ((e < entries.size()) && (values[entries[e]] != values[i]))
+            {
+              e++;
+            }
+          if (e == entries.size())
+            {
+              if ((entries.size() == 256) || (entries.size() > values.size() / 2))
+                {
+                  return false;
+                }
+              entries.push_back(i);
+            }
+          indices[i] = (uint8_t)e;
+        }
+      if (entries.empty())
+        {
+          return false;
+        }
+
+      out.push_back((uint8_t)(entries.size() - 1));
+      for (size_t e = 0; e < entries.size(); e++)
+        {
+          const vector<uint8_t> &entry = values[entries[e]];
+          PutVarint(out, entry.size());
+          out.insert(out.end(), entry.begin(), entry.end());
+        }
+      PutIndices(indices, IndexWidth(entries.size()), out);
+      return true;
+    }
+
+    virtual void Decode(const uint8_t *data, size_t count, vector<vector<uint8_t> > &outValues) const
+    {
+      size_t                   numEntries = (size_t)*data++ + 1;
+      vector<const uint8_t *>  starts(numEntries);
+      vector<size_t>           lengths(numEntries);
+
+      for (size_t e = 0; e < numEntries; e++)
+        {
+          lengths[e] = (size_t)GetVarint(data);
+          starts[e]  = data;
+          data += lengths[e];
+        }
+
+      int width = IndexWidth(numEntries);
+      outValues.resize(count);
+      for (size_t i = 0; i < count; i++)
+        {
+          uint8_t e = GetIndex(data, i, width);
+          outValues[i].assign(starts[e], starts[e] + lengths[e]);
+        }
+    }
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// GetBlockCodec - the codec for values of type T, NULL if there is none. Floats and ints share the 4 byte codecs.
+//--------------------------------------------------------------------------------------------------------------------
+template <typename T> inline const BlockCodec<T> *GetBlockCodec(BlockCodecId id)
+{
+  static const RawCodec<T>  raw;
+  static const XorCodec<T>  xorCodec;
+  static const RleCodec<T>  rle;
+  static const DictCodec<T> dict;
+
+  switch (id)
+    {
+      case kCodecRaw:     return &raw;
+      case kCodecXor:     return &xorCodec;
+      case kCodecRle:     return &rle;
+      case kCodecDict:    return &dict;
+      default:            return NULL;
+    }
+}
+
+template <> inline const BlockCodec<float> *GetBlockCodec<float>(BlockCodecId id)
+{
+  static const QuantCodec<uint8_t>  quant8;
+  static const QuantCodec<uint16_t> quant16;
+  static const RawCodec<float>      raw;
+  static const XorCodec<float>      xorCodec;
+  static const RleCodec<float>      rle;
+  static const DictCodec<float>     dict;
+
+  switch (id)
+    {
+      case kCodecRaw:     return &raw;
+      case kCodecQuant8:  return &quant8;
+      case kCodecQuant16: return &quant16;
+      case kCodecXor:     return &xorCodec;
+      case kCodecRle:     return &rle;
+      case kCodecDict:    return &dict;
+      default:            return NULL;
+    }
+}
+
+template <> inline const BlockCodec<int> *GetBlockCodec<int>(BlockCodecId id)
+{
+  static const RawCodec<int>  raw;
+  static const BitsCodec      bits;
+  static const XorCodec<int>  xorCodec;
+  static const RleCodec<int>  rle;
+  static const DictCodec<int> dict;
+
+  switch (id)
+    {
+      case kCodecRaw:     return &raw;
+      case kCodecBits:    return &bits;
+      case kCodecXor:     return &xorCodec;
+      case kCodecRle:     return &rle;
+      case kCodecDict:    return &dict;
+      default:            return NULL;
+    }
+}
+
+template <> inline const BlockCodec<vector<uint8_t> > *GetBlockCodec<vector<uint8_t> >(BlockCodecId id)
+{
+  static const RawCodec<vector<uint8_t> >  raw;
+  static const DictCodec<vector<uint8_t> > dict;
+
+  switch (id)
+    {
+      case kCodecRaw:     return &raw;
+      case kCodecDict:    return &dict;
+      default:            return NULL;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// IsAutoCandidate - codecs auto may pick for type T, the lossy ones only ever when named
+//--------------------------------------------------------------------------------------------------------------------
+template <typename T> inline bool IsAutoCandidate(BlockCodecId id)
+{
+  return (id != kCodecQuant8) && (id != kCodecQuant16) && (GetBlockCodec<T>(id) != NULL);
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// RawValueBytes - size of a block of values unpacked, what the codec stats compare against
+//--------------------------------------------------------------------------------------------------------------------
+template <typename T> inline size_t RawValueBytes(const vector<T> &values)
+{
+  return values.size() * sizeof(T);
+}
+
+inline size_t RawValueBytes(const vector<vector<uint8_t> > &values)
+{
+  size_t bytes = 0;
+  for (size_t i = 0; i < values.size(); i++)
+    {
+      bytes += values[i].size();
+    }
+  return bytes;
+}
+
+#endif // __BLOCK_CODEC__
@@ -1,181 +1,396 @@
-#ifndef __DATA_RECORDER__
-#define __DATA_RECORDER__
-
-//--------------------------------------------------------------------------------------------------------------------
-// INCLUDES
-//--------------------------------------------------------------------------------------------------------------------
-#include <map>
-#include <vector>
-
-using namespace std;
-
-//--------------------------------------------------------------------------------------------------------------------
-// CLASS DataRecorder
-//--------------------------------------------------------------------------------------------------------------------
-class DataRecorder
-{
-  protected:
-    typename std::map <float, vector<uint8_t> > m_record;
-    bool                         m_lastReplayValid;
-    vector<uint8_t>              m_lastReplayVal;
-    size_t                       m_maxReplayCount;
-
-  public:
-
-    //-----------------------------------------------------------------------------
-    DataRecorder(size_t maxReplayCount = 0)
-    {
-      //m_lastReplayVal      = {};
-      m_lastReplayValid    = false;
-      m_maxReplayCount     = maxReplayCount;
-    }
-
-    //-----------------------------------------------------------------------------
-    bool GetLastRecordedValue( vector<uint8_t> &outVal)
-    {
-      typename map <float,  vector<uint8_t> >::reverse_iterator iter = m_record.rbegin();
-      if (iter != m_record.rend())
-        {
-          outVal = (*iter).second;
-          return true;
-        }
-      else
-        {
-          return false;
-        }
-    }
-
-    //-----------------------------------------------------------------------------
-    void RecordValue(float elapsedTime,  vector<uint8_t> val)
-    {
-      if (!m_record.empty())
-        {
-          typename map <float,  vector<uint8_t> >::reverse_iterator iter = m_record.rbegin();
-          if (iter != m_record.rend())
-            {
-               vector<uint8_t> lastVal = (*iter).second;
-
-              if (val != lastVal){
-                  m_record[elapsedTime] = val;
-                }
-            }
-        }
-      else
-        {
-          m_record[elapsedTime] = val;
-          m_lastReplayVal.clear();
-          m_lastReplayValid = false;
-        }
-
-      if (m_maxReplayCount > 0)
-        {
-          while (m_record.size() > m_maxReplayCount)
-            {
-              typename map <float,  vector<uint8_t> >::iterator iter = m_record.begin();
-              if (iter != m_record.end())
-                {
-                  m_record.erase(iter);
-                }
-              else
-                break;
-            }
-        }
-    }
-
-    //-----------------------------------------------------------------------------
-    bool ReplayValue(float elapsedTime,  vector<uint8_t> &outVal)
-    {
-      bool changed = false;
-
-      //
-      // If elapsed time is greater than or equal to the elapsed time for the last value, use the last value
-      //
-      typename map <float,  vector<uint8_t> >::reverse_iterator revIter = m_record.rbegin();
-      if ((revIter != m_record.rend()) && (elapsedTime >= (*revIter).first))
-        {
-           vector<uint8_t> val = (*revIter).second;
-          if ((!m_lastReplayValid) || (val != m_lastReplayVal))
-            {
-              changed = true;
-              outVal = val;
-              m_lastReplayVal = outVal;
-              m_lastReplayValid = true;
-            }
-        }
-
-      if (!changed)
-        {
-          //
-          // If the elapsed time is less than or equal to elapsed time for the first value, use the first value
-          //
-          typename map <float,  vector<uint8_t> >::iterator iter = m_record.begin();
-          if ((iter != m_record.end()) && (elapsedTime <= (*iter).first))
-            {
-               vector<uint8_t> val = (*iter).second;
-              if ((!m_lastReplayValid) || (val != m_lastReplayVal))
-                {
-                  changed = true;
-                  outVal = val;
-                  m_lastReplayVal = val;
-                  m_lastReplayValid = true;
-                }
-            }
-        }
-
-      if (!changed)
-        {
-          //
-          // Find the corresponding elapsed time somewhere in the middle
-          //
-          typename map <float,  vector<uint8_t> >::iterator iter = m_record.lower_bound(elapsedTime);
-          if (iter != m_record.end())
-            {
-              if (iter != m_record.begin())
-                {
-                  if ((*iter).first > elapsedTime)
-                    {
-                      iter--;  // Find the one at the same time or before
-                    }
-
-                  if (elapsedTime >= (*iter).first)
-                    {
-                       vector<uint8_t> val = (*iter).second;
-
-                      if ((!m_lastReplayValid) || (val != m_lastReplayVal))
-                        {
-                          changed = true;
-                          outVal = val;
-                          m_lastReplayVal = val;
-                          m_lastReplayValid = true;
-                        }
-                    }
-                }
-            }
-        }
-
-      return changed;
-    }
-
-    //-----------------------------------------------------------------------------
-    void Reset()
-    {
-      m_lastReplayVal.clear();
-      m_lastReplayValid = false;
-    }
-
-    //-----------------------------------------------------------------------------
-    void Clear()
-    {
-      m_record.clear();
-      this->Reset();
-    }
-
-    //-----------------------------------------------------------------------------
-    size_t NumEventsRecorded()
-    {
-      return m_record.size();
-    }
-};
-
-
-#endif // __DATA_RECORDER__
+#ifndef __DATA_RECORDER__
+#define __DATA_RECORDER__
+
+//--------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//--------------------------------------------------------------------------------------------------------------------
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <stdint.h>
+#include <string.h>
+
+#include "SampleBlockStore.h"
+
+using namespace std;
+
+//--------------------------------------------------------------------------------------------------------------------
+// DEFINES
+//--------------------------------------------------------------------------------------------------------------------
+#define SPARSE_SNAPSHOT_SAMPLES     256     // Sparse channels store the whole array at least every this many changes,
+#define SPARSE_SNAPSHOT_RATIO       4       // or once the changes since the last one add up to this many arrays
+#define SPARSE_RUN_GAP              4       // Unchanged elements a run of changes may bridge
+
+//
+// First byte of a sparse channel sample. A delta is then (varint elements skipped, varint elements, the elements)
+// per run of changed elements.
+//
+enum SparseSampleKind
+{
+  kSparseSnapshot = 0,
+  kSparseDelta    = 1
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS DataRecorder
+//--------------------------------------------------------------------------------------------------------------------
+class DataRecorder
+{
+  protected:
+    SampleBlockStore<vector<uint8_t> > m_record;
+    bool                         m_lastReplayValid;
+    vector<uint8_t>              m_lastReplayVal;
+    size_t                       m_maxReplayCount;
+    float                        m_maxReplaySeconds;
+    uint32_t                     m_channelId;
+    size_t                       m_sparseElement;    // Element size of a sparse array channel, 0 stores whole values
+    vector<uint8_t>              m_sparseCurrent;    // Newest recorded array
+    vector<uint8_t>              m_sparseSample;
+    deque<uint64_t>              m_snapshots;        // Positions of the whole arrays stored
+    size_t                       m_sinceSnapshot;
+    size_t                       m_deltaBytes;       // Stored since the last whole array
+    uint64_t                     m_replayPos;        // Position m_lastReplayVal was rebuilt from
+
+    //-----------------------------------------------------------------------------
+    // Runs of elements of val differing from prev, prev being as long as val
+    //-----------------------------------------------------------------------------
+    void EncodeDelta(const vector<uint8_t> &prev, const vector<uint8_t> &val, vector<uint8_t> &out) const
+    {
+      size_t numElements = val.size() / m_sparseElement;
+      size_t end         = 0;           // Element after the previous run
+      size_t i           = 0;
+
+      out.assign(1, (uint8_t)kSparseDelta);
+      while (i < numElements)
+        {
+          if (!memcmp(&prev[i * m_sparseElement], &val[i * m_sparseElement], m_sparseElement))
+            {
+              i++;
+              continue;
+            }
+
+          size_t first = i;
+          size_t last  = i;
+          for (i++; (i < numElements) && (i - last <= SPARSE_RUN_GAP); i++)
+            {
+              if (memcmp(&prev[i * m_sparseElement], &val[i * m_sparseElement], m_sparseElement))
+                {
+                  last = i;
+                }
+            }
+
+          PutVarint(out, first - end);
+          PutVarint(out, last + 1 - first);
+          out.insert(out.end(), val.begin() + first * m_sparseElement, val.begin() + (last + 1) * m_sparseElement);
+          end = i = last + 1;
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    void ApplySparse(const vector<uint8_t> &sample, vector<uint8_t> &ioVal) const
+    {
+      if (sample.empty() || (sample[0] == kSparseSnapshot))
+        {
+          ioVal.assign(sample.begin() + (sample.empty() ? 0 : 1), sample.end());
+          return;
+        }
+
+      const uint8_t *data   = &sample[1];
+      const uint8_t *end    = &sample[0] + sample.size();
+      size_t         offset = 0;
+
+      while (data < end)
+        {
+          offset += (size_t)GetVarint(data) * m_sparseElement;
+          size_t length = (size_t)GetVarint(data) * m_sparseElement;
+
+          if (offset + length <= ioVal.size())
+            {
+              memcpy(&ioVal[offset], data, length);
+            }
+          data   += length;
+          offset += length;
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    // Deltas need the whole array before them, eviction stops at the last one
+    // stored at or before the oldest sample the limits keep
+    //-----------------------------------------------------------------------------
+    void TrimSparse(float elapsedTime)
+    {
+      uint64_t keepFrom = m_record.BeginPosition();
+
+      if ((m_maxReplayCount > 0) && (m_record.Size() > m_maxReplayCount))
+        {
+          keepFrom = m_record.EndPosition() - m_maxReplayCount;
+        }
+      if (m_maxReplaySeconds > 0.0f)
+        {
+          keepFrom = max(keepFrom, m_record.FindPosition(elapsedTime - m_maxReplaySeconds));
+        }
+
+      deque<uint64_t>::iterator iter = upper_bound(m_snapshots.begin(), m_snapshots.end(), keepFrom);
+      if (iter == m_snapshots.begin())
+        {
+          return;
+        }
+
+      m_snapshots.erase(m_snapshots.begin(), iter - 1);
+      if (m_snapshots.front() > m_record.BeginPosition())
+        {
+          m_record.Trim((size_t)(m_record.EndPosition() - m_snapshots.front()));
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    bool RecordSparse(float elapsedTime, const vector<uint8_t> &val)
+    {
+      bool rewound = !m_record.Empty() && (elapsedTime <= m_record.LastTime());
+
+      if (!m_record.Empty() && !rewound && (val == m_sparseCurrent))
+        {
+          this->TrimSparse(elapsedTime);
+          return false;
+        }
+
+      bool snapshot = m_record.Empty() || rewound || (val.size() != m_sparseCurrent.size()) ||
+                      (m_sinceSnapshot >= SPARSE_SNAPSHOT_SAMPLES) ||
+                      (m_deltaBytes >= SPARSE_SNAPSHOT_RATIO * val.size());
+      if (!snapshot)
+        {
+          this->EncodeDelta(m_sparseCurrent, val, m_sparseSample);
+          snapshot = (m_sparseSample.size() > val.size() / 2);
+        }
+      if (snapshot)
+        {
+          m_sparseSample.assign(1, (uint8_t)kSparseSnapshot);
+          m_sparseSample.insert(m_sparseSample.end(), val.begin(), val.end());
+        }
+
+      m_record.Append(elapsedTime, m_sparseSample);
+      while (!m_snapshots.empty() && (m_snapshots.back() >= m_record.EndPosition() - 1))
+        {
+          m_snapshots.pop_back();
+        }
+      if (snapshot)
+        {
+          m_snapshots.push_back(m_record.EndPosition() - 1);
+          m_sinceSnapshot = 0;
+          m_deltaBytes    = 0;
+        }
+      else
+        {
+          m_sinceSnapshot++;
+          m_deltaBytes += m_sparseSample.size();
+        }
+      m_sparseCurrent = val;
+
+      this->TrimSparse(elapsedTime);
+      return true;
+    }
+
+    //-----------------------------------------------------------------------------
+    // Rebuilds the array at time, stepping on from the last replayed one when close
+    // enough and from the whole array stored before it otherwise
+    //-----------------------------------------------------------------------------
+    bool ReplaySparse(float elapsedTime, vector<uint8_t> &outVal, uint64_t fromPos)
+    {
+      uint64_t pos = m_record.FindPosition(elapsedTime, fromPos);
+
+      if ((pos == SAMPLE_NO_POSITION) || (m_lastReplayValid && (pos == m_replayPos)))
+        {
+          return false;
+        }
+
+      uint64_t from;
+      if (m_lastReplayValid && (pos > m_replayPos) && (m_replayPos >= m_record.BeginPosition()) &&
+          (pos - m_replayPos <= SPARSE_SNAPSHOT_SAMPLES))
+        {
+          from = m_replayPos + 1;
+        }
+      else
+        {
+          deque<uint64_t>::iterator iter = upper_bound(m_snapshots.begin(), m_snapshots.end(), pos);
+          from = (iter == m_snapshots.begin()) ? m_record.BeginPosition() : *(iter - 1);
+        }
+
+      for (; from <= pos; from++)
+        {
+          this->ApplySparse(m_record.ValueAt(from), m_lastReplayVal);
+        }
+
+      m_replayPos       = pos;
+      m_lastReplayValid = true;
+      outVal            = m_lastReplayVal;
+      return true;
+    }
+
+  public:
+
+    //-----------------------------------------------------------------------------
+    DataRecorder(size_t maxReplayCount = 0)
+    {
+      //m_lastReplayVal      = {};
+      m_lastReplayValid    = false;
+      m_maxReplayCount     = maxReplayCount;
+      m_maxReplaySeconds   = 0.0f;
+      m_channelId          = 0;
+      m_sparseElement      = 0;
+      m_sinceSnapshot      = 0;
+      m_deltaBytes         = 0;
+      m_replayPos          = SAMPLE_NO_POSITION;
+    }
+
+    //-----------------------------------------------------------------------------
+    uint32_t GetChannelId() { return m_channelId; }
+    void SetChannelId(uint32_t channelId) { m_channelId = channelId; }
+
+    //-----------------------------------------------------------------------------
+    // History kept besides the sample count, in seconds before the newest sample, 0 keeps all
+    //-----------------------------------------------------------------------------
+    void SetMaxReplaySeconds(float seconds) { m_maxReplaySeconds = seconds; }
+
+    //-----------------------------------------------------------------------------
+    // Packing of the sealed history, see BlockCodec.h
+    //-----------------------------------------------------------------------------
+    void SetBlockCodec(BlockCodecId codec, const CodecParams &params) { m_record.SetCodec(codec, params); }
+
+    //-----------------------------------------------------------------------------
+    // Sparse array channel: values are arrays of elementSize byte elements, stored
+    // as the runs of elements that changed with the whole array now and then
+    //-----------------------------------------------------------------------------
+    void SetSparse(size_t elementSize) { m_sparseElement = elementSize; }
+    bool IsSparse() const { return m_sparseElement > 0; }
+
+    //-----------------------------------------------------------------------------
+    // Position of the newest sample, for keyframes
+    //-----------------------------------------------------------------------------
+    uint64_t LastPosition()
+    {
+      return m_record.Empty() ? SAMPLE_NO_POSITION : (m_record.EndPosition() - 1);
+    }
+
+    //-----------------------------------------------------------------------------
+    bool GetLastRecordedValue( vector<uint8_t> &outVal)
+    {
+      if (m_sparseElement > 0)
+        {
+          outVal = m_sparseCurrent;
+          return !m_record.Empty();
+        }
+
+      const vector<uint8_t> *last = m_record.Last();
+      if (last != NULL)
+        {
+          outVal = *last;
+          return true;
+        }
+      else
+        {
+          return false;
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    bool RecordValue(float elapsedTime, const vector<uint8_t> &val)
+    {
+      bool stored = false;
+
+      if (m_sparseElement > 0)
+        {
+          return this->RecordSparse(elapsedTime, val);
+        }
+
+      const vector<uint8_t> *last = m_record.Last();
+      if (last != NULL)
+        {
+          if (val != *last){
+              m_record.Append(elapsedTime, val);
+              stored = true;
+            }
+        }
+      else
+        {
+          m_record.Append(elapsedTime, val);
+          m_lastReplayVal.clear();
+          m_lastReplayValid = false;
+          stored = true;
+        }
+
+      if (m_maxReplayCount > 0)
+        {
+          m_record.Trim(m_maxReplayCount);
+        }
+      if (m_maxReplaySeconds > 0.0f)
+        {
+          m_record.TrimBefore(elapsedTime - m_maxReplaySeconds);
+        }
+
+      return stored;
+    }
+
+    //-----------------------------------------------------------------------------
+    bool ReplayValue(float elapsedTime,  vector<uint8_t> &outVal, uint64_t fromPos = SAMPLE_NO_POSITION)
+    {
+      bool changed = false;
+
+      if (m_sparseElement > 0)
+        {
+          return this->ReplaySparse(elapsedTime, outVal, fromPos);
+        }
+
+      //
+      // Use the value recorded at or before the elapsed time, or the first one if there is none.
+      // A keyframe position lets the lookup start close to the answer.
+      //
+      const vector<uint8_t> *val = (fromPos != SAMPLE_NO_POSITION) ? m_record.FindFrom(fromPos, elapsedTime) : m_record.Find(elapsedTime);
+      if (val != NULL)
+        {
+          if ((!m_lastReplayValid) || (*val != m_lastReplayVal))
+            {
+              changed = true;
+              outVal = *val;
+              m_lastReplayVal = outVal;
+              m_lastReplayValid = true;
+            }
+        }
+
+      return changed;
+    }
+
+    //-----------------------------------------------------------------------------
+    void Reset()
+    {
+      m_lastReplayVal.clear();
+      m_lastReplayValid = false;
+      m_replayPos = SAMPLE_NO_POSITION;
+      m_record.ReleaseCache();
+    }
+
+    //-----------------------------------------------------------------------------
+    void Clear()
+    {
+      m_record.Clear();
+      m_snapshots.clear();
+      m_sparseCurrent.clear();
+      m_sinceSnapshot = 0;
+      m_deltaBytes = 0;
+      this->Reset();
+    }
+
+    //-----------------------------------------------------------------------------
+    size_t NumEventsRecorded()
+    {
+      return m_record.Size();
+    }
+
+    //-----------------------------------------------------------------------------
+    size_t StorageBytes()
+    {
+      return m_record.StorageBytes() + m_sparseCurrent.capacity() + m_sparseSample.capacity();
+    }
+};
+
+
+#endif // __DATA_RECORDER__
@@ -1,308 +1,532 @@
-/*
-
-  FILE: DataRefRecorder.h
-
-  BD-5J Plugin for X-Plane 11
-  Copyright © 2018 by Quantumac
-
-  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
-
-*/
-
-#ifndef __DATAREF_RECORDER__
-#define __DATAREF_RECORDER__
-
-//--------------------------------------------------------------------------------------------------------------------
-// INCLUDES
-//--------------------------------------------------------------------------------------------------------------------
-#include "ValueRecorder.h"
-#include "DataRecorder.h"
-#include "XPLMDataAccess.h"
-
-//--------------------------------------------------------------------------------------------------------------------
-// CLASS DataRefRecorder
-//--------------------------------------------------------------------------------------------------------------------
-template <typename T> class DataRefRecorder : public ValueRecorder<T>
-{
-  protected:
-    string       m_dataRefName;
-    XPLMDataRef  m_dataRef;
-    int          m_index;
-    T            m_initVal;
-
-    //-----------------------------------------------------------------------------
-    virtual T GetDataRefValue() = 0;
-    virtual void SetDataRefValue(T val) = 0;
-
-  public:
-
-    //-----------------------------------------------------------------------------
-    DataRefRecorder()
-    {
-      m_dataRef     = NULL;
-      m_index       = -1;
-      m_initVal     = 0;
-    }
-
-    //-----------------------------------------------------------------------------
-    DataRefRecorder(const string &dataRefName,
-                    XPLMDataRef dataRef,
-                    int index = -1,
-                    size_t maxReplayCount = 0,
-                    T recordTolerance = 0,
-                    T initVal = 0) :
-      ValueRecorder<T>(maxReplayCount, recordTolerance)
-    {
-      m_dataRefName = dataRefName;
-      m_dataRef     = dataRef;
-      m_index       = index;
-      m_initVal     = initVal;
-    }
-
-    //-----------------------------------------------------------------------------
-    const char *GetDataRefName() { return m_dataRefName.c_str(); }
-
-    //-----------------------------------------------------------------------------
-    void RecordDataRef(float elapsedTime)
-    {
-      this->RecordValue(elapsedTime, this->GetDataRefValue());
-    }
-
-    //-----------------------------------------------------------------------------
-    void ReplayDataRef(float elapsedTime)
-    {
-      T val;
-
-      if (this->ReplayValue(elapsedTime, val))
-        {
-          this->SetDataRefValue(val);
-        }
-    }
-
-    //-----------------------------------------------------------------------------
-    void RestoreDataRef()
-    {
-      T val;
-
-      if (this->GetLastRecordedValue(val))
-        {
-          this->SetDataRefValue(val);
-        }
-    }
-
-    void Init()
-    {
-      this->Clear();
-      this->RecordValue(0.0, m_initVal);
-    }
-};
-
-//--------------------------------------------------------------------------------------------------------------------
-// CLASS DataRefByteArrRecorder
-//--------------------------------------------------------------------------------------------------------------------
-class DataRefByteArrRecorder : public DataRecorder
-{
-  protected:
-    string       m_dataRefName;
-    XPLMDataRef  m_dataRef;
-    vector<uint8_t>    m_initVal;
-
-    //-----------------------------------------------------------------------------
-    virtual vector<uint8_t> GetDataRefValue() = 0;
-    virtual void SetDataRefValue(vector<uint8_t> val) = 0;
-
-  public:
-
-    //-----------------------------------------------------------------------------
-    DataRefByteArrRecorder()
-    {
-      m_dataRef     = NULL;
-      m_initVal     = vector<uint8_t>();
-    }
-
-    //-----------------------------------------------------------------------------
-    DataRefByteArrRecorder(const string &dataRefName,
-                    XPLMDataRef dataRef,
-                    size_t maxReplayCount = 0,
-                    vector<uint8_t> initVal = vector<uint8_t>()) :
-      DataRecorder(maxReplayCount)
-    {
-      m_dataRefName = dataRefName;
-      m_dataRef     = dataRef;
-      m_initVal     = initVal;
-    }
-
-    //-----------------------------------------------------------------------------
-    const char *GetDataRefName() { return m_dataRefName.c_str(); }
-
-    //-----------------------------------------------------------------------------
-    void RecordDataRef(float elapsedTime)
-    {
-      this->RecordValue(elapsedTime, this->GetDataRefValue());
-    }
-
-    //-----------------------------------------------------------------------------
-    void ReplayDataRef(float elapsedTime)
-    {
-     vector<uint8_t> val;
-
-      if (this->ReplayValue(elapsedTime, val))
-        {
-          this->SetDataRefValue(val);
-        }
-    }
-
-    //-----------------------------------------------------------------------------
-    void RestoreDataRef()
-    {
-      vector<uint8_t> val;
-
-      if (this->GetLastRecordedValue(val))
-        {
-          this->SetDataRefValue(val);
-        }
-    }
-
-    void Init()
-    {
-      this->Clear();
-      this->RecordValue(0.0, m_initVal);
-    }
-};
-
-//--------------------------------------------------------------------------------------------------------------------
-// CLASS ByteArrDataRefRecorder
-//--------------------------------------------------------------------------------------------------------------------
-class ByteArrDataRefRecorder : public DataRefByteArrRecorder
-{
-  protected:
-    //-----------------------------------------------------------------------------
-    virtual vector<uint8_t> GetDataRefValue()
-    {
-        size_t sz = XPLMGetDatab(m_dataRef, NULL, 0, 0);
-
-        char src[sz];
-        vector<uint8_t> val(sz);
-
-        XPLMGetDatab(m_dataRef, &src, 0, sz);
-
-        val.assign(src, src + sz);
-      return val;
-    }
-
-    //-----------------------------------------------------------------------------
-    virtual void SetDataRefValue(vector<uint8_t> val)
-    {
-          XPLMSetDatab(m_dataRef, &val[0], 0, val.size());
-    }
-
-  public:
-    ByteArrDataRefRecorder(const string &dataRefName,
-                        XPLMDataRef dataRef,
-                        size_t maxReplayCount = 0,
-                        vector<uint8_t> initVal = vector<uint8_t>()) :
-    DataRefByteArrRecorder(dataRefName, dataRef, maxReplayCount, initVal)
-    {
-    }
-
-};
-
-//--------------------------------------------------------------------------------------------------------------------
-// CLASS FloatDataRefRecorder
-//--------------------------------------------------------------------------------------------------------------------
-class FloatDataRefRecorder : public DataRefRecorder<float>
-{
-  protected:
-
-    //-----------------------------------------------------------------------------
-    virtual float GetDataRefValue()
-    {
-      float val;
-
-      if (m_index >= 0)
-        {
-          XPLMGetDatavf(m_dataRef, &val, m_index, 1);
-        }
-      else
-        {
-          val = XPLMGetDataf(m_dataRef);
-        }
-
-      return val;
-    }
-
-    //-----------------------------------------------------------------------------
-    virtual void SetDataRefValue(float val)
-    {
-      if (m_index >= 0)
-        {
-          XPLMSetDatavf(m_dataRef, &val, m_index, 1);
-        }
-      else
-        {
-          XPLMSetDataf(m_dataRef, val);
-        }
-    }
-
-  public:
-    FloatDataRefRecorder(const string &dataRefName,
-                          XPLMDataRef dataRef,
-                          int index = -1,
-                          size_t maxReplayCount = 0.0f,
-                          float recordTolerance = 0.0f,
-                          float initVal = 0.0f) :
-    DataRefRecorder<float>(dataRefName, dataRef, index, maxReplayCount, recordTolerance, initVal)
-    {
-    }
-};
-
-//--------------------------------------------------------------------------------------------------------------------
-// CLASS IntDataRefRecorder
-//--------------------------------------------------------------------------------------------------------------------
-class IntDataRefRecorder : public DataRefRecorder<int>
-{
-  protected:
-    //-----------------------------------------------------------------------------
-    virtual int GetDataRefValue()
-    {
-      int val;
-
-      if (m_index >= 0)
-        {
-          XPLMGetDatavi(m_dataRef, &val, m_index, 1);
-        }
-      else
-        {
-          val = XPLMGetDatai(m_dataRef);
-        }
-
-      return val;
-    }
-
-    //-----------------------------------------------------------------------------
-    virtual void SetDataRefValue(int val)
-    {
-      if (m_index >= 0)
-        {
-          XPLMSetDatavi(m_dataRef, &val, m_index, 1);
-        }
-      else
-        {
-          XPLMSetDatai(m_dataRef, val);
-        }
-    }
-
-  public:
-    IntDataRefRecorder(const string &dataRefName,
-                        XPLMDataRef dataRef,
-                        int index = -1,
-                        size_t maxReplayCount = 0,
-                        int recordTolerance = 0,
-                        int initVal = 0) :
-    DataRefRecorder<int>(dataRefName, dataRef, index, maxReplayCount, recordTolerance, initVal)
-    {
-    }
-
-};
-
-#endif // __DATAREF_RECORDER__
+/*
+
+  FILE: DataRefRecorder.h
+
+  BD-5J Plugin for X-Plane 11
+  Copyright © 2018 by Quantumac
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+*/
+
+#ifndef __DATAREF_RECORDER__
+#define __DATAREF_RECORDER__
+
+//--------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//--------------------------------------------------------------------------------------------------------------------
+#include "ValueRecorder.h"
+#include "DataRecorder.h"
+#include "PollState.h"
+#include "XPLMDataAccess.h"
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS DataRefRecorder
+//--------------------------------------------------------------------------------------------------------------------
+template <typename T> class DataRefRecorder : public ValueRecorder<T>
+{
+  protected:
+    string       m_dataRefName;
+    XPLMDataRef  m_dataRef;
+    int          m_index;
+    T            m_initVal;
+    T            m_pendingVal;
+    bool         m_pending;
+    T            m_lastRead;        // Sim thread only
+    bool         m_lowPriority;
+    PollState    m_poll;            // Sim thread only
+
+    //-----------------------------------------------------------------------------
+    virtual T GetDataRefValue() = 0;
+    virtual void SetDataRefValue(T val) = 0;
+
+  public:
+
+    //-----------------------------------------------------------------------------
+    DataRefRecorder()
+    {
+      m_dataRef     = NULL;
+      m_index       = -1;
+      m_initVal     = 0;
+      m_pendingVal  = 0;
+      m_pending     = false;
+      m_lastRead    = 0;
+      m_lowPriority = false;
+    }
+
+    //-----------------------------------------------------------------------------
+    DataRefRecorder(const string &dataRefName,
+                    XPLMDataRef dataRef,
+                    int index = -1,
+                    size_t maxReplayCount = 0,
+                    T recordTolerance = 0,
+                    T initVal = 0) :
+      ValueRecorder<T>(maxReplayCount, recordTolerance)
+    {
+      m_dataRefName = dataRefName;
+      m_dataRef     = dataRef;
+      m_index       = index;
+      m_initVal     = initVal;
+      m_pendingVal  = 0;
+      m_pending     = false;
+      m_lastRead    = 0;
+      m_lowPriority = false;
+    }
+
+    //-----------------------------------------------------------------------------
+    const char *GetDataRefName() { return m_dataRefName.c_str(); }
+    XPLMDataRef GetDataRef() const { return m_dataRef; }
+    int GetIndex() const { return m_index; }
+
+    //-----------------------------------------------------------------------------
+    // Low priority channels are the first the record governor stops reading
+    //-----------------------------------------------------------------------------
+    void SetLowPriority(bool lowPriority) { m_lowPriority = lowPriority; }
+    bool IsLowPriority() const { return m_lowPriority; }
+
+    PollState &Poll() { return m_poll; }
+
+    //-----------------------------------------------------------------------------
+    // Raw read for the sim thread stage of the record pipeline. LastRead repeats
+    // the previous read without touching the dataref.
+    //-----------------------------------------------------------------------------
+    T ReadDataRef()
+    {
+      m_lastRead = this->GetDataRefValue();
+      return m_lastRead;
+    }
+
+    T LastRead() const { return m_lastRead; }
+
+    //-----------------------------------------------------------------------------
+    bool RecordDataRef(float elapsedTime)
+    {
+      return this->RecordValue(elapsedTime, this->GetDataRefValue());
+    }
+
+    //-----------------------------------------------------------------------------
+    // Replay, apply and restore return whether the dataref was written
+    //-----------------------------------------------------------------------------
+    bool ReplayDataRef(float elapsedTime)
+    {
+      T val;
+
+      if (this->ReplayValue(elapsedTime, val))
+        {
+          this->SetDataRefValue(val);
+          return true;
+        }
+      return false;
+    }
+
+    //-----------------------------------------------------------------------------
+    // Split replay: resolving touches only this recorder and may run on any thread,
+    // applying writes the dataref and must run on the sim thread.
+    //-----------------------------------------------------------------------------
+    void ResolveReplay(float elapsedTime, uint64_t fromPos = SAMPLE_NO_POSITION)
+    {
+      m_pending = this->ReplayValue(elapsedTime, m_pendingVal, fromPos);
+    }
+
+    bool ApplyReplay()
+    {
+      if (m_pending)
+        {
+          this->SetDataRefValue(m_pendingVal);
+          m_pending = false;
+          return true;
+        }
+      return false;
+    }
+
+    //-----------------------------------------------------------------------------
+    // The resolved value for a caller writing several array members in one call
+    //-----------------------------------------------------------------------------
+    bool TakePending(T &outVal)
+    {
+      if (m_pending)
+        {
+          outVal    = m_pendingVal;
+          m_pending = false;
+          return true;
+        }
+      return false;
+    }
+
+    //-----------------------------------------------------------------------------
+    bool RestoreDataRef()
+    {
+      T val;
+
+      if (this->GetLastRecordedValue(val))
+        {
+          this->SetDataRefValue(val);
+          return true;
+        }
+      return false;
+    }
+
+    void Init()
+    {
+      this->Clear();
+      this->RecordValue(0.0, m_initVal);
+    }
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS DataRefByteArrRecorder
+//--------------------------------------------------------------------------------------------------------------------
+class DataRefByteArrRecorder : public DataRecorder
+{
+  protected:
+    string       m_dataRefName;
+    XPLMDataRef  m_dataRef;
+    vector<uint8_t>    m_initVal;
+    vector<uint8_t>    m_readVal;
+    vector<uint8_t>    m_scratchVal;
+    bool               m_readChanged;
+    vector<uint8_t>    m_pendingVal;
+    bool               m_pending;
+    bool               m_lowPriority;
+    PollState          m_poll;
+
+    //-----------------------------------------------------------------------------
+    virtual void GetDataRefValue(vector<uint8_t> &outVal) = 0;
+    virtual void SetDataRefValue(vector<uint8_t> val) = 0;
+
+  public:
+
+    //-----------------------------------------------------------------------------
+    DataRefByteArrRecorder()
+    {
+      m_dataRef     = NULL;
+      m_initVal     = vector<uint8_t>();
+      m_pending     = false;
+      m_lowPriority = false;
+      m_readChanged = false;
+    }
+
+    //-----------------------------------------------------------------------------
+    DataRefByteArrRecorder(const string &dataRefName,
+                    XPLMDataRef dataRef,
+                    size_t maxReplayCount = 0,
+                    vector<uint8_t> initVal = vector<uint8_t>()) :
+      DataRecorder(maxReplayCount)
+    {
+      m_dataRefName = dataRefName;
+      m_dataRef     = dataRef;
+      m_initVal     = initVal;
+      m_pending     = false;
+      m_lowPriority = false;
+      m_readChanged = false;
+    }
+
+    //-----------------------------------------------------------------------------
+    const char *GetDataRefName() { return m_dataRefName.c_str(); }
+
+    //-----------------------------------------------------------------------------
+    void SetLowPriority(bool lowPriority) { m_lowPriority = lowPriority; }
+    bool IsLowPriority() const { return m_lowPriority; }
+
+    PollState &Poll() { return m_poll; }
+
+    //-----------------------------------------------------------------------------
+    // Raw read for the sim thread stage of the record pipeline, valid until the next
+    // read. ReadChanged tells whether it differs from the read before.
+    //-----------------------------------------------------------------------------
+    const vector<uint8_t> &ReadDataRef()
+    {
+      this->GetDataRefValue(m_scratchVal);
+      m_readChanged = (m_scratchVal != m_readVal);
+      m_readVal.swap(m_scratchVal);
+      return m_readVal;
+    }
+
+    bool ReadChanged() const { return m_readChanged; }
+
+    //-----------------------------------------------------------------------------
+    bool RecordDataRef(float elapsedTime)
+    {
+      return this->RecordValue(elapsedTime, this->ReadDataRef());
+    }
+
+    //-----------------------------------------------------------------------------
+    bool ReplayDataRef(float elapsedTime)
+    {
+     vector<uint8_t> val;
+
+      if (this->ReplayValue(elapsedTime, val))
+        {
+          this->SetDataRefValue(val);
+          return true;
+        }
+      return false;
+    }
+
+    //-----------------------------------------------------------------------------
+    void ResolveReplay(float elapsedTime, uint64_t fromPos = SAMPLE_NO_POSITION)
+    {
+      m_pending = this->ReplayValue(elapsedTime, m_pendingVal, fromPos);
+    }
+
+    bool ApplyReplay()
+    {
+      if (m_pending)
+        {
+          this->SetDataRefValue(m_pendingVal);
+          m_pending = false;
+          return true;
+        }
+      return false;
+    }
+
+    //-----------------------------------------------------------------------------
+    bool RestoreDataRef()
+    {
+      vector<uint8_t> val;
+
+      if (this->GetLastRecordedValue(val))
+        {
+          this->SetDataRefValue(val);
+          return true;
+        }
+      return false;
+    }
+
+    void Init()
+    {
+      this->Clear();
+      this->RecordValue(0.0, m_initVal);
+    }
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS ByteArrDataRefRecorder - a byte dataref, or a whole float or int array recorded as a sparse channel
+//--------------------------------------------------------------------------------------------------------------------
+class ByteArrDataRefRecorder : public DataRefByteArrRecorder
+{
+  protected:
+    XPLMDataTypeID   m_arrayType;       // xplmType_Data, xplmType_FloatArray or xplmType_IntArray
+    vector<uint8_t>  m_written;         // Array as last written, only the elements differing from it are written
+
+    //-----------------------------------------------------------------------------
+    void WriteRun(size_t first, size_t count, const uint8_t *values)
+    {
+      if (m_arrayType == xplmType_FloatArray)
+        {
+          XPLMSetDatavf(m_dataRef, (float *)values, (int)first, (int)count);
+        }
+      else
+        {
+          XPLMSetDatavi(m_dataRef, (int *)values, (int)first, (int)count);
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    // One call per run of changed elements, short unchanged gaps included
+    //-----------------------------------------------------------------------------
+    void WriteChangedRuns(const vector<uint8_t> &val)
+    {
+      const size_t size        = sizeof(float);
+      size_t       numElements = val.size() / size;
+      bool         all         = (m_written.size() != val.size());
+      size_t       i           = 0;
+
+      while (i < numElements)
+        {
+          if (!all && !memcmp(&m_written[i * size], &val[i * size], size))
+            {
+              i++;
+              continue;
+            }
+
+          size_t first = i;
+          size_t last  = i;
+          for (i++; (i < numElements) && (all || (i - last <= SPARSE_RUN_GAP)); i++)
+            {
+              if (all || memcmp(&m_written[i * size], &val[i * size], size))
+                {
+                  last = i;
+                }
+            }
+
+          this->WriteRun(first, last + 1 - first, &val[first * size]);
+          i = last + 1;
+        }
+
+      m_written = val;
+    }
+
+    //-----------------------------------------------------------------------------
+    virtual void GetDataRefValue(vector<uint8_t> &outVal)
+    {
+        if (m_arrayType == xplmType_FloatArray)
+        {
+            int count = XPLMGetDatavf(m_dataRef, NULL, 0, 0);
+
+            outVal.resize(max(count, 0) * sizeof(float));
+            if (count > 0)
+            {
+                outVal.resize(XPLMGetDatavf(m_dataRef, (float *)&outVal[0], 0, count) * sizeof(float));
+            }
+            return;
+        }
+        else if (m_arrayType == xplmType_IntArray)
+        {
+            int count = XPLMGetDatavi(m_dataRef, NULL, 0, 0);
+
+            outVal.resize(max(count, 0) * sizeof(int));
+            if (count > 0)
+            {
+                outVal.resize(XPLMGetDatavi(m_dataRef, (int *)&outVal[0], 0, count) * sizeof(int));
+            }
+            return;
+        }
+
+        size_t sz = XPLMGetDatab(m_dataRef, NULL, 0, 0);
+
+        outVal.resize(sz);
+        if (sz > 0)
+        {
+            outVal.resize(XPLMGetDatab(m_dataRef, &outVal[0], 0, sz));
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    virtual void SetDataRefValue(vector<uint8_t> val)
+    {
+          if (m_arrayType != xplmType_Data)
+          {
+              this->WriteChangedRuns(val);
+              return;
+          }
+          XPLMSetDatab(m_dataRef, &val[0], 0, val.size());
+    }
+
+  public:
+    ByteArrDataRefRecorder(const string &dataRefName,
+                        XPLMDataRef dataRef,
+                        size_t maxReplayCount = 0,
+                        vector<uint8_t> initVal = vector<uint8_t>(),
+                        XPLMDataTypeID arrayType = xplmType_Data) :
+    DataRefByteArrRecorder(dataRefName, dataRef, maxReplayCount, initVal)
+    {
+      m_arrayType = arrayType;
+      if (arrayType != xplmType_Data)
+        {
+          this->SetSparse(sizeof(float));
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    // Replay transitions, the next write of an array writes all of it
+    //-----------------------------------------------------------------------------
+    void Reset()
+    {
+      m_written.clear();
+      DataRefByteArrRecorder::Reset();
+    }
+
+    bool IsWholeArray() const { return m_arrayType != xplmType_Data; }
+
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS FloatDataRefRecorder
+//--------------------------------------------------------------------------------------------------------------------
+class FloatDataRefRecorder : public DataRefRecorder<float>
+{
+  protected:
+
+    //-----------------------------------------------------------------------------
+    virtual float GetDataRefValue()
+    {
+      float val;
+
+      if (m_index >= 0)
+        {
+          XPLMGetDatavf(m_dataRef, &val, m_index, 1);
+        }
+      else
+        {
+          val = XPLMGetDataf(m_dataRef);
+        }
+
+      return val;
+    }
+
+    //-----------------------------------------------------------------------------
+    virtual void SetDataRefValue(float val)
+    {
+      if (m_index >= 0)
+        {
+          XPLMSetDatavf(m_dataRef, &val, m_index, 1);
+        }
+      else
+        {
+          XPLMSetDataf(m_dataRef, val);
+        }
+    }
+
+  public:
+    FloatDataRefRecorder(const string &dataRefName,
+                          XPLMDataRef dataRef,
+                          int index = -1,
+                          size_t maxReplayCount = 0.0f,
+                          float recordTolerance = 0.0f,
+                          float initVal = 0.0f) :
+    DataRefRecorder<float>(dataRefName, dataRef, index, maxReplayCount, recordTolerance, initVal)
+    {
+    }
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS IntDataRefRecorder
+//--------------------------------------------------------------------------------------------------------------------
+class IntDataRefRecorder : public DataRefRecorder<int>
+{
+  protected:
+    //-----------------------------------------------------------------------------
+    virtual int GetDataRefValue()
+    {
+      int val;
+
+      if (m_index >= 0)
+        {
+          XPLMGetDatavi(m_dataRef, &val, m_index, 1);
+        }
+      else
+        {
+          val = XPLMGetDatai(m_dataRef);
+        }
+
+      return val;
+    }
+
+    //-----------------------------------------------------------------------------
+    virtual void SetDataRefValue(int val)
+    {
+      if (m_index >= 0)
+        {
+          XPLMSetDatavi(m_dataRef, &val, m_index, 1);
+        }
+      else
+        {
+          XPLMSetDatai(m_dataRef, val);
+        }
+    }
+
+  public:
+    IntDataRefRecorder(const string &dataRefName,
+                        XPLMDataRef dataRef,
+                        int index = -1,
+                        size_t maxReplayCount = 0,
+                        int recordTolerance = 0,
+                        int initVal = 0) :
+    DataRefRecorder<int>(dataRefName, dataRef, index, maxReplayCount, recordTolerance, initVal)
+    {
+    }
+
+};
+
+#endif // __DATAREF_RECORDER__
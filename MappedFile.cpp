@@ -0,0 +1,182 @@
+/*
+
+  FILE: MappedFile.cpp
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+*/
+
+#include "MappedFile.h"
+
+#if IBM
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+//--------------------------------------------------------------------------------------------------------------------
+// MappedFile -
+//--------------------------------------------------------------------------------------------------------------------
+MappedFile::MappedFile()
+{
+  m_data = NULL;
+  m_size = 0;
+#if IBM
+  m_file = INVALID_HANDLE_VALUE;
+  m_mapping = NULL;
+#else
+  m_fd = -1;
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ~MappedFile -
+//--------------------------------------------------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+  this->Close();
+}
+
+#if IBM
+
+//--------------------------------------------------------------------------------------------------------------------
+// Open -
+//--------------------------------------------------------------------------------------------------------------------
+bool MappedFile::Open(const string &path, size_t size)
+{
+  this->Close();
+
+  m_file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                       OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (m_file == INVALID_HANDLE_VALUE)
+    {
+      return false;
+    }
+
+  m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READWRITE,
+                                 (DWORD)((uint64_t)size >> 32), (DWORD)(size & 0xffffffff), NULL);
+  if (m_mapping == NULL)
+    {
+      this->Close();
+      return false;
+    }
+
+  m_data = (uint8_t *)MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+  if (m_data == NULL)
+    {
+      this->Close();
+      return false;
+    }
+
+  m_size = size;
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Sync - blocks until the mapped pages are on disk, keep it off the flight loop
+//--------------------------------------------------------------------------------------------------------------------
+void MappedFile::Sync()
+{
+  if (m_data != NULL)
+    {
+      FlushViewOfFile(m_data, m_size);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Close -
+//--------------------------------------------------------------------------------------------------------------------
+void MappedFile::Close()
+{
+  if (m_data != NULL)
+    {
+      UnmapViewOfFile(m_data);
+      m_data = NULL;
+    }
+
+  if (m_mapping != NULL)
+    {
+      CloseHandle(m_mapping);
+      m_mapping = NULL;
+    }
+
+  if (m_file != INVALID_HANDLE_VALUE)
+    {
+      CloseHandle(m_file);
+      m_file = INVALID_HANDLE_VALUE;
+    }
+
+  m_size = 0;
+}
+
+#else
+
+//--------------------------------------------------------------------------------------------------------------------
+// Open -
+//--------------------------------------------------------------------------------------------------------------------
+bool MappedFile::Open(const string &path, size_t size)
+{
+  this->Close();
+
+  m_fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (m_fd < 0)
+    {
+      return false;
+    }
+
+  struct stat st;
+  if ((fstat(m_fd, &st) != 0) || ((size_t)st.st_size < size && ftruncate(m_fd, size) != 0))
+    {
+      this->Close();
+      return false;
+    }
+
+  void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+  if (data == MAP_FAILED)
+    {
+      this->Close();
+      return false;
+    }
+
+  m_data = (uint8_t *)data;
+  m_size = size;
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Sync - blocks until the mapped pages are on disk, keep it off the flight loop
+//--------------------------------------------------------------------------------------------------------------------
+void MappedFile::Sync()
+{
+  if (m_data != NULL)
+    {
+      msync(m_data, m_size, MS_SYNC);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Close -
+//--------------------------------------------------------------------------------------------------------------------
+void MappedFile::Close()
+{
+  if (m_data != NULL)
+    {
+      munmap(m_data, m_size);
+      m_data = NULL;
+    }
+
+  if (m_fd >= 0)
+    {
+      close(m_fd);
+      m_fd = -1;
+    }
+
+  m_size = 0;
+}
+
+#endif
@@ -0,0 +1,55 @@
+/*
+
+  FILE: MappedFile.h
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Pre-allocated, read/write memory mapped file. Pages written through the mapping
+    survive a crash of the X-Plane process because they live in the OS page cache.
+
+*/
+
+#ifndef __MAPPED_FILE__
+#define __MAPPED_FILE__
+
+//--------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//--------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+using namespace std;
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS MappedFile
+//--------------------------------------------------------------------------------------------------------------------
+class MappedFile
+{
+  protected:
+    uint8_t     *m_data;
+    size_t      m_size;
+#if IBM
+    void        *m_file;
+    void        *m_mapping;
+#else
+    int         m_fd;
+#endif
+
+  public:
+
+    MappedFile();
+    ~MappedFile();
+
+    bool Open(const string &path, size_t size);   // Creates or grows the file to size bytes
+    void Sync();
+    void Close();
+
+    bool IsOpen() const { return m_data != NULL; }
+    uint8_t *Data() { return m_data; }
+    size_t Size() const { return m_size; }
+};
+
+#endif // __MAPPED_FILE__
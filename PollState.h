@@ -0,0 +1,82 @@
+/*
+
+  FILE: PollState.h
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Adaptive polling of one channel. A channel that keeps reading the same value is
+    polled less and less often, the period doubling after every POLL_QUIET_POLLS quiet
+    polls up to the configured maximum staleness. The first changed read puts it back to
+    every tick. The tier says how many times the period was doubled, 0 is every tick.
+
+    Sim thread only.
+
+*/
+
+#ifndef __POLL_STATE__
+#define __POLL_STATE__
+
+//--------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//--------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include <algorithm>
+
+//--------------------------------------------------------------------------------------------------------------------
+// DEFINES
+//--------------------------------------------------------------------------------------------------------------------
+#define POLL_FIRST_PERIOD       0.05f   // Seconds between polls after the first quiet streak
+#define POLL_QUIET_POLLS        8       // Unchanged polls in a row before the period doubles
+#define POLL_NUM_TIERS          8
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT PollState
+//--------------------------------------------------------------------------------------------------------------------
+struct PollState
+{
+  float   nextPoll;       // Sim time
+  float   period;         // 0 - every tick
+  uint8_t tier;
+  uint8_t quiet;          // Unchanged polls since the period last changed
+
+  PollState() : nextPoll(0.0f), period(0.0f), tier(0), quiet(0) {}
+
+  //-----------------------------------------------------------------------------
+  // Whether to read the channel this tick. A poll further away than the maximum
+  // staleness means sim time went back, poll then too.
+  //-----------------------------------------------------------------------------
+  bool Due(float time, float maxStaleness) const
+  {
+    return (time >= nextPoll) || (nextPoll - time > maxStaleness);
+  }
+
+  //-----------------------------------------------------------------------------
+  // After a poll, whether the value changed since the previous one
+  //-----------------------------------------------------------------------------
+  void Observe(bool changed, float time, float maxStaleness)
+  {
+    if (changed)
+      {
+        period = 0.0f;
+        tier   = 0;
+        quiet  = 0;
+      }
+    else if (++quiet >= POLL_QUIET_POLLS)
+      {
+        float longer = std::min((period > 0.0f) ? period * 2.0f : POLL_FIRST_PERIOD, maxStaleness);
+
+        if ((longer > period) && (tier < POLL_NUM_TIERS - 1))
+          {
+            tier++;
+          }
+        period = longer;
+        quiet  = 0;
+      }
+
+    nextPoll = time + period;
+  }
+};
+
+#endif // __POLL_STATE__
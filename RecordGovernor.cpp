@@ -0,0 +1,95 @@
+/*
+
+  FILE: RecordGovernor.cpp
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+*/
+
+#include "RecordGovernor.h"
+
+//--------------------------------------------------------------------------------------------------------------------
+// RecordGovernor -
+//--------------------------------------------------------------------------------------------------------------------
+RecordGovernor::RecordGovernor()
+{
+  m_targetFps = 0.0f;
+  this->Reset();
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// SetTargetFps -
+//--------------------------------------------------------------------------------------------------------------------
+void RecordGovernor::SetTargetFps(float fps)
+{
+  m_targetFps = (fps > 0.0f) ? fps : 0.0f;
+  this->Reset();
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Reset -
+//--------------------------------------------------------------------------------------------------------------------
+void RecordGovernor::Reset()
+{
+  m_framePeriod  = 0.0f;
+  m_costPerFrame = 0.0f;
+  m_nextDecision = 0.0f;
+  m_level        = 0;
+  m_numChanges   = 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Update -
+//--------------------------------------------------------------------------------------------------------------------
+bool RecordGovernor::Update(float framePeriod, float sinceLastTick, float costMicros, float time)
+{
+  if (!this->IsEnabled() || (framePeriod <= 0.0f))
+    {
+      return false;
+    }
+
+  //
+  // A tick every n frames costs 1/n of it per frame
+  //
+  float costPerFrame = costMicros * 1e-6f * ((sinceLastTick > framePeriod) ? framePeriod / sinceLastTick : 1.0f);
+
+  if (m_framePeriod <= 0.0f)
+    {
+      m_framePeriod  = framePeriod;
+      m_costPerFrame = costPerFrame;
+      m_nextDecision = time + GOVERNOR_HOLD_SECONDS;
+      return false;
+    }
+
+  m_framePeriod  += GOVERNOR_SMOOTHING * (framePeriod - m_framePeriod);
+  m_costPerFrame += GOVERNOR_SMOOTHING * (costPerFrame - m_costPerFrame);
+
+  if ((time < m_nextDecision) && (time > m_nextDecision - 2 * GOVERNOR_HOLD_SECONDS))     // Sim time may jump back
+    {
+      return false;
+    }
+
+  int level = m_level;
+
+  if ((1.0f / m_framePeriod < m_targetFps) && (m_level < GOVERNOR_MAX_LEVEL))
+    {
+      level++;
+    }
+  else if ((m_level > 0) && (1.0f / (m_framePeriod + m_costPerFrame) >= m_targetFps * GOVERNOR_HEADROOM))
+    {
+      level--;      // One level back roughly doubles our cost per frame
+    }
+
+  m_nextDecision = time + GOVERNOR_HOLD_SECONDS;
+
+  if (level == m_level)
+    {
+      return false;
+    }
+
+  m_level = level;
+  m_numChanges++;
+  return true;
+}
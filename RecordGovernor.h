@@ -0,0 +1,73 @@
+/*
+
+  FILE: RecordGovernor.h
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Backs recording off when the sim runs below a target frame rate. It watches the sim
+    frame period and what the plugin's record ticks cost per frame, and steps through
+    levels: each of the first levels doubles the record interval, the last one also
+    stops reading the low priority channels. It steps back one level at a time once the
+    sim would stay above the target with the added cost. Levels change at most every
+    GOVERNOR_HOLD_SECONDS of sim time so it does not hunt.
+
+*/
+
+#ifndef __RECORD_GOVERNOR__
+#define __RECORD_GOVERNOR__
+
+//--------------------------------------------------------------------------------------------------------------------
+// DEFINES
+//--------------------------------------------------------------------------------------------------------------------
+#define GOVERNOR_STRETCH_LEVELS     3       // Record interval up to 2^3 times the configured one
+#define GOVERNOR_MAX_LEVEL          (GOVERNOR_STRETCH_LEVELS + 1)
+#define GOVERNOR_HOLD_SECONDS       2.0f
+#define GOVERNOR_HEADROOM           1.1f    // Restore only with this much fps to spare
+#define GOVERNOR_SMOOTHING          0.05f   // Weight of the newest tick in the averages
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS RecordGovernor
+//--------------------------------------------------------------------------------------------------------------------
+class RecordGovernor
+{
+  protected:
+    float    m_targetFps;         // 0 - off
+    float    m_framePeriod;       // Seconds, averaged
+    float    m_costPerFrame;      // Seconds of record tick cost per sim frame, averaged
+    float    m_nextDecision;      // Sim time
+    int      m_level;
+    unsigned m_numChanges;
+
+  public:
+
+    RecordGovernor();
+
+    void SetTargetFps(float fps);
+    float GetTargetFps() const { return m_targetFps; }
+    bool IsEnabled() const { return m_targetFps > 0.0f; }
+
+    //-----------------------------------------------------------------------------
+    // Back to full rate, e.g. when recording starts again
+    //-----------------------------------------------------------------------------
+    void Reset();
+
+    //-----------------------------------------------------------------------------
+    // After each record tick: the sim frame period, the time since the previous
+    // record tick, what this one cost and the sim time. True if the level changed.
+    //-----------------------------------------------------------------------------
+    bool Update(float framePeriod, float sinceLastTick, float costMicros, float time);
+
+    int GetLevel() const { return m_level; }
+    unsigned NumChanges() const { return m_numChanges; }
+    float GetFps() const { return (m_framePeriod > 0.0f) ? 1.0f / m_framePeriod : 0.0f; }
+
+    //-----------------------------------------------------------------------------
+    // What the level means for the record loop
+    //-----------------------------------------------------------------------------
+    float IntervalScale() const { return (float)(1 << ((m_level < GOVERNOR_STRETCH_LEVELS) ? m_level : GOVERNOR_STRETCH_LEVELS)); }
+    bool DropLowPriority() const { return m_level > GOVERNOR_STRETCH_LEVELS; }
+};
+
+#endif // __RECORD_GOVERNOR__
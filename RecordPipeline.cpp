@@ -0,0 +1,735 @@
+/*
+
+  FILE: RecordPipeline.cpp
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+*/
+
+#include <chrono>
+
+#include "RecordPipeline.h"
+#include "TraceBuffer.h"
+#include "AllocTracker.h"
+
+#define WORKER_IDLE_SLEEP_MS        1
+
+//--------------------------------------------------------------------------------------------------------------------
+// RecordPipeline -
+//--------------------------------------------------------------------------------------------------------------------
+RecordPipeline::RecordPipeline()
+{
+  m_writer = NULL;
+  m_running = false;
+  m_threaded = false;
+  m_sparse = false;
+  m_tickTime = 0.0f;
+  m_keyframeInterval = 0.0f;
+  m_changesRecorded = 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ~RecordPipeline -
+//--------------------------------------------------------------------------------------------------------------------
+RecordPipeline::~RecordPipeline()
+{
+  this->Stop();
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Start - create the shards and spawn one worker thread per shard
+//--------------------------------------------------------------------------------------------------------------------
+bool RecordPipeline::Start(unsigned numWorkers, size_t stagingBytes, RecordingWriter *writer)
+{
+  if (this->IsRunning())
+    {
+      return true;
+    }
+
+  if (numWorkers > PIPELINE_MAX_WORKERS)
+    {
+      numWorkers = PIPELINE_MAX_WORKERS;
+    }
+
+  m_writer = writer;
+  m_threaded = (numWorkers > 0);
+  m_changesRecorded = 0;
+  m_shards.clear();
+
+  unsigned numShards = m_threaded ? numWorkers : 1;
+  for (unsigned i = 0; i < numShards; i++)
+    {
+      Shard *shard = new Shard();
+      shard->index = i;
+      shard->framesDone = 0;
+      shard->nextKeyframeTime = 0.0f;
+      shard->usageTierBytes = 0;
+      for (int t = 0; t <= kRecordTypeBytes; t++)
+        {
+          shard->usageBytes[t] = 0;
+        }
+      shard->floatFirst = 0;
+      shard->intFirst = 0;
+      shard->staging.Init(stagingBytes / numShards);
+      m_shards.push_back(unique_ptr<Shard>(shard));
+    }
+
+  this->ResizeUsage();
+  m_running = true;
+
+  if (m_threaded)
+    {
+      for (size_t i = 0; i < m_shards.size(); i++)
+        {
+          m_shards[i]->worker = thread(&RecordPipeline::WorkerMain, this, m_shards[i].get());
+        }
+    }
+
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Stop - let the workers finish what is staged and join them
+//--------------------------------------------------------------------------------------------------------------------
+void RecordPipeline::Stop()
+{
+  if (!this->IsRunning())
+    {
+      return;
+    }
+
+  m_running = false;
+
+  for (size_t i = 0; i < m_shards.size(); i++)
+    {
+      if (m_shards[i]->worker.joinable())
+        {
+          m_shards[i]->worker.join();
+        }
+      this->PublishUsage(*m_shards[i]);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Drain - wait until the workers processed everything staged so far
+//--------------------------------------------------------------------------------------------------------------------
+void RecordPipeline::Drain(bool includeWriter)
+{
+  TRACE_SCOPE("drain");
+
+  for (size_t i = 0; i < m_shards.size(); i++)
+    {
+      Shard &shard = *m_shards[i];
+
+      if (!m_threaded || !this->IsRunning())
+        {
+          while (this->ProcessPending(shard))
+            {
+            }
+          continue;
+        }
+
+      while (shard.framesDone.load(memory_order_acquire) < shard.staging.NumPushed())
+        {
+          this_thread::yield();
+        }
+    }
+
+  if (includeWriter && (m_writer != NULL))
+    {
+      while (m_writer->IsRunning() && !m_writer->IsIdle())
+        {
+          this_thread::yield();
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// BindChannels -
+//--------------------------------------------------------------------------------------------------------------------
+void RecordPipeline::BindChannels(const vector<ValueRecorder<float> *> &floatChannels,
+                                  const vector<ValueRecorder<int> *> &intChannels,
+                                  const vector<DataRecorder *> &bytesChannels)
+{
+  m_floatChannels = floatChannels;
+  m_intChannels = intChannels;
+  m_bytesChannels = bytesChannels;
+
+  this->ResizeUsage();
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ResizeUsage - one published usage slot per bound channel. Channels are only ever added, the ones already
+//               published keep their values until the next publish.
+//--------------------------------------------------------------------------------------------------------------------
+void RecordPipeline::ResizeUsage()
+{
+  size_t counts[kRecordTypeBytes + 1] = { 0, m_floatChannels.size(), m_intChannels.size(), m_bytesChannels.size() };
+  size_t n = m_shards.size();
+
+  for (size_t i = 0; i < n; i++)
+    {
+      for (int t = kRecordTypeFloat; t <= kRecordTypeBytes; t++)
+        {
+          vector<ChannelUsage> &usage = m_shards[i]->usage[t];
+          size_t               slots  = (counts[t] + n - 1 - i) / n;
+
+          if (slots == usage.size())
+            {
+              continue;
+            }
+
+          vector<ChannelUsage> grown(slots);
+          for (size_t k = 0; k < slots; k++)
+            {
+              grown[k].bytes   = (k < usage.size()) ? usage[k].bytes.load(memory_order_relaxed) : 0;
+              grown[k].samples = (k < usage.size()) ? usage[k].samples.load(memory_order_relaxed) : 0;
+            }
+          usage.swap(grown);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// PushControl - control frames must not be lost, wait for room if the staging ring is full
+//--------------------------------------------------------------------------------------------------------------------
+void RecordPipeline::PushControl(Shard &shard, const StageFrameHeader &header, const void *payload, uint32_t length)
+{
+  if (shard.staging.Capacity() == 0)
+    {
+      return;
+    }
+
+  while (!shard.staging.TryPush(&header, sizeof(header), payload, length))
+    {
+      this->Drain();
+    }
+
+  if (!m_threaded)
+    {
+      this->ProcessPending(shard);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// DeclareChannel - announce a new channel through the shard that owns it
+//--------------------------------------------------------------------------------------------------------------------
+void RecordPipeline::DeclareChannel(RecordType type, size_t index, uint32_t channelId, const char *name)
+{
+  if (m_shards.empty())
+    {
+      return;
+    }
+
+  StageFrameHeader header;
+  memset(&header, 0, sizeof(header));
+  header.kind    = kStageDeclare;
+  header.channel = channelId;
+  header.type    = type;
+
+  this->PushControl(*m_shards[index % m_shards.size()], header, name, (uint32_t)strlen(name));
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// StartSession - mark that the recorders were cleared. Call with the pipeline and writer drained.
+//--------------------------------------------------------------------------------------------------------------------
+void RecordPipeline::StartSession()
+{
+  if (m_shards.empty())
+    {
+      return;
+    }
+
+  StageFrameHeader header;
+  memset(&header, 0, sizeof(header));
+  header.kind = kStageSession;
+
+  this->PushControl(*m_shards[0], header, NULL, 0);
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ClearKeyframes -
+//--------------------------------------------------------------------------------------------------------------------
+void RecordPipeline::ClearKeyframes()
+{
+  for (size_t i = 0; i < m_shards.size(); i++)
+    {
+      m_shards[i]->keyframes.clear();
+      m_shards[i]->nextKeyframeTime = 0.0f;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// KeyframePosition - sample position of a channel in the newest keyframe at or before time
+//--------------------------------------------------------------------------------------------------------------------
+uint64_t RecordPipeline::KeyframePosition(RecordType type, size_t index, float time) const
+{
+  if (m_shards.empty())
+    {
+      return SAMPLE_NO_POSITION;
+    }
+
+  size_t      n     = m_shards.size();
+  const Shard &shard = *m_shards[index % n];
+  size_t      slot  = index / n;
+
+  deque<Keyframe>::const_iterator iter =
+    upper_bound(shard.keyframes.begin(), shard.keyframes.end(), time,
+                [](float t, const Keyframe &k) { return t < k.time; });
+  if (iter == shard.keyframes.begin())
+    {
+      return SAMPLE_NO_POSITION;
+    }
+
+  const Keyframe &key = *(iter - 1);
+  const vector<uint64_t> &pos = (type == kRecordTypeFloat) ? key.floatPos :
+                                (type == kRecordTypeInt)   ? key.intPos : key.bytesPos;
+
+  return (slot < pos.size()) ? pos[slot] : SAMPLE_NO_POSITION;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// SlotsBefore - number of shard slots whose channel index is below index
+//--------------------------------------------------------------------------------------------------------------------
+static size_t SlotsBefore(size_t index, size_t shard, size_t numShards)
+{
+  return (index > shard) ? (index - shard + numShards - 1) / numShards : 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// BeginTick - size the staging arrays for the channel ranges of this tick
+//--------------------------------------------------------------------------------------------------------------------
+void RecordPipeline::BeginTick(float time, size_t floatBegin, size_t floatEnd, size_t intBegin, size_t intEnd)
+{
+  size_t n = m_shards.size();
+
+  m_tickTime = time;
+  m_sparse   = false;
+  floatEnd   = min(floatEnd, m_floatChannels.size());
+  intEnd     = min(intEnd, m_intChannels.size());
+  floatBegin = min(floatBegin, floatEnd);
+  intBegin   = min(intBegin, intEnd);
+
+  for (size_t i = 0; i < n; i++)
+    {
+      Shard &shard = *m_shards[i];
+
+      shard.floatFirst = SlotsBefore(floatBegin, i, n);
+      shard.intFirst   = SlotsBefore(intBegin, i, n);
+      shard.floatStage.resize(SlotsBefore(floatEnd, i, n) - shard.floatFirst);
+      shard.intStage.resize(SlotsBefore(intEnd, i, n) - shard.intFirst);
+      shard.floatSlots.clear();
+      shard.intSlots.clear();
+      shard.bytesStage.clear();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// BeginSparseTick - start a tick staging only the channels passed to Stage...
+//--------------------------------------------------------------------------------------------------------------------
+void RecordPipeline::BeginSparseTick(float time)
+{
+  m_tickTime = time;
+  m_sparse   = true;
+
+  for (size_t i = 0; i < m_shards.size(); i++)
+    {
+      Shard &shard = *m_shards[i];
+
+      shard.floatFirst = 0;
+      shard.intFirst   = 0;
+      shard.floatStage.clear();
+      shard.intStage.clear();
+      shard.floatSlots.clear();
+      shard.intSlots.clear();
+      shard.bytesStage.clear();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// CommitTick - hand the staged snapshot to the workers. A full staging ring drops the tick.
+//--------------------------------------------------------------------------------------------------------------------
+void RecordPipeline::CommitTick()
+{
+  for (size_t i = 0; i < m_shards.size(); i++)
+    {
+      Shard &shard = *m_shards[i];
+
+      StageFrameHeader header;
+      memset(&header, 0, sizeof(header));
+      header.kind        = m_sparse ? kStageSparse : kStageSample;
+      header.time        = m_tickTime;
+      header.numFloat    = (uint32_t)shard.floatStage.size();
+      header.numInt      = (uint32_t)shard.intStage.size();
+      header.firstFloat  = (uint32_t)shard.floatFirst;
+      header.firstInt    = (uint32_t)shard.intFirst;
+      header.bytesLength = (uint32_t)shard.bytesStage.size();
+
+      RingSegment segments[6] =
+        {
+          { &header, sizeof(header) },
+          { shard.floatSlots.empty() ? NULL : &shard.floatSlots[0], (uint32_t)(shard.floatSlots.size() * sizeof(uint32_t)) },
+          { shard.floatStage.empty() ? NULL : &shard.floatStage[0], (uint32_t)(shard.floatStage.size() * sizeof(float)) },
+          { shard.intSlots.empty() ? NULL : &shard.intSlots[0], (uint32_t)(shard.intSlots.size() * sizeof(uint32_t)) },
+          { shard.intStage.empty() ? NULL : &shard.intStage[0], (uint32_t)(shard.intStage.size() * sizeof(int)) },
+          { shard.bytesStage.empty() ? NULL : &shard.bytesStage[0], (uint32_t)shard.bytesStage.size() }
+        };
+
+      shard.staging.TryPush(segments, 6);
+
+      if (!m_threaded)
+        {
+          this->ProcessPending(shard);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// WorkerMain -
+//--------------------------------------------------------------------------------------------------------------------
+void RecordPipeline::WorkerMain(Shard *shard)
+{
+  gTraceBuffer.NameThread("record worker");
+
+  for (;;)
+    {
+      bool running = this->IsRunning();
+      bool worked  = false;
+
+      while (this->ProcessPending(*shard))
+        {
+          worked = true;
+        }
+
+      if (!running)
+        {
+          break;
+        }
+
+      if (!worked)
+        {
+          this_thread::sleep_for(chrono::milliseconds(WORKER_IDLE_SLEEP_MS));
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ProcessPending - process one staged frame if there is one
+//--------------------------------------------------------------------------------------------------------------------
+bool RecordPipeline::ProcessPending(Shard &shard)
+{
+  if (!shard.staging.TryPop(shard.frame))
+    {
+      return false;
+    }
+
+  if (shard.frame.size() >= sizeof(StageFrameHeader))
+    {
+      this->ProcessFrame(shard);
+    }
+
+  shard.framesDone.fetch_add(1, memory_order_release);
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ProcessFrame - change detection and storage for the channels of one shard
+//--------------------------------------------------------------------------------------------------------------------
+void RecordPipeline::ProcessFrame(Shard &shard)
+{
+  TRACE_SCOPE("record_frame");
+  ALLOC_SCOPE(kAllocWorker, kRecordTypeNone);
+
+  StageFrameHeader header;
+  memcpy(&header, &shard.frame[0], sizeof(header));
+
+  const uint8_t *payload = &shard.frame[0] + sizeof(header);
+  size_t        n        = m_shards.size();
+  uint64_t      changes  = 0;
+
+  switch (header.kind)
+    {
+      case kStageDeclare:
+        this->Emit(shard, kRecordDeclare, (uint8_t)header.type, header.channel, 0.0f,
+                   payload, (uint32_t)(shard.frame.size() - sizeof(header)));
+        break;
+
+      case kStageSession:
+        this->Emit(shard, kRecordSession, kRecordTypeNone, 0, 0.0f);
+        this->PublishUsage(shard);        // The recorders were just cleared
+        break;
+
+      case kStageSample:
+      case kStageSparse:
+        {
+          //
+          // Recording again from an earlier time truncates the recorders, keyframes from then on are gone too
+          //
+          while (!shard.keyframes.empty() && (shard.keyframes.back().time >= header.time))
+            {
+              shard.keyframes.pop_back();
+              shard.nextKeyframeTime = header.time;
+            }
+
+          bool sparse = (header.kind == kStageSparse);
+
+          ALLOC_TAG(kAllocWorker, kRecordTypeFloat);
+          const uint32_t *floatSlots = sparse ? (const uint32_t *)payload : NULL;
+          payload += sparse ? header.numFloat * sizeof(uint32_t) : 0;
+
+          const float *floats = (const float *)payload;
+          for (uint32_t k = 0; k < header.numFloat; k++)
+            {
+              size_t idx = shard.index + (sparse ? floatSlots[k] : header.firstFloat + k) * n;
+              if ((idx < m_floatChannels.size()) && m_floatChannels[idx]->RecordValue(header.time, floats[k]))
+                {
+                  this->Emit(shard, kRecordChange, kRecordTypeFloat, m_floatChannels[idx]->GetChannelId(),
+                             header.time, &floats[k], sizeof(float));
+                  changes++;
+                }
+            }
+          payload += header.numFloat * sizeof(float);
+
+          ALLOC_TAG(kAllocWorker, kRecordTypeInt);
+          const uint32_t *intSlots = sparse ? (const uint32_t *)payload : NULL;
+          payload += sparse ? header.numInt * sizeof(uint32_t) : 0;
+
+          const int *ints = (const int *)payload;
+          for (uint32_t k = 0; k < header.numInt; k++)
+            {
+              size_t idx = shard.index + (sparse ? intSlots[k] : header.firstInt + k) * n;
+              if ((idx < m_intChannels.size()) && m_intChannels[idx]->RecordValue(header.time, ints[k]))
+                {
+                  this->Emit(shard, kRecordChange, kRecordTypeInt, m_intChannels[idx]->GetChannelId(),
+                             header.time, &ints[k], sizeof(int));
+                  changes++;
+                }
+            }
+          payload += header.numInt * sizeof(int);
+
+          ALLOC_TAG(kAllocWorker, kRecordTypeBytes);
+          const uint8_t *end = payload + header.bytesLength;
+          while (payload + 2 * sizeof(uint32_t) <= end)
+            {
+              uint32_t slot, length;
+              memcpy(&slot, payload, sizeof(slot));
+              memcpy(&length, payload + sizeof(slot), sizeof(length));
+              payload += 2 * sizeof(uint32_t);
+
+              size_t idx = shard.index + slot * n;
+              shard.bytesVal.assign(payload, payload + length);
+              payload += length;
+
+              if ((idx < m_bytesChannels.size()) && m_bytesChannels[idx]->RecordValue(header.time, shard.bytesVal))
+                {
+                  this->Emit(shard, kRecordChange, kRecordTypeBytes, m_bytesChannels[idx]->GetChannelId(),
+                             header.time, shard.bytesVal.empty() ? NULL : &shard.bytesVal[0], length);
+                  changes++;
+                }
+            }
+
+          ALLOC_TAG(kAllocWorker, kRecordTypeNone);
+          this->UpdateKeyframes(shard, header.time);
+
+          if (chrono::steady_clock::now() >= shard.nextUsageTime)
+            {
+              this->PublishUsage(shard);
+            }
+        }
+        break;
+    }
+
+  if (changes > 0)
+    {
+      m_changesRecorded.fetch_add(changes, memory_order_relaxed);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// UpdateKeyframes - save the newest sample position of every channel in the shard when a keyframe is due
+//--------------------------------------------------------------------------------------------------------------------
+void RecordPipeline::UpdateKeyframes(Shard &shard, float time)
+{
+  if ((m_keyframeInterval <= 0.0f) || (time < shard.nextKeyframeTime))
+    {
+      return;
+    }
+
+  shard.keyframes.push_back(Keyframe());
+  if (shard.keyframes.size() > KEYFRAME_MAX_COUNT)
+    {
+      swap(shard.keyframes.back(), shard.keyframes.front());      // Reuse the oldest keyframe's storage
+      shard.keyframes.pop_front();
+    }
+
+  Keyframe &key = shard.keyframes.back();
+  size_t   n    = m_shards.size();
+
+  key.time = time;
+  key.floatPos.clear();
+  key.intPos.clear();
+  key.bytesPos.clear();
+
+  for (size_t idx = shard.index; idx < m_floatChannels.size(); idx += n)
+    {
+      key.floatPos.push_back(m_floatChannels[idx]->LastPosition());
+    }
+  for (size_t idx = shard.index; idx < m_intChannels.size(); idx += n)
+    {
+      key.intPos.push_back(m_intChannels[idx]->LastPosition());
+    }
+  for (size_t idx = shard.index; idx < m_bytesChannels.size(); idx += n)
+    {
+      key.bytesPos.push_back(m_bytesChannels[idx]->LastPosition());
+    }
+
+  shard.nextKeyframeTime = time + m_keyframeInterval;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// TierBytes - part of a recorder's storage in the @retain tiers, byte arrays have none
+//--------------------------------------------------------------------------------------------------------------------
+template <typename T> static size_t TierBytes(ValueRecorder<T> &recorder)
+{
+  return recorder.TierStorageBytes();
+}
+
+static size_t TierBytes(DataRecorder &recorder)
+{
+  return 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// PublishUsage - storage and samples of the shard's channels of one type, returns their total bytes
+//--------------------------------------------------------------------------------------------------------------------
+template <typename R> uint64_t RecordPipeline::PublishUsage(Shard &shard, const vector<R *> &channels, RecordType type,
+                                                            uint64_t &tierBytes)
+{
+  vector<ChannelUsage> &usage = shard.usage[type];
+  size_t               n      = m_shards.size();
+  uint64_t             total  = 0;
+
+  for (size_t slot = 0; slot < usage.size(); slot++)
+    {
+      R        &recorder = *channels[shard.index + slot * n];
+      uint64_t bytes     = recorder.StorageBytes();
+
+      usage[slot].bytes.store(bytes, memory_order_relaxed);
+      usage[slot].samples.store(recorder.NumEventsRecorded(), memory_order_relaxed);
+      tierBytes += TierBytes(recorder);
+      total     += bytes;
+    }
+
+  shard.usageBytes[type].store(total, memory_order_relaxed);
+  return total;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// PublishUsage - walk the shard's recorders for the sim thread, only by their owner
+//--------------------------------------------------------------------------------------------------------------------
+void RecordPipeline::PublishUsage(Shard &shard)
+{
+  TRACE_SCOPE("publish_usage");
+
+  uint64_t tierBytes = 0;
+
+  this->PublishUsage(shard, m_floatChannels, kRecordTypeFloat, tierBytes);
+  this->PublishUsage(shard, m_intChannels, kRecordTypeInt, tierBytes);
+  this->PublishUsage(shard, m_bytesChannels, kRecordTypeBytes, tierBytes);
+  shard.usageTierBytes.store(tierBytes, memory_order_relaxed);
+
+  shard.nextUsageTime = chrono::steady_clock::now() + chrono::milliseconds(PIPELINE_USAGE_INTERVAL_MS);
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// StorageBytes - add up what the shards published
+//--------------------------------------------------------------------------------------------------------------------
+size_t RecordPipeline::StorageBytes(RecordType type, size_t *outTierBytes) const
+{
+  uint64_t bytes = 0;
+  uint64_t tiers = 0;
+
+  for (size_t i = 0; i < m_shards.size(); i++)
+    {
+      const Shard &shard = *m_shards[i];
+
+      for (int t = kRecordTypeFloat; t <= kRecordTypeBytes; t++)
+        {
+          if ((type == kRecordTypeNone) || (type == t))
+            {
+              bytes += shard.usageBytes[t].load(memory_order_relaxed);
+            }
+        }
+      tiers += shard.usageTierBytes.load(memory_order_relaxed);
+    }
+
+  if (outTierBytes != NULL)
+    {
+      *outTierBytes = (size_t)tiers;
+    }
+  return (size_t)bytes;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ChannelStorageBytes -
+//--------------------------------------------------------------------------------------------------------------------
+size_t RecordPipeline::ChannelStorageBytes(RecordType type, size_t index) const
+{
+  size_t n = m_shards.size();
+
+  if ((n == 0) || (type < kRecordTypeFloat) || (type > kRecordTypeBytes))
+    {
+      return 0;
+    }
+
+  const vector<ChannelUsage> &usage = m_shards[index % n]->usage[type];
+  return (index / n < usage.size()) ? (size_t)usage[index / n].bytes.load(memory_order_relaxed) : 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ChannelSamples -
+//--------------------------------------------------------------------------------------------------------------------
+size_t RecordPipeline::ChannelSamples(RecordType type, size_t index) const
+{
+  size_t n = m_shards.size();
+
+  if ((n == 0) || (type < kRecordTypeFloat) || (type > kRecordTypeBytes))
+    {
+      return 0;
+    }
+
+  const vector<ChannelUsage> &usage = m_shards[index % n]->usage[type];
+  return (index / n < usage.size()) ? (size_t)usage[index / n].samples.load(memory_order_relaxed) : 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// GetStats -
+//--------------------------------------------------------------------------------------------------------------------
+RecordPipelineStats RecordPipeline::GetStats() const
+{
+  RecordPipelineStats stats;
+
+  stats.numWorkers       = m_threaded ? (unsigned)m_shards.size() : 0;
+  stats.stagingCapacity  = 0;
+  stats.stagingHighWater = 0;
+  stats.framesStaged     = 0;
+  stats.framesDropped    = 0;
+  stats.framesProcessed  = 0;
+  stats.changesRecorded  = m_changesRecorded.load(memory_order_relaxed);
+  stats.keyframes        = m_shards.empty() ? 0 : m_shards[0]->keyframes.size();
+
+  for (size_t i = 0; i < m_shards.size(); i++)
+    {
+      const Shard &shard = *m_shards[i];
+
+      stats.stagingCapacity  += shard.staging.Capacity();
+      stats.stagingHighWater  = max(stats.stagingHighWater, shard.staging.HighWater());
+      stats.framesStaged     += shard.staging.NumPushed();
+      stats.framesDropped    += shard.staging.NumDropped();
+      stats.framesProcessed  += shard.framesDone.load(memory_order_relaxed);
+    }
+
+  return stats;
+}
@@ -0,0 +1,274 @@
+/*
+
+  FILE: RecordPipeline.h
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Two stage recorder. The sim thread only snapshots raw dataref values into per-shard
+    staging frames; worker threads do change detection, block sealing, eviction and hand
+    the changes to the recording writer. Channels are sharded by index over the workers.
+
+    Recorders belong to the workers while recording. Anything else touching them from the
+    sim thread (replay, restore, clear, adding channels) must Drain() the pipeline first.
+
+    A tick may stage only a range of the float and int channels (record budget, see
+    rext.cpp), the frame then carries the first slot of the range. A sparse tick stages
+    any set of channels (rate groups) and carries the slot of every value. Byte arrays
+    always carry their slot.
+
+    Every keyframe interval each worker also saves the newest sample position of all its
+    channels. A replay seek starts each channel's lookup from the keyframe at or before the
+    target, so its cost depends on the interval rather than on the length of the history.
+
+    The workers also publish the storage and sample count of their channels, at most every
+    PIPELINE_USAGE_INTERVAL_MS, after a session starts and when the pipeline stops. The sim
+    thread reads them without draining.
+
+*/
+
+#ifndef __RECORD_PIPELINE__
+#define __RECORD_PIPELINE__
+
+//--------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//--------------------------------------------------------------------------------------------------------------------
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "SpscRingBuffer.h"
+#include "ValueRecorder.h"
+#include "DataRecorder.h"
+#include "RecordingWriter.h"
+
+using namespace std;
+
+//--------------------------------------------------------------------------------------------------------------------
+// DEFINES
+//--------------------------------------------------------------------------------------------------------------------
+#define PIPELINE_MAX_WORKERS        8
+#define KEYFRAME_MAX_COUNT          360     // Older keyframes are dropped, seeks before them do a full lookup
+#define PIPELINE_USAGE_INTERVAL_MS  250     // Storage walks every sealed block, not something for every frame
+
+enum StageFrameKind
+{
+  kStageSample  = 1,    // float values, int values, then (slot, length, bytes) per byte array
+  kStageDeclare = 2,    // payload: dataref name
+  kStageSession = 3,
+  kStageSparse  = 4     // float slots, float values, int slots, int values, then byte arrays as above
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT StageFrameHeader
+//--------------------------------------------------------------------------------------------------------------------
+struct StageFrameHeader
+{
+  uint32_t kind;
+  float    time;
+  uint32_t numFloat;
+  uint32_t numInt;
+  uint32_t firstFloat;    // Shard slot of the first float value
+  uint32_t firstInt;
+  uint32_t bytesLength;
+  uint32_t channel;       // kStageDeclare only
+  uint32_t type;          // kStageDeclare only
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT RecordPipelineStats
+//--------------------------------------------------------------------------------------------------------------------
+struct RecordPipelineStats
+{
+  unsigned numWorkers;
+  size_t   stagingCapacity;
+  size_t   stagingHighWater;
+  uint64_t framesStaged;
+  uint64_t framesDropped;
+  uint64_t framesProcessed;
+  uint64_t changesRecorded;
+  size_t   keyframes;
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS RecordPipeline
+//--------------------------------------------------------------------------------------------------------------------
+class RecordPipeline
+{
+  protected:
+    struct Keyframe
+    {
+      float               time;
+      vector<uint64_t>    floatPos;       // By shard slot
+      vector<uint64_t>    intPos;
+      vector<uint64_t>    bytesPos;
+    };
+
+    struct ChannelUsage
+    {
+      atomic<uint64_t>    bytes;
+      atomic<uint64_t>    samples;
+    };
+
+    struct Shard
+    {
+      unsigned            index;
+      SpscRingBuffer      staging;
+      thread              worker;
+      atomic<uint64_t>    framesDone;
+      vector<float>       floatStage;     // Sim thread only
+      vector<int>         intStage;
+      size_t              floatFirst;     // Shard slot of floatStage[0]
+      size_t              intFirst;
+      vector<uint32_t>    floatSlots;     // Sparse ticks only
+      vector<uint32_t>    intSlots;
+      vector<uint8_t>     bytesStage;
+      vector<uint8_t>     frame;          // Worker only
+      vector<uint8_t>     bytesVal;
+      deque<Keyframe>     keyframes;      // Worker owned, like the recorders
+      float               nextKeyframeTime;
+      vector<ChannelUsage> usage[kRecordTypeBytes + 1];   // Published by the worker, by shard slot
+      atomic<uint64_t>    usageBytes[kRecordTypeBytes + 1];
+      atomic<uint64_t>    usageTierBytes;
+      chrono::steady_clock::time_point nextUsageTime;    // Worker only
+    };
+
+    vector<unique_ptr<Shard> >      m_shards;
+    vector<ValueRecorder<float> *>  m_floatChannels;
+    vector<ValueRecorder<int> *>    m_intChannels;
+    vector<DataRecorder *>          m_bytesChannels;
+    RecordingWriter                 *m_writer;
+    atomic<bool>                    m_running;
+    bool                            m_threaded;
+    bool                            m_sparse;         // Current tick
+    float                           m_tickTime;
+    float                           m_keyframeInterval;
+    atomic<uint64_t>                m_changesRecorded;
+
+    void WorkerMain(Shard *shard);
+    bool ProcessPending(Shard &shard);
+    void ProcessFrame(Shard &shard);
+    void PushControl(Shard &shard, const StageFrameHeader &header, const void *payload, uint32_t length);
+    void UpdateKeyframes(Shard &shard, float time);
+    void ResizeUsage();
+    void PublishUsage(Shard &shard);
+    template <typename R> uint64_t PublishUsage(Shard &shard, const vector<R *> &channels, RecordType type,
+                                                uint64_t &tierBytes);
+
+    //-----------------------------------------------------------------------------
+    void Emit(Shard &shard, uint8_t kind, uint8_t type, uint32_t channel, float time,
+              const void *payload = NULL, uint32_t length = 0)
+    {
+      if ((m_writer != NULL) && m_writer->IsRunning())
+        {
+          m_writer->PushRecord(shard.index, kind, type, channel, time, payload, length);
+        }
+    }
+
+  public:
+
+    RecordPipeline();
+    ~RecordPipeline();
+
+    //-----------------------------------------------------------------------------
+    // numWorkers 0 runs the worker stage inline on the sim thread
+    //-----------------------------------------------------------------------------
+    bool Start(unsigned numWorkers, size_t stagingBytes, RecordingWriter *writer);
+    void Stop();
+    void Drain(bool includeWriter = false);
+
+    unsigned NumShards() const { return (unsigned)m_shards.size(); }
+    bool IsRunning() const { return m_running.load(memory_order_relaxed); }
+
+    //-----------------------------------------------------------------------------
+    // Channel table, only with the pipeline drained
+    //-----------------------------------------------------------------------------
+    void BindChannels(const vector<ValueRecorder<float> *> &floatChannels,
+                      const vector<ValueRecorder<int> *> &intChannels,
+                      const vector<DataRecorder *> &bytesChannels);
+    void DeclareChannel(RecordType type, size_t index, uint32_t channelId, const char *name);
+    void StartSession();
+
+    //-----------------------------------------------------------------------------
+    // Keyframes, interval 0 disables them. Only with the pipeline drained.
+    //-----------------------------------------------------------------------------
+    void SetKeyframeInterval(float seconds) { m_keyframeInterval = seconds; }
+    void ClearKeyframes();
+    uint64_t KeyframePosition(RecordType type, size_t index, float time) const;
+
+    //-----------------------------------------------------------------------------
+    // Storage as last published by the workers, safe from the sim thread at any time.
+    // type kRecordTypeNone totals all types. Channels bound since read 0.
+    //-----------------------------------------------------------------------------
+    size_t StorageBytes(RecordType type, size_t *outTierBytes = NULL) const;
+    size_t ChannelStorageBytes(RecordType type, size_t index) const;
+    size_t ChannelSamples(RecordType type, size_t index) const;
+
+    //-----------------------------------------------------------------------------
+    // Sim thread stage, one BeginTick/Stage.../CommitTick sequence per record pass.
+    // The ranged BeginTick stages only float channels [floatBegin, floatEnd) and
+    // int channels [intBegin, intEnd), the others keep their previous sample.
+    // After BeginSparseTick only the channels staged get a sample, in any order.
+    //-----------------------------------------------------------------------------
+    void BeginTick(float time)
+    {
+      this->BeginTick(time, 0, m_floatChannels.size(), 0, m_intChannels.size());
+    }
+
+    void BeginTick(float time, size_t floatBegin, size_t floatEnd, size_t intBegin, size_t intEnd);
+    void BeginSparseTick(float time);
+
+    void StageFloat(size_t index, float val)
+    {
+      size_t n     = m_shards.size();
+      Shard  &shard = *m_shards[index % n];
+
+      if (m_sparse)
+        {
+          shard.floatSlots.push_back((uint32_t)(index / n));
+          shard.floatStage.push_back(val);
+        }
+      else
+        {
+          shard.floatStage[index / n - shard.floatFirst] = val;
+        }
+    }
+
+    void StageInt(size_t index, int val)
+    {
+      size_t n     = m_shards.size();
+      Shard  &shard = *m_shards[index % n];
+
+      if (m_sparse)
+        {
+          shard.intSlots.push_back((uint32_t)(index / n));
+          shard.intStage.push_back(val);
+        }
+      else
+        {
+          shard.intStage[index / n - shard.intFirst] = val;
+        }
+    }
+
+    void StageBytes(size_t index, const vector<uint8_t> &val)
+    {
+      size_t   n      = m_shards.size();
+      Shard    &shard = *m_shards[index % n];
+      uint32_t slot   = (uint32_t)(index / n);
+      uint32_t length = (uint32_t)val.size();
+
+      shard.bytesStage.insert(shard.bytesStage.end(), (const uint8_t *)&slot, (const uint8_t *)&slot + sizeof(slot));
+      shard.bytesStage.insert(shard.bytesStage.end(), (const uint8_t *)&length, (const uint8_t *)&length + sizeof(length));
+      shard.bytesStage.insert(shard.bytesStage.end(), val.begin(), val.end());
+    }
+
+    void CommitTick();
+
+    RecordPipelineStats GetStats() const;
+};
+
+#endif // __RECORD_PIPELINE__
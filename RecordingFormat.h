@@ -0,0 +1,195 @@
+/*
+
+  FILE: RecordingFormat.h
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    On-disk layout of recording files:
+
+      "REXTREC\0"  uint32 version
+      record*      uint8 (kind << 4 | type), varint channel, float time, varint length, payload
+
+    Channels are declared once (payload is the dataref name) before their first change.
+
+*/
+
+#ifndef __RECORDING_FORMAT__
+#define __RECORDING_FORMAT__
+
+//--------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//--------------------------------------------------------------------------------------------------------------------
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+
+using namespace std;
+
+//--------------------------------------------------------------------------------------------------------------------
+// DEFINES
+//--------------------------------------------------------------------------------------------------------------------
+#define RECORDING_MAGIC        "REXTREC"
+#define RECORDING_VERSION      1
+#define MAX_VARINT32_BYTES     5
+#define MAX_RECORD_OVERHEAD    (1 + MAX_VARINT32_BYTES + sizeof(float) + MAX_VARINT32_BYTES)
+
+enum RecordKind
+{
+  kRecordDeclare = 1,   // payload: dataref name
+  kRecordChange  = 2,   // payload: new value
+  kRecordSession = 3,   // recorders were cleared, times restart
+  kRecordCommit  = 4    // journal only: checksum over the records since the previous commit
+};
+
+enum RecordType
+{
+  kRecordTypeNone  = 0,
+  kRecordTypeFloat = 1,
+  kRecordTypeInt   = 2,
+  kRecordTypeBytes = 3
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT ChangeRecordHeader - fixed size header as queued between threads
+//--------------------------------------------------------------------------------------------------------------------
+struct ChangeRecordHeader
+{
+  uint32_t channel;
+  uint32_t length;
+  float    time;
+  uint8_t  kind;
+  uint8_t  type;
+  uint16_t reserved;
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// Encoding helpers
+//--------------------------------------------------------------------------------------------------------------------
+inline void AppendVarint(vector<uint8_t> &out, uint64_t val)
+{
+  while (val >= 0x80)
+    {
+      out.push_back((uint8_t)(val | 0x80));
+      val >>= 7;
+    }
+  out.push_back((uint8_t)val);
+}
+
+//-----------------------------------------------------------------------------
+inline size_t WriteVarint(uint8_t *out, uint32_t val)
+{
+  size_t len = 0;
+
+  while (val >= 0x80)
+    {
+      out[len++] = (uint8_t)(val | 0x80);
+      val >>= 7;
+    }
+  out[len++] = (uint8_t)val;
+
+  return len;
+}
+
+//-----------------------------------------------------------------------------
+inline bool ReadVarint(const uint8_t *data, size_t size, size_t &pos, uint64_t &outVal)
+{
+  uint64_t val = 0;
+  unsigned shift = 0;
+
+  while ((pos < size) && (shift < 64))
+    {
+      uint8_t b = data[pos++];
+      val |= (uint64_t)(b & 0x7f) << shift;
+      if (!(b & 0x80))
+        {
+          outVal = val;
+          return true;
+        }
+      shift += 7;
+    }
+
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+inline void AppendRecordingFileHeader(vector<uint8_t> &out)
+{
+  uint32_t version = RECORDING_VERSION;
+  out.insert(out.end(), RECORDING_MAGIC, RECORDING_MAGIC + sizeof(RECORDING_MAGIC));
+  out.insert(out.end(), (const uint8_t *)&version, (const uint8_t *)&version + sizeof(version));
+}
+
+//-----------------------------------------------------------------------------
+// Encodes into out, which must hold MAX_RECORD_OVERHEAD + header.length bytes. Returns the encoded size.
+//-----------------------------------------------------------------------------
+inline size_t EncodeRecordTo(uint8_t *out, const ChangeRecordHeader &header, const void *payload)
+{
+  size_t len = 0;
+
+  out[len++] = (uint8_t)((header.kind << 4) | (header.type & 0x0f));
+  len += WriteVarint(&out[len], header.channel);
+  memcpy(&out[len], &header.time, sizeof(header.time));
+  len += sizeof(header.time);
+  len += WriteVarint(&out[len], header.length);
+  if (header.length > 0)
+    {
+      memcpy(&out[len], payload, header.length);
+      len += header.length;
+    }
+
+  return len;
+}
+
+//-----------------------------------------------------------------------------
+inline void EncodeRecord(vector<uint8_t> &out, const ChangeRecordHeader &header, const uint8_t *payload)
+{
+  size_t start = out.size();
+
+  out.resize(start + MAX_RECORD_OVERHEAD + header.length);
+  out.resize(start + EncodeRecordTo(&out[start], header, payload));
+}
+
+//-----------------------------------------------------------------------------
+// Returns false on a truncated or malformed record, pos is left untouched then.
+//-----------------------------------------------------------------------------
+inline bool DecodeRecord(const uint8_t *data, size_t size, size_t &pos,
+                         ChangeRecordHeader &outHeader, const uint8_t *&outPayload)
+{
+  size_t   p = pos;
+  uint64_t channel;
+  uint64_t length;
+
+  if (p >= size)
+    {
+      return false;
+    }
+
+  uint8_t tag = data[p++];
+
+  if (!ReadVarint(data, size, p, channel) || (p + sizeof(float) > size))
+    {
+      return false;
+    }
+
+  memcpy(&outHeader.time, &data[p], sizeof(float));
+  p += sizeof(float);
+
+  if (!ReadVarint(data, size, p, length) || (length > size - p))
+    {
+      return false;
+    }
+
+  outHeader.kind     = tag >> 4;
+  outHeader.type     = tag & 0x0f;
+  outHeader.channel  = (uint32_t)channel;
+  outHeader.length   = (uint32_t)length;
+  outHeader.reserved = 0;
+  outPayload         = &data[p];
+
+  pos = p + length;
+  return true;
+}
+
+#endif // __RECORDING_FORMAT__
@@ -0,0 +1,504 @@
+/*
+
+  FILE: RecordingJournal.cpp
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+*/
+
+#include <stdio.h>
+#include <vector>
+
+#include "RecordingJournal.h"
+#include "TraceBuffer.h"
+
+//--------------------------------------------------------------------------------------------------------------------
+// Crc32Update - reflected CRC-32 (IEEE), table driven
+//--------------------------------------------------------------------------------------------------------------------
+static uint32_t Crc32Update(uint32_t crc, const uint8_t *data, size_t len)
+{
+  static uint32_t table[256];
+  static bool     tableReady = false;
+
+  if (!tableReady)
+    {
+      for (uint32_t i = 0; i < 256; i++)
+        {
+          uint32_t c = i;
+          for (int k = 0; k < 8; k++)
+            {
+              c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+          table[i] = c;
+        }
+      tableReady = true;
+    }
+
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++)
+    {
+      crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+
+  return ~crc;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// RecordingJournal -
+//--------------------------------------------------------------------------------------------------------------------
+RecordingJournal::RecordingJournal()
+{
+  m_header = NULL;
+  m_writePos = 0;
+  m_segmentStart = 0;
+  m_segmentCrc = 0;
+  m_halfBytes = 0;
+  m_lapEnd = 0;
+  m_lapStateEnd = 0;
+  m_recordsAppended = 0;
+  m_recordsOverflowed = 0;
+  m_laps = 0;
+  m_commits = 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ~RecordingJournal -
+//--------------------------------------------------------------------------------------------------------------------
+RecordingJournal::~RecordingJournal()
+{
+  this->Close();
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT RecoveredChannels - what the laps recovered so far hold, a lap starts by repeating it
+//--------------------------------------------------------------------------------------------------------------------
+struct RecoveredChannels
+{
+  vector<bool>  declared;
+  vector<float> lastTime;               // Of the newest change, -1 - none since the session started
+
+  bool Keep(const ChangeRecordHeader &rec)
+  {
+    if (rec.kind == kRecordSession)
+      {
+        lastTime.clear();
+        return true;
+      }
+    if (rec.channel >= declared.size())
+      {
+        declared.resize(rec.channel + 1, false);
+      }
+    if (rec.channel >= lastTime.size())
+      {
+        lastTime.resize(rec.channel + 1, -1.0f);
+      }
+
+    if (rec.kind == kRecordDeclare)
+      {
+        bool repeated = declared[rec.channel];
+        declared[rec.channel] = true;
+        return !repeated;
+      }
+    if (rec.time <= lastTime[rec.channel])
+      {
+        return false;
+      }
+    lastTime[rec.channel] = rec.time;
+    return true;
+  }
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// ScanLap - append the records of one lap that are sealed by a commit marker of its generation, returns their number
+//--------------------------------------------------------------------------------------------------------------------
+static size_t ScanLap(const uint8_t *data, size_t size, uint32_t generation, RecoveredChannels &channels,
+                      vector<uint8_t> &recovered)
+{
+  size_t   pos = 0;
+  size_t   segmentStart = 0;
+  size_t   numRecords = 0;
+  uint32_t crc = 0;
+
+  while (pos < size)
+    {
+      ChangeRecordHeader rec;
+      const uint8_t      *payload;
+      size_t             recStart = pos;
+
+      if (data[pos] == 0 || !DecodeRecord(data, size, pos, rec, payload))
+        {
+          break;
+        }
+
+      if (rec.kind == kRecordCommit)
+        {
+          JournalCommitMarker marker;
+          if ((rec.length != sizeof(marker)))
+            {
+              break;
+            }
+          memcpy(&marker, payload, sizeof(marker));
+
+          if ((marker.generation != generation) ||
+              (marker.length != recStart - segmentStart) ||
+              (marker.checksum != crc))
+            {
+              break;
+            }
+
+          for (size_t at = segmentStart; at < recStart; )
+            {
+              size_t from = at;
+              DecodeRecord(data, recStart, at, rec, payload);
+              if (channels.Keep(rec))
+                {
+                  recovered.insert(recovered.end(), data + from, data + at);
+                  numRecords++;
+                }
+            }
+          segmentStart = pos;
+          crc = 0;
+        }
+      else
+        {
+          crc = Crc32Update(crc, &data[recStart], pos - recStart);
+        }
+    }
+
+  return numRecords;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Recover - scan an unclean journal up to its last valid commit marker, the previous lap first if it is this session's
+//--------------------------------------------------------------------------------------------------------------------
+size_t RecordingJournal::Recover(const string &journalPath, const string &recordingPath)
+{
+  FILE *in = fopen(journalPath.c_str(), "rb");
+  if (in == NULL)
+    {
+      return 0;
+    }
+
+  JournalHeader header;
+  if ((fread(&header, sizeof(header), 1, in) != 1) ||
+      (memcmp(header.magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0) ||
+      (header.version != JOURNAL_VERSION) || !header.active ||
+      (header.capacity <= JOURNAL_DATA_OFFSET) || (header.half > 1))
+    {
+      fclose(in);
+      return 0;
+    }
+
+  vector<uint8_t> data(header.capacity - JOURNAL_DATA_OFFSET);
+  fseek(in, JOURNAL_DATA_OFFSET, SEEK_SET);
+  data.resize(fread(&data[0], 1, data.size(), in));
+  fclose(in);
+
+  size_t halfBytes = (size_t)(header.capacity - JOURNAL_DATA_OFFSET) / 2;
+  if (data.size() < 2 * halfBytes)
+    {
+      return 0;
+    }
+
+  vector<uint8_t>   recovered;
+  RecoveredChannels channels;
+  size_t            numRecords = 0;
+
+  AppendRecordingFileHeader(recovered);
+
+  if (header.generation > header.firstGeneration)
+    {
+      numRecords += ScanLap(&data[(1 - header.half) * halfBytes], halfBytes, header.generation - 1, channels,
+                          recovered);
+    }
+  numRecords += ScanLap(&data[header.half * halfBytes], halfBytes, header.generation, channels, recovered);
+
+  if (numRecords == 0)
+    {
+      return 0;
+    }
+
+  FILE *out = fopen(recordingPath.c_str(), "wb");
+  if (out == NULL)
+    {
+      return 0;
+    }
+
+  size_t written = fwrite(&recovered[0], 1, recovered.size(), out);
+  fclose(out);
+
+  return (written == recovered.size()) ? numRecords : 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Open - map the journal and start a new session in it
+//--------------------------------------------------------------------------------------------------------------------
+bool RecordingJournal::Open(const string &path, size_t capacity)
+{
+  this->Close();
+
+  if ((capacity <= JOURNAL_DATA_OFFSET) || !m_file.Open(path, capacity))
+    {
+      return false;
+    }
+
+  m_header = (JournalHeader *)m_file.Data();
+
+  uint32_t generation = 0;
+  if (memcmp(m_header->magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) == 0)
+    {
+      generation = m_header->generation;
+    }
+
+  memset(m_header, 0, JOURNAL_DATA_OFFSET);
+  memcpy(m_header->magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+  m_header->version         = JOURNAL_VERSION;
+  m_header->generation      = generation + 1;
+  m_header->firstGeneration = generation + 1;
+  m_header->half            = 0;
+  m_header->capacity        = capacity;
+  m_header->committed       = JOURNAL_DATA_OFFSET;
+
+  //
+  // Stale data of the previous session is rejected by its generation, clearing
+  // the first byte just makes an empty session end the scan right away.
+  //
+  m_file.Data()[JOURNAL_DATA_OFFSET] = 0;
+  m_header->active = 1;
+
+  m_writePos = JOURNAL_DATA_OFFSET;
+  m_segmentStart = m_writePos;
+  m_segmentCrc = 0;
+  m_halfBytes = (capacity - JOURNAL_DATA_OFFSET) / 2;
+  m_lapEnd = JOURNAL_DATA_OFFSET + m_halfBytes;
+  m_lapStateEnd = m_writePos;
+  m_declares.clear();
+  m_latest.clear();
+  m_recordsAppended = 0;
+  m_recordsOverflowed = 0;
+  m_laps = 0;
+  m_commits = 0;
+  m_lastCommit = chrono::steady_clock::now();
+
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Close - seal the session and mark it as cleanly closed
+//--------------------------------------------------------------------------------------------------------------------
+void RecordingJournal::Close()
+{
+  if (m_header == NULL)
+    {
+      return;
+    }
+
+  this->Commit();
+  m_header->active = 0;
+  m_file.Sync();
+  m_file.Close();
+  m_header = NULL;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// AppendRaw - encode one record into the lap's half, keeping room for the closing commit marker
+//--------------------------------------------------------------------------------------------------------------------
+bool RecordingJournal::AppendRaw(const ChangeRecordHeader &header, const void *payload)
+{
+  size_t reserve = (header.kind == kRecordCommit) ? 0 : MAX_RECORD_OVERHEAD + sizeof(JournalCommitMarker);
+  size_t needed  = MAX_RECORD_OVERHEAD + header.length;
+
+  if (m_writePos + needed + reserve + 1 > m_lapEnd)
+    {
+      return false;
+    }
+
+  uint8_t *dst = m_file.Data() + m_writePos;
+  size_t   len = EncodeRecordTo(dst, header, payload);
+
+  dst[len] = 0;       // Terminates the scan until the next record lands
+  m_writePos += len;
+
+  if (header.kind != kRecordCommit)
+    {
+      m_segmentCrc = Crc32Update(m_segmentCrc, dst, len);
+    }
+
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Remember - keep what the next lap has to start with
+//--------------------------------------------------------------------------------------------------------------------
+void RecordingJournal::Remember(const ChangeRecordHeader &header, const void *payload)
+{
+  const uint8_t *bytes = (const uint8_t *)payload;
+
+  if (header.kind == kRecordDeclare)
+    {
+      m_declares.push_back(JournalRecord());
+      m_declares.back().header = header;
+      m_declares.back().payload.assign(bytes, bytes + header.length);
+    }
+  else if (header.kind == kRecordChange)
+    {
+      if (header.channel >= m_latest.size())
+        {
+          m_latest.resize(header.channel + 1);
+        }
+      m_latest[header.channel].header = header;
+      m_latest[header.channel].payload.assign(bytes, bytes + header.length);
+    }
+  else if (header.kind == kRecordSession)
+    {
+      m_latest.clear();           // Values restart with the session
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// StartLap - seal the full lap and start the next in the other half with the declares and newest changes. False if
+//            the lap held nothing past those, the other half would not hold more.
+//--------------------------------------------------------------------------------------------------------------------
+bool RecordingJournal::StartLap()
+{
+  if (m_writePos <= m_lapStateEnd)
+    {
+      return false;
+    }
+
+  TRACE_INSTANT("journal_lap");
+  this->Commit();
+
+  //
+  // The new generation is what makes the finished lap the previous one for Recover. Records of the
+  // lap this half held before carry an older generation and end the scan.
+  //
+  uint32_t half = 1 - m_header->half;
+
+  m_writePos     = JOURNAL_DATA_OFFSET + half * m_halfBytes;
+  m_lapEnd       = m_writePos + m_halfBytes;
+  m_segmentStart = m_writePos;
+  m_segmentCrc   = 0;
+  m_file.Data()[m_writePos] = 0;
+
+  m_header->generation++;
+  m_header->half      = half;
+  m_header->committed = m_writePos;
+  m_laps.fetch_add(1, memory_order_relaxed);
+
+  for (size_t i = 0; i < m_declares.size(); i++)
+    {
+      this->AppendRaw(m_declares[i].header, m_declares[i].payload.empty() ? NULL : &m_declares[i].payload[0]);
+    }
+  for (size_t i = 0; i < m_latest.size(); i++)
+    {
+      if (m_latest[i].header.kind == kRecordChange)
+        {
+          this->AppendRaw(m_latest[i].header, m_latest[i].payload.empty() ? NULL : &m_latest[i].payload[0]);
+        }
+    }
+
+  this->Commit();
+  m_lapStateEnd = m_writePos;
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Append - a full lap moves on to the other half
+//--------------------------------------------------------------------------------------------------------------------
+bool RecordingJournal::Append(uint8_t kind, uint8_t type, uint32_t channel, float time,
+                              const void *payload, uint32_t length)
+{
+  if (m_header == NULL)
+    {
+      return false;
+    }
+
+  ChangeRecordHeader header;
+
+  header.channel  = channel;
+  header.length   = length;
+  header.time     = time;
+  header.kind     = kind;
+  header.type     = type;
+  header.reserved = 0;
+
+  bool appended = this->AppendRaw(header, payload) || (this->StartLap() && this->AppendRaw(header, payload));
+
+  this->Remember(header, payload);
+  if (!appended)
+    {
+      m_recordsOverflowed.fetch_add(1, memory_order_relaxed);
+      return false;
+    }
+
+  m_recordsAppended++;
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Commit - seal everything appended since the previous marker
+//--------------------------------------------------------------------------------------------------------------------
+void RecordingJournal::Commit()
+{
+  TRACE_SCOPE("journal_commit");
+
+  m_lastCommit = chrono::steady_clock::now();
+
+  if ((m_header == NULL) || (m_writePos == m_segmentStart))
+    {
+      return;
+    }
+
+  JournalCommitMarker marker;
+  marker.generation = m_header->generation;
+  marker.checksum   = m_segmentCrc;
+  marker.length     = (uint32_t)(m_writePos - m_segmentStart);
+
+  ChangeRecordHeader header;
+  header.channel  = 0;
+  header.length   = sizeof(marker);
+  header.time     = 0.0f;
+  header.kind     = kRecordCommit;
+  header.type     = kRecordTypeNone;
+  header.reserved = 0;
+
+  // AppendRaw always keeps room for this marker
+  this->AppendRaw(header, &marker);
+
+  m_segmentStart = m_writePos;
+  m_segmentCrc = 0;
+  m_header->committed = m_writePos;
+  m_commits++;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// CommitIfDue -
+//--------------------------------------------------------------------------------------------------------------------
+void RecordingJournal::CommitIfDue()
+{
+  if ((m_header != NULL) &&
+      (chrono::steady_clock::now() - m_lastCommit > chrono::milliseconds(JOURNAL_COMMIT_INTERVAL_MS)))
+    {
+      this->Commit();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// GetStats -
+//--------------------------------------------------------------------------------------------------------------------
+RecordingJournalStats RecordingJournal::GetStats() const
+{
+  RecordingJournalStats stats;
+
+  stats.capacity          = m_file.Size();
+  stats.used              = (m_laps > 0) ? m_file.Size() : m_writePos;
+  stats.recordsAppended   = m_recordsAppended;
+  stats.recordsOverflowed = m_recordsOverflowed;
+  stats.commits           = m_commits;
+  stats.laps              = m_laps;
+
+  return stats;
+}
@@ -0,0 +1,152 @@
+/*
+
+  FILE: RecordingJournal.h
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Crash-safe append-only journal of change records. Records are encoded straight into a
+    pre-allocated memory mapped file and sealed by checksummed commit markers. A session that
+    was not closed cleanly can be recovered into a regular recording file on the next start.
+
+    The data region is two halves used in turn, each holding one lap with a generation of
+    its own. A lap starts with the declare records and the newest change of every channel,
+    so it stands on its own. When a lap is full the next overwrites the other half, and
+    recovery returns the previous lap followed by the newest. What is recovered always
+    ends just before the crash and covers at least half the journal.
+
+*/
+
+#ifndef __RECORDING_JOURNAL__
+#define __RECORDING_JOURNAL__
+
+//--------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//--------------------------------------------------------------------------------------------------------------------
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "RecordingFormat.h"
+
+using namespace std;
+
+//--------------------------------------------------------------------------------------------------------------------
+// DEFINES
+//--------------------------------------------------------------------------------------------------------------------
+#define JOURNAL_MAGIC               "REXTJNL"
+#define JOURNAL_VERSION             2
+#define JOURNAL_DATA_OFFSET         64
+#define JOURNAL_COMMIT_INTERVAL_MS  250
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT JournalHeader - first bytes of the journal file
+//--------------------------------------------------------------------------------------------------------------------
+struct JournalHeader
+{
+  char     magic[8];
+  uint32_t version;
+  uint32_t active;        // Set while a session is being written, cleared by a clean close
+  uint32_t generation;    // Bumped for every lap, commit markers carry it
+  uint32_t half;          // Half holding the newest lap
+  uint64_t capacity;
+  uint64_t committed;     // End of the last commit marker, a hint only
+  uint32_t firstGeneration;   // Of the session's first lap, older laps are another session's
+  uint32_t reserved;
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT JournalCommitMarker - payload of a kRecordCommit record
+//--------------------------------------------------------------------------------------------------------------------
+struct JournalCommitMarker
+{
+  uint32_t generation;
+  uint32_t checksum;      // CRC32 over the encoded records since the previous marker
+  uint32_t length;        // Number of bytes covered by checksum
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT RecordingJournalStats
+//--------------------------------------------------------------------------------------------------------------------
+struct RecordingJournalStats
+{
+  size_t   capacity;
+  size_t   used;
+  uint64_t recordsAppended;
+  uint64_t recordsOverflowed;
+  uint64_t commits;
+  uint32_t laps;          // Times a full half was left for the other
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT JournalRecord - a record kept to start the next lap with
+//--------------------------------------------------------------------------------------------------------------------
+struct JournalRecord
+{
+  ChangeRecordHeader header;
+  vector<uint8_t>    payload;
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS RecordingJournal
+//--------------------------------------------------------------------------------------------------------------------
+class RecordingJournal
+{
+  protected:
+    MappedFile           m_file;
+    JournalHeader        *m_header;
+    size_t               m_writePos;
+    size_t               m_segmentStart;
+    uint32_t             m_segmentCrc;
+    size_t               m_halfBytes;
+    size_t               m_lapEnd;
+    size_t               m_lapStateEnd;     // End of the records the lap started with
+    vector<JournalRecord> m_declares;
+    vector<JournalRecord> m_latest;         // Newest change of each channel, indexed by channel id
+    uint64_t             m_recordsAppended;
+    atomic<uint64_t>     m_recordsOverflowed;
+    atomic<uint32_t>     m_laps;
+    uint64_t             m_commits;
+    chrono::steady_clock::time_point m_lastCommit;
+
+    bool AppendRaw(const ChangeRecordHeader &header, const void *payload);
+    void Remember(const ChangeRecordHeader &header, const void *payload);
+    bool StartLap();
+
+  public:
+
+    RecordingJournal();
+    ~RecordingJournal();
+
+    //-----------------------------------------------------------------------------
+    // Recovers the committed part of an unclean session into a recording file.
+    // Returns the number of records recovered, 0 when there was nothing to do.
+    //-----------------------------------------------------------------------------
+    static size_t Recover(const string &journalPath, const string &recordingPath);
+
+    bool Open(const string &path, size_t capacity);
+    void Close();
+
+    bool IsOpen() const { return m_header != NULL; }
+
+    //-----------------------------------------------------------------------------
+    // Flight loop side
+    //-----------------------------------------------------------------------------
+    bool Append(uint8_t kind, uint8_t type, uint32_t channel, float time,
+                const void *payload = NULL, uint32_t length = 0);
+    void Commit();
+    void CommitIfDue();
+
+    RecordingJournalStats GetStats() const;
+
+    //-----------------------------------------------------------------------------
+    // Safe to poll from the sim thread while the writer appends
+    //-----------------------------------------------------------------------------
+    uint32_t NumLaps() const { return m_laps.load(memory_order_relaxed); }
+    uint64_t NumOverflowed() const { return m_recordsOverflowed.load(memory_order_relaxed); }
+};
+
+#endif // __RECORDING_JOURNAL__
@@ -0,0 +1,247 @@
+/*
+
+  FILE: RecordingWriter.cpp
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+*/
+
+#include <algorithm>
+#include <chrono>
+
+#include "RecordingWriter.h"
+#include "TraceBuffer.h"
+
+#define WRITER_IDLE_SLEEP_MS        5
+#define WRITER_FLUSH_BYTES          (64 * 1024)
+#define WRITER_FLUSH_INTERVAL_MS    500
+
+//--------------------------------------------------------------------------------------------------------------------
+// RecordingWriter -
+//--------------------------------------------------------------------------------------------------------------------
+RecordingWriter::RecordingWriter()
+{
+  m_file = NULL;
+  m_journal = NULL;
+  m_running = false;
+  m_recordsWritten = 0;
+  m_bytesWritten = 0;
+  m_writeErrors = 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ~RecordingWriter -
+//--------------------------------------------------------------------------------------------------------------------
+RecordingWriter::~RecordingWriter()
+{
+  this->Stop();
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Start - open the recording file and spawn the I/O thread
+//--------------------------------------------------------------------------------------------------------------------
+bool RecordingWriter::Start(const string &path, RecordingJournal *journal, unsigned numProducers, size_t ringBytes)
+{
+  if (this->IsRunning())
+    {
+      return true;
+    }
+
+  vector<uint8_t> header;
+
+  if (!path.empty())
+    {
+      m_file = fopen(path.c_str(), "wb");
+      if (m_file == NULL)
+        {
+          return false;
+        }
+
+      AppendRecordingFileHeader(header);
+      fwrite(&header[0], 1, header.size(), m_file);
+    }
+
+  m_path = path;
+  m_journal = journal;
+  m_rings.clear();
+  for (unsigned i = 0; i < numProducers; i++)
+    {
+      m_rings.push_back(unique_ptr<SpscRingBuffer>(new SpscRingBuffer(ringBytes)));
+    }
+  m_recordsWritten = 0;
+  m_bytesWritten = header.size();
+  m_writeErrors = 0;
+  m_running = true;
+
+  m_thread = thread(&RecordingWriter::ThreadMain, this);
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Stop - drain whatever is queued, close the file and join the I/O thread
+//--------------------------------------------------------------------------------------------------------------------
+void RecordingWriter::Stop()
+{
+  if (!this->IsRunning())
+    {
+      return;
+    }
+
+  m_running = false;
+  if (m_thread.joinable())
+    {
+      m_thread.join();
+    }
+
+  if (m_file != NULL)
+    {
+      fclose(m_file);
+      m_file = NULL;
+    }
+  m_journal = NULL;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// IsIdle - true once every queued record was taken by the I/O thread
+//--------------------------------------------------------------------------------------------------------------------
+bool RecordingWriter::IsIdle() const
+{
+  for (size_t i = 0; i < m_rings.size(); i++)
+    {
+      if (!m_rings[i]->IsEmpty())
+        {
+          return false;
+        }
+    }
+
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Flush - append encoded records to the file
+//--------------------------------------------------------------------------------------------------------------------
+void RecordingWriter::Flush(vector<uint8_t> &encoded)
+{
+  TRACE_SCOPE("writer_flush");
+
+  if (m_file == NULL)
+    {
+      encoded.clear();
+      return;
+    }
+
+  if (!encoded.empty())
+    {
+      size_t written = fwrite(&encoded[0], 1, encoded.size(), m_file);
+      if (written != encoded.size())
+        {
+          m_writeErrors.fetch_add(1, memory_order_relaxed);
+        }
+      m_bytesWritten.fetch_add(written, memory_order_relaxed);
+      encoded.clear();
+    }
+
+  fflush(m_file);
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ThreadMain - drain the rings, encode and append to the file and the journal
+//--------------------------------------------------------------------------------------------------------------------
+void RecordingWriter::ThreadMain()
+{
+  vector<uint8_t> frame;
+  vector<uint8_t> encoded;
+  chrono::steady_clock::time_point lastFlush = chrono::steady_clock::now();
+
+  gTraceBuffer.NameThread("writer");
+  encoded.reserve(WRITER_FLUSH_BYTES * 2);
+
+  for (;;)
+    {
+      bool running = this->IsRunning();
+      bool drained = false;
+
+      for (size_t i = 0; i < m_rings.size(); i++)
+        {
+          while (m_rings[i]->TryPop(frame))
+            {
+              if (frame.size() < sizeof(ChangeRecordHeader))
+                {
+                  continue;
+                }
+
+              ChangeRecordHeader header;
+              memcpy(&header, &frame[0], sizeof(header));
+
+              if (m_file != NULL)
+                {
+                  EncodeRecord(encoded, header, &frame[sizeof(header)]);
+                }
+              if (m_journal != NULL)
+                {
+                  m_journal->Append(header.kind, header.type, header.channel, header.time,
+                                    &frame[sizeof(header)], header.length);
+                }
+              m_recordsWritten.fetch_add(1, memory_order_relaxed);
+              drained = true;
+
+              if (encoded.size() >= WRITER_FLUSH_BYTES)
+                {
+                  this->Flush(encoded);
+                  lastFlush = chrono::steady_clock::now();
+                }
+            }
+        }
+
+      if (m_journal != NULL)
+        {
+          m_journal->CommitIfDue();
+        }
+
+      chrono::steady_clock::time_point now = chrono::steady_clock::now();
+      if (!running || (now - lastFlush > chrono::milliseconds(WRITER_FLUSH_INTERVAL_MS)))
+        {
+          this->Flush(encoded);
+          lastFlush = now;
+        }
+
+      if (!running)
+        {
+          break;
+        }
+
+      if (!drained)
+        {
+          this_thread::sleep_for(chrono::milliseconds(WRITER_IDLE_SLEEP_MS));
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// GetStats -
+//--------------------------------------------------------------------------------------------------------------------
+RecordingWriterStats RecordingWriter::GetStats() const
+{
+  RecordingWriterStats stats;
+
+  stats.ringCapacity   = 0;
+  stats.ringHighWater  = 0;
+  stats.recordsQueued  = 0;
+  stats.recordsDropped = 0;
+
+  for (size_t i = 0; i < m_rings.size(); i++)
+    {
+      stats.ringCapacity  += m_rings[i]->Capacity();
+      stats.ringHighWater  = max(stats.ringHighWater, m_rings[i]->HighWater());
+      stats.recordsQueued  += m_rings[i]->NumPushed();
+      stats.recordsDropped += m_rings[i]->NumDropped();
+    }
+
+  stats.recordsWritten = m_recordsWritten.load(memory_order_relaxed);
+  stats.bytesWritten   = m_bytesWritten.load(memory_order_relaxed);
+  stats.writeErrors    = m_writeErrors.load(memory_order_relaxed);
+
+  return stats;
+}
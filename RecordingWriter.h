@@ -0,0 +1,102 @@
+/*
+
+  FILE: RecordingWriter.h
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Streams change records to a recording file and the crash journal from a dedicated
+    I/O thread. Every producer thread owns one lock-free ring and never waits for the disk.
+
+*/
+
+#ifndef __RECORDING_WRITER__
+#define __RECORDING_WRITER__
+
+//--------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//--------------------------------------------------------------------------------------------------------------------
+#include <stdio.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <memory>
+
+#include "SpscRingBuffer.h"
+#include "RecordingFormat.h"
+#include "RecordingJournal.h"
+
+using namespace std;
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT RecordingWriterStats
+//--------------------------------------------------------------------------------------------------------------------
+struct RecordingWriterStats
+{
+  size_t   ringCapacity;
+  size_t   ringHighWater;
+  uint64_t recordsQueued;
+  uint64_t recordsDropped;
+  uint64_t recordsWritten;
+  uint64_t bytesWritten;
+  uint64_t writeErrors;
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS RecordingWriter
+//--------------------------------------------------------------------------------------------------------------------
+class RecordingWriter
+{
+  protected:
+    vector<unique_ptr<SpscRingBuffer> > m_rings;    // One per producer thread
+    string               m_path;
+    FILE                 *m_file;
+    RecordingJournal     *m_journal;
+    thread               m_thread;
+    atomic<bool>         m_running;
+    atomic<uint64_t>     m_recordsWritten;
+    atomic<uint64_t>     m_bytesWritten;
+    atomic<uint64_t>     m_writeErrors;
+
+    void ThreadMain();
+    void Flush(vector<uint8_t> &encoded);
+
+  public:
+
+    RecordingWriter();
+    ~RecordingWriter();
+
+    //-----------------------------------------------------------------------------
+    // path may be empty to only feed the journal, journal may be NULL
+    //-----------------------------------------------------------------------------
+    bool Start(const string &path, RecordingJournal *journal, unsigned numProducers, size_t ringBytes);
+    void Stop();
+
+    bool IsRunning() const { return m_running.load(memory_order_relaxed); }
+    bool IsIdle() const;
+    const char *GetPath() const { return m_path.c_str(); }
+
+    //-----------------------------------------------------------------------------
+    // Producer side, each producer thread pushes into its own ring only
+    //-----------------------------------------------------------------------------
+    bool PushRecord(unsigned producer, uint8_t kind, uint8_t type, uint32_t channel, float time,
+                    const void *payload = NULL, uint32_t length = 0)
+    {
+      ChangeRecordHeader header;
+
+      header.channel  = channel;
+      header.length   = length;
+      header.time     = time;
+      header.kind     = kind;
+      header.type     = type;
+      header.reserved = 0;
+
+      return m_rings[producer]->TryPush(&header, sizeof(header), payload, length);
+    }
+
+    RecordingWriterStats GetStats() const;
+};
+
+#endif // __RECORDING_WRITER__
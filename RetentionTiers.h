@@ -0,0 +1,60 @@
+/*
+
+  FILE: RetentionTiers.h
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Tiered retention keeps the recent history at full rate and thins out the old. Once a
+    sealed block of a float or int channel is older than fullSeconds, the record worker
+    moves it down to level 0, keeping only the lowest, the highest and the last sample of
+    every bucketSeconds[0] bucket, each at its own time. Level 0 blocks older than
+    ageSeconds[1] move down to level 1 the same way with wider buckets. Peaks survive at
+    every level, only the detail between them goes.
+
+    Replay takes each time from the finest level holding it. Over a long flight the full
+    rate part stays the same size and the levels grow at a few samples per bucket, so the
+    memory of an 8 hour flight is a small multiple of what the last 20 minutes take.
+
+*/
+
+#ifndef __RETENTION_TIERS__
+#define __RETENTION_TIERS__
+
+//--------------------------------------------------------------------------------------------------------------------
+// DEFINES
+//--------------------------------------------------------------------------------------------------------------------
+#define TIER_LEVELS             2
+#define TIER_FIRST_BUCKET       1.0f        // Seconds per bucket at level 0, each level TIER_BUCKET_FACTOR wider
+#define TIER_BUCKET_FACTOR      10.0f
+#define TIER_AGE_FACTOR         6.0f        // Level k + 1 starts at TIER_AGE_FACTOR times the age level k does
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT RetentionTiers - @retain, shared by every recorder
+//--------------------------------------------------------------------------------------------------------------------
+struct RetentionTiers
+{
+  float fullSeconds;                      // Full rate history, 0 - tiers off
+  float bucketSeconds[TIER_LEVELS];
+  float ageSeconds[TIER_LEVELS];          // Age at which history moves down to each level
+
+  RetentionTiers() { this->Set(0.0f); }
+
+  void Set(float seconds)
+  {
+    float bucket = TIER_FIRST_BUCKET;
+    float age    = seconds;
+
+    fullSeconds = seconds;
+    for (int k = 0; k < TIER_LEVELS; k++, bucket *= TIER_BUCKET_FACTOR, age *= TIER_AGE_FACTOR)
+      {
+        bucketSeconds[k] = bucket;
+        ageSeconds[k]    = age;
+      }
+  }
+
+  bool IsEnabled() const { return fullSeconds > 0.0f; }
+};
+
+#endif // __RETENTION_TIERS__
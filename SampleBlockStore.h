@@ -0,0 +1,683 @@
+/*
+
+  FILE: SampleBlockStore.h
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Time ordered sample history kept as fixed size blocks. New samples go into a small
+    live tail; full tails are sealed and never modified again, eviction only moves the
+    start of the oldest block. The first sample time of every sealed block is the index
+    used for lookups.
+
+    Every sample also has a position that keeps counting across evictions and clears, so
+    a position saved earlier (keyframes) either still names the same sample or is stale.
+
+    With a codec set, sealed blocks are packed: times as varint deltas of deltas, values as the
+    codec encodes them (BlockCodec.h). A lookup in a packed block unpacks it into a one
+    block cache, so sequential replay unpacks each block once.
+
+*/
+
+#ifndef __SAMPLE_BLOCK_STORE__
+#define __SAMPLE_BLOCK_STORE__
+
+//--------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//--------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <vector>
+
+#include "TraceBuffer.h"
+#include "BlockCodec.h"
+
+using namespace std;
+
+//--------------------------------------------------------------------------------------------------------------------
+// DEFINES
+//--------------------------------------------------------------------------------------------------------------------
+#define SAMPLE_BLOCK_SIZE      256
+#define SAMPLE_NO_POSITION     UINT64_MAX
+#define SAMPLE_NO_BLOCK        UINT64_MAX
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT SampleBlock
+//--------------------------------------------------------------------------------------------------------------------
+template <typename T> struct SampleBlock
+{
+  vector<float> times;
+  vector<T>     values;
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT SealedBlock - a full block, packed or not
+//--------------------------------------------------------------------------------------------------------------------
+template <typename T> struct SealedBlock
+{
+  SampleBlock<T>  samples;        // Empty once packed
+  vector<uint8_t> packed;         // Times, then the values from a 4 byte boundary on
+  uint8_t         codec;          // kCodecNone while not packed
+  uint32_t        count;
+  float           firstTime;
+
+  SealedBlock() : codec(kCodecNone), count(0), firstTime(0.0f) {}
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// Heap bytes a sample value owns beyond its own size
+//--------------------------------------------------------------------------------------------------------------------
+template <typename T> inline size_t SampleHeapBytes(const T &)        { return 0; }
+inline size_t SampleHeapBytes(const vector<uint8_t> &val)           { return val.capacity(); }
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS SampleBlockStore
+//--------------------------------------------------------------------------------------------------------------------
+template <typename T> class SampleBlockStore
+{
+  protected:
+    deque<SealedBlock<T> >  m_sealed;
+    SampleBlock<T>          m_tail;
+    SampleBlock<T>          m_spare;        // Evicted or packed block kept around to be reused by the next seal
+    size_t                  m_frontSkip;    // Samples of the oldest block that were evicted
+    size_t                  m_size;
+    uint64_t                m_firstPos;     // Position of the oldest sample
+    BlockCodecId            m_codec;
+    CodecParams             m_codecParams;
+    BlockCodecId            m_lastAuto;     // Codec auto picked for the previous block, tried first
+    size_t                  m_packAt;       // Tail size at which the newest sealed block gets packed, see Append
+    uint64_t                m_frontSerial;  // Serial number of the oldest sealed block
+    mutable SampleBlock<T>  m_cache;        // Packed block unpacked by the latest lookup
+    mutable uint64_t        m_cacheSerial;
+
+    //-----------------------------------------------------------------------------
+    void Seal()
+    {
+      m_sealed.push_back(SealedBlock<T>());
+      SealedBlock<T> &block = m_sealed.back();
+
+      block.count     = (uint32_t)m_tail.times.size();
+      block.firstTime = m_tail.times[0];
+      swap(block.samples, m_tail);
+      swap(m_tail, m_spare);
+
+      m_tail.times.clear();
+      m_tail.values.clear();
+      m_tail.times.reserve(SAMPLE_BLOCK_SIZE);
+      m_tail.values.reserve(SAMPLE_BLOCK_SIZE);
+    }
+
+    //-----------------------------------------------------------------------------
+    // Drops every sample at or after time, reopening the newest sealed block if needed
+    //-----------------------------------------------------------------------------
+    void Truncate(float time)
+    {
+      while (m_size > 0)
+        {
+          if (m_tail.times.empty())
+            {
+              SealedBlock<T> &back = m_sealed.back();
+
+              if (back.codec != kCodecNone)
+                {
+                  this->Unpack(back, m_tail);
+                }
+              else
+                {
+                  swap(m_tail, back.samples);
+                }
+              if (m_cacheSerial == m_frontSerial + m_sealed.size() - 1)
+                {
+                  m_cacheSerial = SAMPLE_NO_BLOCK;
+                }
+              m_sealed.pop_back();
+
+              if (m_sealed.empty() && m_frontSkip > 0)
+                {
+                  m_tail.times.erase(m_tail.times.begin(), m_tail.times.begin() + m_frontSkip);
+                  m_tail.values.erase(m_tail.values.begin(), m_tail.values.begin() + m_frontSkip);
+                  m_frontSkip = 0;
+                }
+            }
+
+          if (m_tail.times.back() < time)
+            {
+              break;
+            }
+
+          m_tail.times.pop_back();
+          m_tail.values.pop_back();
+          m_size--;
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    // Packs the samples of the newest sealed block, the emptied buffers become the spare
+    //-----------------------------------------------------------------------------
+    void Pack(SealedBlock<T> &block)
+    {
+      static thread_local vector<uint8_t> scratch;
+
+      const BlockCodec<T> *codec = GetBlockCodec<T>(m_codec);
+      const BlockCodec<T> *raw   = GetBlockCodec<T>(kCodecRaw);
+      BlockCodecId        id     = m_codec;
+
+      scratch.clear();
+      PackTimes(block.samples.times, scratch);
+      scratch.resize((scratch.size() + 3) & ~(size_t)3);
+      size_t valuesAt = scratch.size();
+
+      if (m_codec == kCodecAuto)
+        {
+          id = this->PackSmallest(block.samples.values, scratch);
+        }
+      else if ((codec == NULL) || !codec->Encode(block.samples.values, m_codecParams, scratch))
+        {
+          id = kCodecRaw;
+          raw->Encode(block.samples.values, m_codecParams, scratch);
+        }
+      GetCodecStats().Add(id, RawValueBytes(block.samples.values), scratch.size() - valuesAt);
+
+      block.packed.assign(scratch.begin(), scratch.end());
+      block.codec = (uint8_t)id;
+      swap(block.samples, m_spare);
+      m_spare.times.clear();
+      m_spare.values.clear();             // Values owning memory free it now rather than at the next seal
+    }
+
+    //-----------------------------------------------------------------------------
+    // Auto, appends the values packed by the candidate giving the fewest bytes. The
+    // previous winner goes first, the rest are tried until the time budget runs out.
+    //-----------------------------------------------------------------------------
+    BlockCodecId PackSmallest(const vector<T> &values, vector<uint8_t> &out)
+    {
+      static thread_local vector<uint8_t> trial;
+
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      BlockCodecId order[kNumBlockCodecs];
+      size_t       numCandidates = 0;
+      BlockCodecId best          = kCodecNone;
+      size_t       valuesAt      = out.size();
+
+      order[numCandidates++] = m_lastAuto;
+      for (int id = kCodecRaw; id < kCodecAuto; id++)
+        {
+          if ((id != m_lastAuto) && IsAutoCandidate<T>((BlockCodecId)id))
+            {
+              order[numCandidates++] = (BlockCodecId)id;
+            }
+        }
+
+      for (size_t c = 0; c < numCandidates; c++)
+        {
+          if ((c > 0) && (m_codecParams.budgetMicros > 0.0f) &&
+              (chrono::duration<float, micro>(chrono::steady_clock::now() - start).count() > m_codecParams.budgetMicros))
+            {
+              break;
+            }
+
+          trial.clear();
+          if (!GetBlockCodec<T>(order[c])->Encode(values, m_codecParams, trial))
+            {
+              continue;
+            }
+          if ((best == kCodecNone) || (trial.size() < out.size() - valuesAt))
+            {
+              out.resize(valuesAt);
+              out.insert(out.end(), trial.begin(), trial.end());
+              best = order[c];
+            }
+        }
+
+      if (best == kCodecNone)
+        {
+          best = kCodecRaw;
+          GetBlockCodec<T>(kCodecRaw)->Encode(values, m_codecParams, out);
+        }
+      m_lastAuto = best;
+      return best;
+    }
+
+    //-----------------------------------------------------------------------------
+    void Unpack(const SealedBlock<T> &block, SampleBlock<T> &out) const
+    {
+      const uint8_t *data   = &block.packed[0];
+      size_t         offset = UnpackTimes(data, block.count, out.times) - data;
+
+      offset = (offset + 3) & ~(size_t)3;
+      GetBlockCodec<T>((BlockCodecId)block.codec)->Decode(data + offset, block.count, out.values);
+    }
+
+    //-----------------------------------------------------------------------------
+    // Samples of sealed block b, from the cache if it is packed
+    //-----------------------------------------------------------------------------
+    const SampleBlock<T> &Sealed(size_t b) const
+    {
+      const SealedBlock<T> &block = m_sealed[b];
+
+      if (block.codec == kCodecNone)
+        {
+          return block.samples;
+        }
+
+      if (m_cacheSerial != m_frontSerial + b)
+        {
+          this->Unpack(block, m_cache);
+          m_cacheSerial = m_frontSerial + b;
+        }
+      return m_cache;
+    }
+
+    //-----------------------------------------------------------------------------
+    // Sealed blocks are always full, so a position maps straight to block and index
+    //-----------------------------------------------------------------------------
+    const SampleBlock<T> &BlockAt(uint64_t pos, size_t &idx) const
+    {
+      size_t offset = (size_t)(pos - m_firstPos) + m_frontSkip;
+      size_t block  = offset / SAMPLE_BLOCK_SIZE;
+
+      idx = offset % SAMPLE_BLOCK_SIZE;
+      return (block < m_sealed.size()) ? this->Sealed(block) : m_tail;
+    }
+
+    //-----------------------------------------------------------------------------
+    // Position of the first sample of the block time falls in, m_firstPos if time is
+    // before all of them. Goes by the block index only, nothing gets unpacked.
+    //-----------------------------------------------------------------------------
+    uint64_t BlockStartFor(float time) const
+    {
+      size_t b = m_sealed.size();
+
+      if (m_tail.times.empty() || (time < m_tail.times.front()))
+        {
+          b = upper_bound(m_sealed.begin(), m_sealed.end(), time,
+                          [](float t, const SealedBlock<T> &block) { return t < block.firstTime; }) - m_sealed.begin();
+          if (b == 0)
+            {
+              return m_firstPos;
+            }
+          b--;
+        }
+
+      return (b == 0) ? m_firstPos : m_firstPos - m_frontSkip + (uint64_t)b * SAMPLE_BLOCK_SIZE;
+    }
+
+    //-----------------------------------------------------------------------------
+    // Last position at or before time, pos being one
+    //-----------------------------------------------------------------------------
+    uint64_t GallopFrom(uint64_t pos, float time) const
+    {
+      uint64_t end  = this->EndPosition();
+      uint64_t lo   = pos;          // Time at lo is <= time
+      uint64_t step = 1;
+
+      while ((lo + step < end) && (this->TimeAt(lo + step) <= time))
+        {
+          lo += step;
+          step *= 2;
+        }
+
+      uint64_t hi = min(lo + step, end);     // Time at hi (if valid) is > time
+      while (hi - lo > 1)
+        {
+          uint64_t mid = lo + (hi - lo) / 2;
+          if (this->TimeAt(mid) <= time)
+            {
+              lo = mid;
+            }
+          else
+            {
+              hi = mid;
+            }
+        }
+
+      return lo;
+    }
+
+    //-----------------------------------------------------------------------------
+    static size_t BlockBytes(const SampleBlock<T> &block)
+    {
+      size_t bytes = block.times.capacity() * sizeof(float) + block.values.capacity() * sizeof(T);
+      for (size_t i = 0; i < block.values.size(); i++)
+        {
+          bytes += SampleHeapBytes(block.values[i]);
+        }
+      return bytes;
+    }
+
+  public:
+
+    //-----------------------------------------------------------------------------
+    SampleBlockStore()
+    {
+      m_frontSkip = 0;
+      m_size = 0;
+      m_firstPos = 0;
+      m_codec = kCodecNone;
+      m_lastAuto = kCodecRaw;
+
+      static atomic<size_t> sNumStores(0);
+      m_packAt = sNumStores.fetch_add(1, memory_order_relaxed) % SAMPLE_BLOCK_SIZE;
+      m_frontSerial = 0;
+      m_cacheSerial = SAMPLE_NO_BLOCK;
+    }
+
+    //-----------------------------------------------------------------------------
+    // How blocks sealed from now on are packed, kCodecNone leaves them as they are,
+    // kCodecAuto picks the smallest lossless packing of each block
+    //-----------------------------------------------------------------------------
+    void SetCodec(BlockCodecId codec, const CodecParams &params)
+    {
+      m_codec       = codec;
+      m_codecParams = params;
+    }
+
+    //-----------------------------------------------------------------------------
+    // Frees the unpacked block kept for lookups, e.g. when replay ends
+    //-----------------------------------------------------------------------------
+    void ReleaseCache()
+    {
+      SampleBlock<T> empty;
+      swap(m_cache, empty);
+      m_cacheSerial = SAMPLE_NO_BLOCK;
+    }
+
+    //-----------------------------------------------------------------------------
+    size_t Size() const { return m_size; }
+    uint64_t BeginPosition() const { return m_firstPos; }
+    uint64_t EndPosition() const { return m_firstPos + m_size; }
+    bool Empty() const { return m_size == 0; }
+
+    //-----------------------------------------------------------------------------
+    float FirstTime() const
+    {
+      return m_sealed.empty() ? m_tail.times[0] : this->Sealed(0).times[m_frontSkip];
+    }
+
+    //-----------------------------------------------------------------------------
+    const T *Last() const
+    {
+      if (!m_tail.values.empty())
+        {
+          return &m_tail.values.back();
+        }
+      else if (!m_sealed.empty())
+        {
+          return &this->Sealed(m_sealed.size() - 1).values.back();
+        }
+
+      return NULL;
+    }
+
+    //-----------------------------------------------------------------------------
+    float LastTime() const
+    {
+      return m_tail.times.empty() ? this->Sealed(m_sealed.size() - 1).times.back() : m_tail.times.back();
+    }
+
+    //-----------------------------------------------------------------------------
+    void Append(float time, const T &val)
+    {
+      if ((m_size > 0) && (time <= this->LastTime()))
+        {
+          this->Truncate(time);
+        }
+
+      if (m_tail.times.size() >= SAMPLE_BLOCK_SIZE)
+        {
+          this->Seal();
+        }
+
+      // Channels recording every tick all seal on the same tick. Each store packs its
+      // block a different number of samples later so the packing is spread out.
+      if ((m_tail.times.size() == m_packAt) && (m_codec != kCodecNone) &&
+          !m_sealed.empty() && (m_sealed.back().codec == kCodecNone))
+        {
+          this->Pack(m_sealed.back());
+        }
+
+      m_tail.times.push_back(time);
+      m_tail.values.push_back(val);
+      m_size++;
+    }
+
+    //-----------------------------------------------------------------------------
+    // Sample at or before time, or the first sample if time is before all of them
+    //-----------------------------------------------------------------------------
+    const T *Find(float time) const
+    {
+      if (m_size == 0)
+        {
+          return NULL;
+        }
+
+      size_t                skip;
+      const SampleBlock<T> &block = this->BlockAt(this->BlockStartFor(time), skip);
+
+      size_t idx = upper_bound(block.times.begin() + skip, block.times.end(), time) - block.times.begin();
+      return &block.values[(idx > skip) ? idx - 1 : skip];
+    }
+
+    //-----------------------------------------------------------------------------
+    // Like Find, starting from a position known to be at or before time. Gallops
+    // forward so the cost depends on the samples after pos, not on the history.
+    //-----------------------------------------------------------------------------
+    const T *FindFrom(uint64_t pos, float time) const
+    {
+      if ((pos < m_firstPos) || (pos >= this->EndPosition()) || (this->TimeAt(pos) > time))
+        {
+          return this->Find(time);
+        }
+
+      return &this->ValueAt(this->GallopFrom(pos, time));
+    }
+
+    //-----------------------------------------------------------------------------
+    // Position of the sample Find would return, SAMPLE_NO_POSITION when empty. A
+    // fromPos at or before time is a hint like the one FindFrom takes.
+    //-----------------------------------------------------------------------------
+    uint64_t FindPosition(float time, uint64_t fromPos = SAMPLE_NO_POSITION) const
+    {
+      if (m_size == 0)
+        {
+          return SAMPLE_NO_POSITION;
+        }
+
+      if ((fromPos < m_firstPos) || (fromPos >= this->EndPosition()) || (this->TimeAt(fromPos) > time))
+        {
+          fromPos = this->BlockStartFor(time);
+        }
+
+      return (time <= this->TimeAt(fromPos)) ? fromPos : this->GallopFrom(fromPos, time);
+    }
+
+    //-----------------------------------------------------------------------------
+    // Sample at a position between BeginPosition and EndPosition
+    //-----------------------------------------------------------------------------
+    float TimeAt(uint64_t pos) const
+    {
+      size_t idx;
+      const SampleBlock<T> &block = this->BlockAt(pos, idx);
+      return block.times[idx];
+    }
+
+    const T &ValueAt(uint64_t pos) const
+    {
+      size_t idx;
+      const SampleBlock<T> &block = this->BlockAt(pos, idx);
+      return block.values[idx];
+    }
+
+    //-----------------------------------------------------------------------------
+    // Moves the newest sample, e.g. the open end of a line segment. The newest
+    // sample is always in the tail, sealed blocks stay untouched.
+    //-----------------------------------------------------------------------------
+    void ReplaceLast(float time, const T &val)
+    {
+      if (!m_tail.times.empty())
+        {
+          m_tail.times.back()  = time;
+          m_tail.values.back() = val;
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    // Evicts the oldest samples until at most maxCount remain
+    //-----------------------------------------------------------------------------
+    void Trim(size_t maxCount)
+    {
+      while (m_size > maxCount)
+        {
+          if (m_sealed.empty())
+            {
+              size_t excess = m_size - maxCount;
+              m_tail.times.erase(m_tail.times.begin(), m_tail.times.begin() + excess);
+              m_tail.values.erase(m_tail.values.begin(), m_tail.values.begin() + excess);
+              m_size = maxCount;
+              m_firstPos += excess;
+              break;
+            }
+
+          SealedBlock<T> &front = m_sealed.front();
+          size_t remaining = front.count - m_frontSkip;
+          size_t excess    = m_size - maxCount;
+
+          if (excess < remaining)
+            {
+              m_frontSkip += excess;
+              m_size -= excess;
+              m_firstPos += excess;
+            }
+          else
+            {
+              TRACE_INSTANT("evict_block");
+              if (front.codec == kCodecNone)
+                {
+                  swap(m_spare, front.samples);
+                }
+              m_sealed.pop_front();
+              m_frontSerial++;
+              m_frontSkip = 0;
+              m_size -= remaining;
+              m_firstPos += remaining;
+            }
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    // Evicts the samples older than time except the newest of them, which is still
+    // the value at time. A packed oldest block goes only as a whole, looking into it
+    // would unpack it on every call.
+    //-----------------------------------------------------------------------------
+    void TrimBefore(float time)
+    {
+      while (!m_sealed.empty() && !m_tail.times.empty())
+        {
+          float next = (m_sealed.size() > 1) ? m_sealed[1].firstTime : m_tail.times[0];
+          if (next > time)
+            {
+              break;
+            }
+          this->Trim(m_size - (m_sealed.front().count - m_frontSkip));
+        }
+
+      if (!m_sealed.empty() && (m_sealed.front().codec != kCodecNone))
+        {
+          return;
+        }
+
+      uint64_t pos = m_firstPos + 1;
+      uint64_t end = this->EndPosition();
+
+      while ((pos < end) && (this->TimeAt(pos) <= time))
+        {
+          pos++;
+        }
+
+      this->Trim((size_t)(end - (pos - 1)));
+    }
+
+    //-----------------------------------------------------------------------------
+    // The oldest sealed block as a unit, for moving history elsewhere (tiered
+    // retention). FrontBlockEnd is the first time after it, so the whole block is
+    // older than that; FrontBlockSize is 0 when there is no such block.
+    //-----------------------------------------------------------------------------
+    size_t FrontBlockSize() const
+    {
+      return (m_sealed.empty() || m_tail.times.empty()) ? 0 : m_sealed.front().count - m_frontSkip;
+    }
+
+    float FrontBlockEnd() const
+    {
+      return (m_sealed.size() > 1) ? m_sealed[1].firstTime : m_tail.times[0];
+    }
+
+    //-----------------------------------------------------------------------------
+    // Evicts the oldest sealed block, its samples left in out. Check FrontBlockSize first.
+    //-----------------------------------------------------------------------------
+    void EvictFrontBlock(SampleBlock<T> &out)
+    {
+      const SealedBlock<T> &front = m_sealed.front();
+
+      if (front.codec != kCodecNone)
+        {
+          this->Unpack(front, out);
+        }
+      else
+        {
+          out.times.assign(front.samples.times.begin(), front.samples.times.end());
+          out.values.assign(front.samples.values.begin(), front.samples.values.end());
+        }
+      out.times.erase(out.times.begin(), out.times.begin() + m_frontSkip);
+      out.values.erase(out.values.begin(), out.values.begin() + m_frontSkip);
+
+      this->Trim(m_size - (front.count - m_frontSkip));
+    }
+
+    //-----------------------------------------------------------------------------
+    // Drops every sample at or after time
+    //-----------------------------------------------------------------------------
+    void TruncateFrom(float time)
+    {
+      if ((m_size > 0) && (time <= this->LastTime()))
+        {
+          this->Truncate(time);
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    void Clear()
+    {
+      m_firstPos += m_size;
+      m_frontSerial += m_sealed.size();
+      m_cacheSerial = SAMPLE_NO_BLOCK;
+      m_sealed.clear();
+      m_tail.times.clear();
+      m_tail.values.clear();
+      m_frontSkip = 0;
+      m_size = 0;
+    }
+
+    //-----------------------------------------------------------------------------
+    size_t NumSealedBlocks() const { return m_sealed.size(); }
+
+    //-----------------------------------------------------------------------------
+    // Heap bytes held, reserved capacity and the spare block included. Walks every
+    // sample for types owning memory, meant for stats rather than the record path.
+    //-----------------------------------------------------------------------------
+    size_t StorageBytes() const
+    {
+      size_t bytes = BlockBytes(m_tail) + BlockBytes(m_spare) + BlockBytes(m_cache) +
+                     m_sealed.size() * sizeof(SealedBlock<T>);
+      for (size_t b = 0; b < m_sealed.size(); b++)
+        {
+          bytes += BlockBytes(m_sealed[b].samples) + m_sealed[b].packed.capacity();
+        }
+      return bytes;
+    }
+};
+
+#endif // __SAMPLE_BLOCK_STORE__
@@ -0,0 +1,215 @@
+/*
+
+  FILE: SpscRingBuffer.h
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Lock-free single-producer/single-consumer ring of variable length frames.
+    The producer never blocks: a frame that does not fit is dropped and counted.
+
+*/
+
+#ifndef __SPSC_RING_BUFFER__
+#define __SPSC_RING_BUFFER__
+
+//--------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//--------------------------------------------------------------------------------------------------------------------
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+
+using namespace std;
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT RingSegment - one piece of a frame pushed by the producer
+//--------------------------------------------------------------------------------------------------------------------
+struct RingSegment
+{
+  const void *data;
+  uint32_t   length;
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS SpscRingBuffer
+//--------------------------------------------------------------------------------------------------------------------
+class SpscRingBuffer
+{
+  protected:
+    vector<uint8_t>      m_buffer;
+    size_t               m_mask;
+    atomic<size_t>       m_head;        // Advanced by the producer only
+    atomic<size_t>       m_tail;        // Advanced by the consumer only
+    atomic<size_t>       m_highWater;
+    atomic<uint64_t>     m_pushed;
+    atomic<uint64_t>     m_dropped;
+
+    //-----------------------------------------------------------------------------
+    void CopyIn(size_t pos, const void *src, size_t len)
+    {
+      size_t offset = pos & m_mask;
+      size_t first  = m_buffer.size() - offset;
+
+      if (first >= len)
+        {
+          memcpy(&m_buffer[offset], src, len);
+        }
+      else
+        {
+          memcpy(&m_buffer[offset], src, first);
+          memcpy(&m_buffer[0], (const uint8_t *)src + first, len - first);
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    void CopyOut(size_t pos, void *dst, size_t len) const
+    {
+      size_t offset = pos & m_mask;
+      size_t first  = m_buffer.size() - offset;
+
+      if (first >= len)
+        {
+          memcpy(dst, &m_buffer[offset], len);
+        }
+      else
+        {
+          memcpy(dst, &m_buffer[offset], first);
+          memcpy((uint8_t *)dst + first, &m_buffer[0], len - first);
+        }
+    }
+
+  public:
+
+    //-----------------------------------------------------------------------------
+    SpscRingBuffer(size_t capacity = 0)
+    {
+      m_mask = 0;
+      m_head = 0;
+      m_tail = 0;
+      m_highWater = 0;
+      m_pushed = 0;
+      m_dropped = 0;
+
+      if (capacity > 0)
+        {
+          this->Init(capacity);
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    // Not thread safe, call before producer and consumer are started.
+    //-----------------------------------------------------------------------------
+    void Init(size_t capacity)
+    {
+      size_t size = 64;
+      while (size < capacity)
+        {
+          size <<= 1;
+        }
+
+      m_buffer.assign(size, 0);
+      m_mask = size - 1;
+      m_head = 0;
+      m_tail = 0;
+      m_highWater = 0;
+      m_pushed = 0;
+      m_dropped = 0;
+    }
+
+    //-----------------------------------------------------------------------------
+    // Producer side. Writes all segments as one frame or nothing at all.
+    //-----------------------------------------------------------------------------
+    bool TryPush(const RingSegment *segments, size_t numSegments)
+    {
+      uint32_t frameLen = 0;
+      for (size_t i = 0; i < numSegments; i++)
+        {
+          frameLen += segments[i].length;
+        }
+
+      size_t   needed   = sizeof(frameLen) + frameLen;
+      size_t   head     = m_head.load(memory_order_relaxed);
+      size_t   tail     = m_tail.load(memory_order_acquire);
+
+      if (m_buffer.empty() || (needed > m_buffer.size() - (head - tail)))
+        {
+          m_dropped.fetch_add(1, memory_order_relaxed);
+          return false;
+        }
+
+      size_t pos = head;
+      this->CopyIn(pos, &frameLen, sizeof(frameLen));
+      pos += sizeof(frameLen);
+
+      for (size_t i = 0; i < numSegments; i++)
+        {
+          if (segments[i].length > 0)
+            {
+              this->CopyIn(pos, segments[i].data, segments[i].length);
+              pos += segments[i].length;
+            }
+        }
+
+      m_head.store(head + needed, memory_order_release);
+      m_pushed.fetch_add(1, memory_order_relaxed);
+
+      size_t used = head + needed - tail;
+      if (used > m_highWater.load(memory_order_relaxed))
+        {
+          m_highWater.store(used, memory_order_relaxed);
+        }
+
+      return true;
+    }
+
+    //-----------------------------------------------------------------------------
+    bool TryPush(const void *header, uint32_t headerLen, const void *payload = NULL, uint32_t payloadLen = 0)
+    {
+      RingSegment segments[2] = { { header, headerLen }, { payload, payloadLen } };
+
+      return this->TryPush(segments, 2);
+    }
+
+    //-----------------------------------------------------------------------------
+    // Consumer side. Copies the oldest frame into outFrame, reusing its storage.
+    //-----------------------------------------------------------------------------
+    bool TryPop(vector<uint8_t> &outFrame)
+    {
+      size_t tail = m_tail.load(memory_order_relaxed);
+      size_t head = m_head.load(memory_order_acquire);
+
+      if (tail == head)
+        {
+          return false;
+        }
+
+      uint32_t frameLen;
+      this->CopyOut(tail, &frameLen, sizeof(frameLen));
+
+      outFrame.resize(frameLen);
+      if (frameLen > 0)
+        {
+          this->CopyOut(tail + sizeof(frameLen), &outFrame[0], frameLen);
+        }
+
+      m_tail.store(tail + sizeof(frameLen) + frameLen, memory_order_release);
+      return true;
+    }
+
+    //-----------------------------------------------------------------------------
+    bool IsEmpty() const
+    {
+      return m_head.load(memory_order_acquire) == m_tail.load(memory_order_acquire);
+    }
+
+    //-----------------------------------------------------------------------------
+    size_t Capacity() const { return m_buffer.size(); }
+    size_t HighWater() const { return m_highWater.load(memory_order_relaxed); }
+    uint64_t NumPushed() const { return m_pushed.load(memory_order_relaxed); }
+    uint64_t NumDropped() const { return m_dropped.load(memory_order_relaxed); }
+};
+
+#endif // __SPSC_RING_BUFFER__
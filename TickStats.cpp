@@ -0,0 +1,80 @@
+/*
+
+  FILE: TickStats.cpp
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+*/
+
+#include <string.h>
+#include <algorithm>
+
+#include "TickStats.h"
+
+using namespace std;
+
+//--------------------------------------------------------------------------------------------------------------------
+// TickStats -
+//--------------------------------------------------------------------------------------------------------------------
+TickStats::TickStats()
+{
+  this->Reset();
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Reset -
+//--------------------------------------------------------------------------------------------------------------------
+void TickStats::Reset()
+{
+  memset(m_phases, 0, sizeof(m_phases));
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Add -
+//--------------------------------------------------------------------------------------------------------------------
+void TickStats::Add(TickPhase phase, float micros)
+{
+  Phase &p = m_phases[phase];
+
+  p.window[p.next] = micros;
+  p.next = (p.next + 1) % TICK_STATS_WINDOW;
+  p.count = min(p.count + 1, (unsigned)TICK_STATS_WINDOW);
+  p.ticks++;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Summary -
+//--------------------------------------------------------------------------------------------------------------------
+TickPhaseSummary TickStats::Summary(TickPhase phase) const
+{
+  const Phase      &p = m_phases[phase];
+  TickPhaseSummary summary;
+
+  memset(&summary, 0, sizeof(summary));
+  summary.ticks = p.ticks;
+  if (p.count == 0)
+    {
+      return summary;
+    }
+
+  float sorted[TICK_STATS_WINDOW];
+  memcpy(sorted, p.window, p.count * sizeof(float));
+  sort(sorted, sorted + p.count);
+
+  summary.p50Us = sorted[p.count / 2];
+  summary.p99Us = sorted[min(p.count - 1, p.count * 99 / 100)];
+  summary.maxUs = sorted[p.count - 1];
+
+  return summary;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// PhaseName - as used in the dataref names
+//--------------------------------------------------------------------------------------------------------------------
+const char *TickStats::PhaseName(TickPhase phase)
+{
+  static const char *names[kNumTickPhases] = { "register", "record", "replay", "restore", "seek" };
+  return names[phase];
+}
@@ -0,0 +1,77 @@
+/*
+
+  FILE: TickStats.h
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Rolling flight loop cost per phase of the plugin. Adding a tick only stores its time
+    in a fixed window; percentiles are worked out when somebody asks, so the cost stays
+    with the reader (the stats datarefs) rather than the sim thread.
+
+*/
+
+#ifndef __TICK_STATS__
+#define __TICK_STATS__
+
+//--------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//--------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+
+//--------------------------------------------------------------------------------------------------------------------
+// DEFINES
+//--------------------------------------------------------------------------------------------------------------------
+#define TICK_STATS_WINDOW       512     // Latest ticks per phase the percentiles cover
+
+enum TickPhase
+{
+  kTickRegister = 0,      // Lazy dataref registration
+  kTickRecord,            // Snapshot for the record pipeline
+  kTickReplay,            // Replay playing on
+  kTickRestore,           // Leaving replay, live values written back
+  kTickSeek,              // Entering replay or jumping in it
+  kNumTickPhases
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT TickPhaseSummary
+//--------------------------------------------------------------------------------------------------------------------
+struct TickPhaseSummary
+{
+  float    p50Us;
+  float    p99Us;
+  float    maxUs;         // Of the window
+  uint64_t ticks;         // Since the last Reset
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS TickStats
+//--------------------------------------------------------------------------------------------------------------------
+class TickStats
+{
+  protected:
+    struct Phase
+    {
+      float    window[TICK_STATS_WINDOW];
+      unsigned next;
+      unsigned count;
+      uint64_t ticks;
+    };
+
+    Phase m_phases[kNumTickPhases];
+
+  public:
+
+    TickStats();
+
+    void Reset();
+    void Add(TickPhase phase, float micros);
+
+    TickPhaseSummary Summary(TickPhase phase) const;
+
+    static const char *PhaseName(TickPhase phase);
+};
+
+#endif // __TICK_STATS__
@@ -0,0 +1,199 @@
+/*
+
+  FILE: ToleranceTuner.cpp
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+*/
+
+#include <algorithm>
+#include <queue>
+
+#include "ToleranceTuner.h"
+
+//--------------------------------------------------------------------------------------------------------------------
+// ToleranceTuner -
+//--------------------------------------------------------------------------------------------------------------------
+ToleranceTuner::ToleranceTuner()
+{
+  m_budgetBytes    = 0.0;
+  m_flightSeconds  = 0.0f;
+  m_startTime      = 0.0f;
+  m_nextCheck      = 0.0f;
+  m_lastTime       = 0.0f;
+  m_lastTuned      = 0.0;
+  m_lastOther      = 0.0;
+  m_bytesPerSample = 0.0;
+  m_correction     = 1.0;
+  m_projected      = 0.0;
+  m_numTunings     = 0;
+  m_measuring      = false;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// SetBudget -
+//--------------------------------------------------------------------------------------------------------------------
+void ToleranceTuner::SetBudget(double bytes, float flightHours)
+{
+  m_budgetBytes   = (bytes > 0.0) ? bytes : 0.0;
+  m_flightSeconds = max(flightHours, 0.0f) * 3600.0f;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Start -
+//--------------------------------------------------------------------------------------------------------------------
+void ToleranceTuner::Start(size_t numChannels, float time, double tunedBytes, double otherBytes)
+{
+  m_probes.assign(numChannels, ToleranceProbe());
+  m_channels.resize(numChannels);
+  m_startTime = time;
+  m_lastTime  = time;
+  m_lastTuned = tunedBytes;
+  m_lastOther = otherBytes;
+  m_nextCheck = time + TUNER_WINDOW_SECONDS;
+  m_measuring = (numChannels > 0);
+  if (!m_measuring)
+    {
+      m_budgetBytes = 0.0;                // Nothing to tune
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ModelRate - bytes per second the tuned channels are expected to add at their current levels
+//--------------------------------------------------------------------------------------------------------------------
+double ToleranceTuner::ModelRate() const
+{
+  double samples = 0.0;
+  for (size_t c = 0; c < m_channels.size(); c++)
+    {
+      samples += m_channels[c].rates[m_channels[c].level];
+    }
+  return samples * m_bytesPerSample * m_correction;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Solve - every channel at its floor, then the next step saving the most bytes per second taken until the model
+//         fits targetRate or nothing more is saved
+//--------------------------------------------------------------------------------------------------------------------
+void ToleranceTuner::Solve(double targetRate)
+{
+  priority_queue<pair<double, size_t> > steps;
+  double scale = m_bytesPerSample * m_correction;
+
+  for (size_t c = 0; c < m_channels.size(); c++)
+    {
+      Channel &ch = m_channels[c];
+
+      ch.level = ch.floor;
+      if (ch.level + 1 < TUNER_LEVELS)
+        {
+          steps.push(make_pair((ch.rates[ch.level] - ch.rates[ch.level + 1]) * scale, c));
+        }
+    }
+
+  double rate = this->ModelRate();
+  while ((rate > targetRate) && !steps.empty() && (steps.top().first > 0.0))
+    {
+      size_t   c  = steps.top().second;
+      Channel &ch = m_channels[c];
+
+      rate -= steps.top().first;
+      steps.pop();
+      ch.level++;
+      if (ch.level + 1 < TUNER_LEVELS)
+        {
+          steps.push(make_pair((ch.rates[ch.level] - ch.rates[ch.level + 1]) * scale, c));
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Update -
+//--------------------------------------------------------------------------------------------------------------------
+bool ToleranceTuner::Update(float time, double tunedBytes, double otherBytes, double tunedSamples)
+{
+  float  dt          = max(time - m_lastTime, 1.0f);
+  double tunedGrowth = max(tunedBytes - m_lastTuned, 0.0) / dt;
+  double otherGrowth = max(otherBytes - m_lastOther, 0.0) / dt;
+  vector<int> before(m_channels.size());
+
+  m_lastTime  = time;
+  m_lastTuned = tunedBytes;
+  m_lastOther = otherBytes;
+  m_nextCheck = time + TUNER_CHECK_SECONDS;
+
+  if (m_measuring)
+    {
+      //
+      // End of the window: sample rates per level and the noise floor of each channel
+      //
+      for (size_t c = 0; c < m_channels.size(); c++)
+        {
+          const ToleranceProbe &probe = m_probes[c];
+          Channel              &ch    = m_channels[c];
+          float                 span  = max(probe.lastTime - probe.firstTime, 1.0f);
+
+          ch.noise = (probe.reads > 3) ? (float)(probe.sumNoise / (probe.reads - 3)) : 0.0f;
+          ch.floor = 0;
+          while ((ch.floor + 1 < TUNER_LEVELS) &&
+                 (TUNER_MIN_TOLERANCE * (float)(1 << ch.floor) < ch.noise * TUNER_NOISE_MARGIN))
+            {
+              ch.floor++;
+            }
+          for (int k = 0; k < TUNER_LEVELS; k++)
+            {
+              ch.rates[k] = (probe.reads > 0) ? probe.counts[k] / span : 0.0f;
+            }
+          ch.level = ch.floor;
+        }
+
+      m_bytesPerSample = (tunedSamples > 0.0) ? tunedBytes / tunedSamples : 8.0;
+      m_correction     = 1.0;
+      m_measuring      = false;
+      vector<ToleranceProbe>().swap(m_probes);
+      for (size_t c = 0; c < m_channels.size(); c++)
+        {
+          before[c] = -1;
+        }
+    }
+  else
+    {
+      double model = this->ModelRate();
+      if (model > 0.0)
+        {
+          double measured = tunedGrowth / model;
+          m_correction *= 0.5 + 0.5 * min(max(measured, 0.1), 10.0);
+        }
+      for (size_t c = 0; c < m_channels.size(); c++)
+        {
+          before[c] = m_channels[c].level;
+        }
+    }
+
+  //
+  // Growth the tuned channels may have to stay within the budget at the end of the flight, or for the next check
+  // once the flight runs longer than planned
+  //
+  float  remaining = max(m_startTime + m_flightSeconds - time, TUNER_CHECK_SECONDS);
+  double target    = max((m_budgetBytes * TUNER_HEADROOM - tunedBytes - otherBytes) / remaining - otherGrowth, 0.0);
+  double model     = this->ModelRate();
+
+  if ((before[0] < 0) || (model > target) || (model < TUNER_SLACK * target))
+    {
+      this->Solve(target);
+    }
+
+  m_projected = tunedBytes + otherBytes + (this->ModelRate() + otherGrowth) * remaining;
+
+  for (size_t c = 0; c < m_channels.size(); c++)
+    {
+      if (m_channels[c].level != before[c])
+        {
+          m_numTunings++;
+          return true;
+        }
+    }
+  return false;
+}
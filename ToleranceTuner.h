@@ -0,0 +1,166 @@
+/*
+
+  FILE: ToleranceTuner.h
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Picks the float recording tolerances of the channels that do not set one so the
+    history fits a memory budget. For the first TUNER_WINDOW_SECONDS a probe on each
+    channel counts how many samples step recording would store at each tolerance of a
+    ladder of powers of two, and how noisy the value is. The mean third difference of the
+    reads cancels any smooth trend and is about the peak to peak size of the noise.
+    Each channel then starts at the lowest tolerance above its noise, and the channels
+    whose next step up saves the most bytes are loosened until the projected growth
+    fits what is left of the budget over the planned flight.
+
+    Every TUNER_CHECK_SECONDS after that the real storage growth is compared with the
+    model and the tolerances are solved again, tighter if there is room and looser if
+    not. The probes only run during the window.
+
+*/
+
+#ifndef __TOLERANCE_TUNER__
+#define __TOLERANCE_TUNER__
+
+//--------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//--------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+
+using namespace std;
+
+//--------------------------------------------------------------------------------------------------------------------
+// DEFINES
+//--------------------------------------------------------------------------------------------------------------------
+#define TUNER_LEVELS            24          // Tolerances TUNER_MIN_TOLERANCE * 2^level
+#define TUNER_MIN_TOLERANCE     (1.0f / 4096.0f)
+#define TUNER_WINDOW_SECONDS    60.0f       // Sim time measured before the first tuning
+#define TUNER_CHECK_SECONDS     30.0f       // Sim time between budget checks after it
+#define TUNER_NOISE_MARGIN      1.0f        // Lowest tolerance in mean third differences, keeps noise out
+#define TUNER_SLACK             0.7f        // Growth within this much of the target is left alone
+#define TUNER_HEADROOM          0.95        // Share of the budget aimed at, the checks lag behind the growth
+#define TUNER_DEFAULT_HOURS     2.0f        // Flight the budget has to last
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT ToleranceProbe - one channel's reads during the window, fed by the recorder on the record worker
+//--------------------------------------------------------------------------------------------------------------------
+struct ToleranceProbe
+{
+  uint32_t reads;
+  float    firstTime;
+  float    lastTime;
+  double   prev[3];                     // Newest first
+  double   sumNoise;                    // |third difference|
+  float    stored[TUNER_LEVELS];        // Last value step recording would have stored at each level
+  uint32_t counts[TUNER_LEVELS];        // Samples it would have stored
+
+  ToleranceProbe() : reads(0), firstTime(0.0f), lastTime(0.0f), sumNoise(0.0) {}
+
+  void Add(float time, double val)
+  {
+    if (reads == 0)
+      {
+        firstTime = time;
+      }
+    if (reads >= 3)
+      {
+        sumNoise += fabs(val - 3.0 * prev[0] + 3.0 * prev[1] - prev[2]);
+      }
+
+    float tol = TUNER_MIN_TOLERANCE;
+    for (int k = 0; k < TUNER_LEVELS; k++, tol *= 2.0f)
+      {
+        if ((reads == 0) || (fabs(val - stored[k]) > tol))
+          {
+            stored[k] = (float)val;
+            counts[k] = (reads == 0) ? 1 : counts[k] + 1;
+          }
+      }
+
+    prev[2]  = prev[1];
+    prev[1]  = prev[0];
+    prev[0]  = val;
+    lastTime = time;
+    reads++;
+  }
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS ToleranceTuner
+//--------------------------------------------------------------------------------------------------------------------
+class ToleranceTuner
+{
+  protected:
+    struct Channel
+    {
+      float    rates[TUNER_LEVELS];     // Samples per second stored at each level, from the window
+      float    noise;
+      int      floor;                   // Lowest level allowed
+      int      level;
+    };
+
+    double                  m_budgetBytes;      // 0 - off
+    float                   m_flightSeconds;
+    vector<ToleranceProbe>  m_probes;           // During the window only
+    vector<Channel>         m_channels;
+    float                   m_startTime;
+    float                   m_nextCheck;
+    float                   m_lastTime;
+    double                  m_lastTuned;        // Storage at the previous check
+    double                  m_lastOther;
+    double                  m_bytesPerSample;   // Measured at the end of the window
+    double                  m_correction;       // Real tuned growth over the model's
+    double                  m_projected;        // Storage expected at the end of the flight
+    unsigned                m_numTunings;
+    bool                    m_measuring;
+
+    double ModelRate() const;
+    void Solve(double targetRate);
+
+  public:
+
+    ToleranceTuner();
+
+    //-----------------------------------------------------------------------------
+    // Memory for all recorded history and the flight length it has to last
+    //-----------------------------------------------------------------------------
+    void SetBudget(double bytes, float flightHours);
+    bool IsEnabled() const { return m_budgetBytes > 0.0; }
+    double GetBudgetBytes() const { return m_budgetBytes; }
+    float GetFlightHours() const { return m_flightSeconds / 3600.0f; }
+
+    //-----------------------------------------------------------------------------
+    // True when Start or Update should be called, a cheap check for every record
+    // tick. Start and the Update ending the window touch the probes the recorders
+    // fill, drain the record workers first.
+    //-----------------------------------------------------------------------------
+    bool IsDue(float time) const { return this->IsEnabled() && (time >= m_nextCheck); }
+    bool IsStarted() const { return !m_channels.empty(); }
+    bool IsMeasuring() const { return m_measuring; }
+
+    //-----------------------------------------------------------------------------
+    // Opens the window for numChannels channels with storage so far tuned and other
+    // bytes. Hand Probe(i) to channel i's recorder until IsMeasuring turns false.
+    //-----------------------------------------------------------------------------
+    void Start(size_t numChannels, float time, double tunedBytes, double otherBytes);
+    ToleranceProbe *Probe(size_t i) { return m_measuring ? &m_probes[i] : NULL; }
+
+    //-----------------------------------------------------------------------------
+    // Storage now of the tuned channels, of all others, and the samples the tuned ones
+    // hold. True if the tolerances changed.
+    //-----------------------------------------------------------------------------
+    bool Update(float time, double tunedBytes, double otherBytes, double tunedSamples);
+
+    size_t NumChannels() const { return m_channels.size(); }
+    float GetTolerance(size_t i) const { return TUNER_MIN_TOLERANCE * (float)(1 << m_channels[i].level); }
+    float GetNoise(size_t i) const { return m_channels[i].noise; }
+    float GetRate(size_t i) const { return m_channels[i].rates[m_channels[i].level]; }
+    double GetProjectedBytes() const { return m_projected; }
+    unsigned NumTunings() const { return m_numTunings; }
+};
+
+#endif // __TOLERANCE_TUNER__
@@ -0,0 +1,192 @@
+/*
+
+  FILE: TraceBuffer.cpp
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+*/
+
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+
+#include "TraceBuffer.h"
+
+TraceBuffer gTraceBuffer;
+
+static thread_local uint32_t tTraceTid = 0;        // 0 - not numbered yet
+
+//--------------------------------------------------------------------------------------------------------------------
+// TraceBuffer -
+//--------------------------------------------------------------------------------------------------------------------
+TraceBuffer::TraceBuffer()
+{
+  m_mask = 0;
+  m_next = 0;
+  m_enabled = false;
+  m_numThreads = 0;
+  m_originNs = 0;
+
+  for (int i = 0; i < TRACE_MAX_THREADS; i++)
+    {
+      m_threadNames[i] = NULL;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Now - steady clock in ns
+//--------------------------------------------------------------------------------------------------------------------
+uint64_t TraceBuffer::Now()
+{
+  return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Start -
+//--------------------------------------------------------------------------------------------------------------------
+bool TraceBuffer::Start(size_t numEvents)
+{
+  if (m_slots || (numEvents == 0))
+    {
+      return false;
+    }
+
+  size_t capacity = 1;
+  while (capacity < numEvents)
+    {
+      capacity *= 2;
+    }
+
+  m_slots.reset(new Slot[capacity]);
+  for (size_t i = 0; i < capacity; i++)
+    {
+      m_slots[i].seq = 0;
+    }
+
+  m_mask     = capacity - 1;
+  m_originNs = Now();
+  m_enabled.store(true, memory_order_release);
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ThreadId - small per thread number, the last one is shared once they run out
+//--------------------------------------------------------------------------------------------------------------------
+static uint32_t ThreadId(atomic<uint32_t> &numThreads)
+{
+  if (tTraceTid == 0)
+    {
+      tTraceTid = min(numThreads.fetch_add(1, memory_order_relaxed) + 1, (uint32_t)TRACE_MAX_THREADS - 1);
+    }
+  return tTraceTid;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// NameThread -
+//--------------------------------------------------------------------------------------------------------------------
+void TraceBuffer::NameThread(const char *name)
+{
+  m_threadNames[ThreadId(m_numThreads)].store(name, memory_order_relaxed);
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Push - claim the next slot and fill it in
+//--------------------------------------------------------------------------------------------------------------------
+void TraceBuffer::Push(char phase, const char *name, uint64_t startNs, uint64_t durNs)
+{
+  if (!this->IsEnabled())
+    {
+      return;
+    }
+
+  uint64_t index = m_next.fetch_add(1, memory_order_relaxed);
+  Slot     &slot = m_slots[index & m_mask];
+
+  slot.seq.store(0, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+
+  slot.name.store(name, memory_order_relaxed);
+  slot.startNs.store(startNs, memory_order_relaxed);
+  slot.durNs.store(durNs, memory_order_relaxed);
+  slot.tid.store(ThreadId(m_numThreads), memory_order_relaxed);
+  slot.phase.store(phase, memory_order_relaxed);
+
+  slot.seq.store(index + 1, memory_order_release);
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Dump -
+//--------------------------------------------------------------------------------------------------------------------
+long TraceBuffer::Dump(const string &path) const
+{
+  if (!m_slots)
+    {
+      return -1;
+    }
+
+  FILE *out = fopen(path.c_str(), "w");
+  if (out == NULL)
+    {
+      return -1;
+    }
+
+  fprintf(out, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+  fprintf(out, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"Replay Extender\"}}");
+
+  uint32_t numThreads = min(m_numThreads.load(memory_order_relaxed), (uint32_t)TRACE_MAX_THREADS - 1);
+  for (uint32_t t = 1; t <= numThreads; t++)
+    {
+      const char *name = m_threadNames[t].load(memory_order_relaxed);
+      fprintf(out, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"%s %u\"}}",
+              t, name ? name : "thread", t);
+    }
+
+  uint64_t end   = m_next.load(memory_order_acquire);
+  uint64_t begin = (end > m_mask + 1) ? end - (m_mask + 1) : 0;
+  long     count = 0;
+
+  for (uint64_t index = begin; index < end; index++)
+    {
+      const Slot &slot = m_slots[index & m_mask];
+
+      if (slot.seq.load(memory_order_acquire) != index + 1)
+        {
+          continue;       // Not finished yet, or already overwritten
+        }
+
+      const char *name    = slot.name.load(memory_order_relaxed);
+      uint64_t    startNs = slot.startNs.load(memory_order_relaxed);
+      uint64_t    durNs   = slot.durNs.load(memory_order_relaxed);
+      uint32_t    tid     = slot.tid.load(memory_order_relaxed);
+      char        phase   = slot.phase.load(memory_order_relaxed);
+
+      atomic_thread_fence(memory_order_acquire);
+      if (slot.seq.load(memory_order_relaxed) != index + 1)
+        {
+          continue;
+        }
+
+      double ts = (startNs > m_originNs) ? (startNs - m_originNs) / 1000.0 : 0.0;
+
+      if (phase == 'X')
+        {
+          fprintf(out, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+                  name, tid, ts, durNs / 1000.0);
+        }
+      else
+        {
+          fprintf(out, ",\n{\"name\": \"%s\", \"ph\": \"i\", \"s\": \"t\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f}",
+                  name, tid, ts);
+        }
+      count++;
+    }
+
+  fprintf(out, "\n]}\n");
+
+  bool ok = (ferror(out) == 0);
+  ok = (fclose(out) == 0) && ok;
+
+  return ok ? count : -1;
+}
@@ -0,0 +1,129 @@
+/*
+
+  FILE: TraceBuffer.h
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Optional in-memory timeline of what the plugin's threads were doing, for stutter
+    reports. Any thread records scoped events into a fixed ring without locks; the ring
+    keeps the newest events and is written out as Chrome trace JSON on demand, which
+    chrome://tracing and ui.perfetto.dev open.
+
+    While tracing is off a TRACE_SCOPE costs one relaxed load and a branch.
+
+*/
+
+#ifndef __TRACE_BUFFER__
+#define __TRACE_BUFFER__
+
+//--------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//--------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+//--------------------------------------------------------------------------------------------------------------------
+// DEFINES
+//--------------------------------------------------------------------------------------------------------------------
+#define TRACE_MAX_THREADS       64
+
+#define TRACE_CONCAT_(a, b)     a##b
+#define TRACE_CONCAT(a, b)      TRACE_CONCAT_(a, b)
+
+// Event names must be string literals, only the pointer is kept
+#define TRACE_SCOPE(name)       TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_INSTANT(name)     do { if (gTraceBuffer.IsEnabled()) gTraceBuffer.Instant(name); } while (0)
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS TraceBuffer
+//--------------------------------------------------------------------------------------------------------------------
+class TraceBuffer
+{
+  protected:
+    //
+    // A slot is only valid while seq holds the index of the event written into it,
+    // writers clear it first so a dump never takes half of an overwritten event
+    //
+    struct Slot
+    {
+      atomic<uint64_t>      seq;
+      atomic<const char *>  name;
+      atomic<uint64_t>      startNs;
+      atomic<uint64_t>      durNs;
+      atomic<uint32_t>      tid;
+      atomic<char>          phase;      // 'X' complete, 'i' instant
+    };
+
+    unique_ptr<Slot[]>              m_slots;
+    size_t                          m_mask;
+    atomic<uint64_t>                m_next;
+    atomic<bool>                    m_enabled;
+    atomic<uint32_t>                m_numThreads;
+    atomic<const char *>            m_threadNames[TRACE_MAX_THREADS];
+    uint64_t                        m_originNs;
+
+    void Push(char phase, const char *name, uint64_t startNs, uint64_t durNs);
+
+  public:
+
+    TraceBuffer();
+
+    //-----------------------------------------------------------------------------
+    // Allocates the ring (rounded up to a power of two) and turns tracing on. Only
+    // once, before other threads trace; the ring is kept until the process exits.
+    //-----------------------------------------------------------------------------
+    bool Start(size_t numEvents);
+    void Disable() { m_enabled.store(false, memory_order_relaxed); }
+
+    bool IsEnabled() const { return m_enabled.load(memory_order_relaxed); }
+
+    //-----------------------------------------------------------------------------
+    // Names the calling thread in the dump, name must be a string literal
+    //-----------------------------------------------------------------------------
+    void NameThread(const char *name);
+
+    void Complete(const char *name, uint64_t startNs, uint64_t endNs) { this->Push('X', name, startNs, endNs - startNs); }
+    void Instant(const char *name) { this->Push('i', name, Now(), 0); }
+
+    //-----------------------------------------------------------------------------
+    // Writes the events still in the ring, returns the number written or -1
+    //-----------------------------------------------------------------------------
+    long Dump(const string &path) const;
+
+    static uint64_t Now();
+};
+
+extern TraceBuffer gTraceBuffer;        // One per plugin, shared by every thread
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS TraceScope - records the enclosing scope as one event
+//--------------------------------------------------------------------------------------------------------------------
+class TraceScope
+{
+  protected:
+    const char *m_name;
+    uint64_t   m_startNs;
+
+  public:
+    explicit TraceScope(const char *name)
+    {
+      m_name    = name;
+      m_startNs = gTraceBuffer.IsEnabled() ? TraceBuffer::Now() : 0;
+    }
+
+    ~TraceScope()
+    {
+      if (m_startNs != 0)
+        {
+          gTraceBuffer.Complete(m_name, m_startNs, TraceBuffer::Now());
+        }
+    }
+};
+
+#endif // __TRACE_BUFFER__
@@ -1,201 +1,496 @@
-/*
-
-  FILE: ValueRecorder.h
-
-  BD-5J Plugin for X-Plane 11
-  Copyright © 2018 by Quantumac
-
-  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
-
-*/
-
-#ifndef __VALUE_RECORDER__
-#define __VALUE_RECORDER__
-
-//--------------------------------------------------------------------------------------------------------------------
-// INCLUDES
-//--------------------------------------------------------------------------------------------------------------------
-#include <map>
-#include <math.h>
-
-using namespace std;
-
-//--------------------------------------------------------------------------------------------------------------------
-// CLASS ValueRecorder
-//--------------------------------------------------------------------------------------------------------------------
-template <typename T> class ValueRecorder
-{
-  protected:
-    typename std::map <float, T> m_record;
-    bool                         m_lastReplayValid;
-    T                            m_lastReplayVal;
-    T                            m_recordTolerance;
-    size_t                       m_maxReplayCount;
-
-  public:
-
-    //-----------------------------------------------------------------------------
-    ValueRecorder(size_t maxReplayCount = 0, T recordTolerance = 0)
-    {
-      m_lastReplayVal      = 0;
-      m_lastReplayValid    = false;
-      m_recordTolerance    = recordTolerance;
-      m_maxReplayCount     = maxReplayCount;
-    }
-
-    //-----------------------------------------------------------------------------
-    bool GetLastRecordedValue(T &outVal)
-    {
-      typename map <float, T>::reverse_iterator iter = m_record.rbegin();
-      if (iter != m_record.rend())
-        {
-          outVal = (*iter).second;
-          return true;
-        }
-      else
-        {
-          return false;
-        }
-    }
-
-    //-----------------------------------------------------------------------------
-    void RecordValue(float elapsedTime, T val)
-    {
-      if (!m_record.empty())
-        {
-          typename map <float, T>::reverse_iterator iter = m_record.rbegin();
-          if (iter != m_record.rend())
-            {
-              T lastVal = (*iter).second;
-
-              T diff = val - lastVal;
-              if (diff < 0)
-                {
-                  diff = -diff;
-                }
-
-              if (diff > m_recordTolerance)
-                {
-                  m_record[elapsedTime] = val;
-                }
-            }
-        }
-      else
-        {
-          m_record[elapsedTime] = val;
-          m_lastReplayVal = 0;
-          m_lastReplayValid = false;
-        }
-
-      if (m_maxReplayCount > 0)
-        {
-          while (m_record.size() > m_maxReplayCount)
-            {
-              typename map <float, T>::iterator iter = m_record.begin();
-              if (iter != m_record.end())
-                {
-                  m_record.erase(iter);
-                }
-              else
-                break;
-            }
-        }
-    }
-
-    //-----------------------------------------------------------------------------
-    bool ReplayValue(float elapsedTime, T &outVal)
-    {
-      bool changed = false;
-
-      //
-      // If elapsed time is greater than or equal to the elapsed time for the last value, use the last value
-      //
-      typename map <float, T>::reverse_iterator revIter = m_record.rbegin();
-      if ((revIter != m_record.rend()) && (elapsedTime >= (*revIter).first))
-        {
-          T val = (*revIter).second;
-          if ((!m_lastReplayValid) || (val != m_lastReplayVal))
-            {
-              changed = true;
-              outVal = val;
-              m_lastReplayVal = outVal;
-              m_lastReplayValid = true;
-            }
-        }
-
-      if (!changed)
-        {
-          //
-          // If the elapsed time is less than or equal to elapsed time for the first value, use the first value
-          //
-          typename map <float, T>::iterator iter = m_record.begin();
-          if ((iter != m_record.end()) && (elapsedTime <= (*iter).first))
-            {
-              T val = (*iter).second;
-              if ((!m_lastReplayValid) || (val != m_lastReplayVal))
-                {
-                  changed = true;
-                  outVal = val;
-                  m_lastReplayVal = val;
-                  m_lastReplayValid = true;
-                }
-            }
-        }
-
-      if (!changed)
-        {
-          //
-          // Find the corresponding elapsed time somewhere in the middle
-          //
-          typename map <float, T>::iterator iter = m_record.lower_bound(elapsedTime);
-          if (iter != m_record.end())
-            {
-              if (iter != m_record.begin())
-                {
-                  if ((*iter).first > elapsedTime)
-                    {
-                      iter--;  // Find the one at the same time or before
-                    }
-
-                  if (elapsedTime >= (*iter).first)
-                    {
-                      T val = (*iter).second;
-
-                      if ((!m_lastReplayValid) || (val != m_lastReplayVal))
-                        {
-                          changed = true;
-                          outVal = val;
-                          m_lastReplayVal = val;
-                          m_lastReplayValid = true;
-                        }
-                    }
-                }
-            }
-        }
-
-      return changed;
-    }
-
-    //-----------------------------------------------------------------------------
-    void Reset()
-    {
-      m_lastReplayVal = 0;
-      m_lastReplayValid = false;
-    }
-
-    //-----------------------------------------------------------------------------
-    void Clear()
-    {
-      m_record.clear();
-      this->Reset();
-    }
-
-    //-----------------------------------------------------------------------------
-    size_t NumEventsRecorded()
-    {
-      return m_record.size();
-    }
-};
-
-#endif // __VALUE_RECORDER__
-
+/*
+
+  FILE: ValueRecorder.h
+
+  BD-5J Plugin for X-Plane 11
+  Copyright © 2018 by Quantumac
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+*/
+
+#ifndef __VALUE_RECORDER__
+#define __VALUE_RECORDER__
+
+//--------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//--------------------------------------------------------------------------------------------------------------------
+#include <math.h>
+#include <stdint.h>
+
+#include "SampleBlockStore.h"
+#include "ToleranceTuner.h"
+#include "RetentionTiers.h"
+
+using namespace std;
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS ValueRecorder
+//--------------------------------------------------------------------------------------------------------------------
+template <typename T> class ValueRecorder
+{
+  protected:
+    SampleBlockStore<T>          m_record;
+    bool                         m_lastReplayValid;
+    T                            m_lastReplayVal;
+    T                            m_recordTolerance;
+    T                            m_tolerance;       // Replay error allowed, shared with a quantizing codec
+    BlockCodecId                 m_codec;
+    CodecParams                  m_codecParams;
+    size_t                       m_maxReplayCount;
+    float                        m_maxReplaySeconds;
+    uint32_t                     m_channelId;
+    bool                         m_linear;
+    bool                         m_segmentOpen;     // The newest sample is the open end of a segment
+    float                        m_pivotTime;       // Vertex the open segment starts at
+    T                            m_pivotVal;
+    double                       m_slopeLo;         // Slopes from the pivot keeping every sample since within
+    double                       m_slopeHi;         // the tolerance
+    ToleranceProbe              *m_probe;           // @autotol window, owned by the tuner
+    const RetentionTiers        *m_tiers;           // @retain, NULL keeps everything at full rate
+    vector<SampleBlockStore<T> > m_levels;          // Thinned out history, level 0 the finest
+    float                        m_levelEnd[TIER_LEVELS];   // First time the level above holds
+    SampleBlock<T>               m_aged;            // Block being moved down
+
+    //-----------------------------------------------------------------------------
+    // Lowest, highest and last sample of every bucket of the block, in time order
+    //-----------------------------------------------------------------------------
+    void Thin(const SampleBlock<T> &block, size_t level)
+    {
+      SampleBlockStore<T> &dest   = m_levels[level];
+      float                bucket = m_tiers->bucketSeconds[level];
+      size_t               n      = block.times.size();
+
+      for (size_t i = 0; i < n; )
+        {
+          float  id = floorf(block.times[i] / bucket);
+          size_t lo = i;
+          size_t hi = i;
+
+          for (i++; (i < n) && (floorf(block.times[i] / bucket) == id); i++)
+            {
+              lo = (block.values[i] < block.values[lo]) ? i : lo;
+              hi = (block.values[i] > block.values[hi]) ? i : hi;
+            }
+
+          size_t first  = min(lo, hi);
+          size_t second = max(lo, hi);
+
+          dest.Append(block.times[first], block.values[first]);
+          if (second != first)
+            {
+              dest.Append(block.times[second], block.values[second]);
+            }
+          if (i - 1 != second)
+            {
+              dest.Append(block.times[i - 1], block.values[i - 1]);
+            }
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    // Full rate blocks past the recent window, or that the keep limits would evict,
+    // move down to level 0, old level blocks one level further
+    //-----------------------------------------------------------------------------
+    void AgeHistory(float elapsedTime)
+    {
+      float cutoff = elapsedTime - m_tiers->fullSeconds;
+      if (m_maxReplaySeconds > 0.0f)
+        {
+          cutoff = max(cutoff, elapsedTime - m_maxReplaySeconds);
+        }
+
+      while ((m_record.FrontBlockSize() > 0) &&
+             ((m_record.FrontBlockEnd() <= cutoff) ||
+              ((m_maxReplayCount > 0) && (m_record.Size() - m_record.FrontBlockSize() >= m_maxReplayCount))))
+        {
+          m_levelEnd[0] = m_record.FrontBlockEnd();
+          m_record.EvictFrontBlock(m_aged);
+          this->Thin(m_aged, 0);
+        }
+
+      for (size_t k = 0; k + 1 < m_levels.size(); k++)
+        {
+          cutoff = elapsedTime - m_tiers->ageSeconds[k + 1];
+          while ((m_levels[k].FrontBlockSize() > 0) && (m_levels[k].FrontBlockEnd() <= cutoff))
+            {
+              m_levelEnd[k + 1] = m_levels[k].FrontBlockEnd();
+              m_levels[k].EvictFrontBlock(m_aged);
+              this->Thin(m_aged, k + 1);
+            }
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    // Finest store holding time
+    //-----------------------------------------------------------------------------
+    const SampleBlockStore<T> &StoreFor(float time) const
+    {
+      const SampleBlockStore<T> *store = &m_record;
+
+      for (size_t k = 0; (k < m_levels.size()) && !m_levels[k].Empty() && (time < m_levelEnd[k]); k++)
+        {
+          store = &m_levels[k];
+        }
+      return *store;
+    }
+
+    //-----------------------------------------------------------------------------
+    // Swinging door. While some line from the pivot stays within the tolerance of
+    // every sample since, the newest vertex is moved along with the samples. Once
+    // none does it becomes final, the next pivot, and a new segment opens.
+    //-----------------------------------------------------------------------------
+    bool RecordVertex(float elapsedTime, T val)
+    {
+      if (m_record.Empty() || (elapsedTime <= m_record.LastTime()))
+        {
+          if (m_record.Empty())
+            {
+              m_lastReplayVal = 0;
+              m_lastReplayValid = false;
+            }
+
+          m_record.Append(elapsedTime, val);
+          m_pivotTime   = elapsedTime;
+          m_pivotVal    = val;
+          m_segmentOpen = false;
+          return true;
+        }
+
+      double dt = elapsedTime - m_pivotTime;
+      double hi = ((double)val + m_recordTolerance - m_pivotVal) / dt;
+      double lo = ((double)val - m_recordTolerance - m_pivotVal) / dt;
+
+      if (m_segmentOpen)
+        {
+          hi = min(hi, m_slopeHi);
+          lo = max(lo, m_slopeLo);
+
+          if (lo <= hi)
+            {
+              m_slopeHi = hi;
+              m_slopeLo = lo;
+              m_record.ReplaceLast(elapsedTime, (T)(m_pivotVal + 0.5 * (lo + hi) * dt));
+              return false;
+            }
+
+          m_pivotTime = m_record.LastTime();
+          m_pivotVal  = *m_record.Last();
+
+          dt = elapsedTime - m_pivotTime;
+          hi = ((double)val + m_recordTolerance - m_pivotVal) / dt;
+          lo = ((double)val - m_recordTolerance - m_pivotVal) / dt;
+        }
+
+      m_record.Append(elapsedTime, val);
+      m_slopeHi     = hi;
+      m_slopeLo     = lo;
+      m_segmentOpen = true;
+      return true;
+    }
+
+  public:
+
+    //-----------------------------------------------------------------------------
+    ValueRecorder(size_t maxReplayCount = 0, T recordTolerance = 0)
+    {
+      m_lastReplayVal      = 0;
+      m_lastReplayValid    = false;
+      m_recordTolerance    = recordTolerance;
+      m_tolerance          = recordTolerance;
+      m_codec              = kCodecNone;
+      m_maxReplayCount     = maxReplayCount;
+      m_maxReplaySeconds   = 0.0f;
+      m_channelId          = 0;
+      m_linear             = false;
+      m_segmentOpen        = false;
+      m_pivotTime          = 0.0f;
+      m_pivotVal           = 0;
+      m_slopeLo            = 0.0;
+      m_slopeHi            = 0.0;
+      m_probe              = NULL;
+      m_tiers              = NULL;
+    }
+
+    //-----------------------------------------------------------------------------
+    uint32_t GetChannelId() { return m_channelId; }
+    void SetChannelId(uint32_t channelId) { m_channelId = channelId; }
+
+    //-----------------------------------------------------------------------------
+    // History kept besides the sample count, in seconds before the newest sample, 0 keeps all
+    //-----------------------------------------------------------------------------
+    void SetMaxReplaySeconds(float seconds) { m_maxReplaySeconds = seconds; }
+
+    //-----------------------------------------------------------------------------
+    // Packing of the sealed history, see BlockCodec.h
+    //-----------------------------------------------------------------------------
+    void SetBlockCodec(BlockCodecId codec, const CodecParams &params)
+    {
+      m_codec       = codec;
+      m_codecParams = params;
+      this->SetRecordTolerance(m_tolerance);
+    }
+
+    //-----------------------------------------------------------------------------
+    // Tiered retention, see RetentionTiers.h. Set before the codec, the levels pack
+    // their blocks the same way.
+    //-----------------------------------------------------------------------------
+    void SetRetention(const RetentionTiers *tiers)
+    {
+      m_tiers = (tiers != NULL) && tiers->IsEnabled() ? tiers : NULL;
+      m_levels.resize((m_tiers != NULL) ? TIER_LEVELS : 0);
+      for (size_t k = 0; k < TIER_LEVELS; k++)
+        {
+          m_levelEnd[k] = 0.0f;
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    // Piecewise linear recording: the tolerance becomes the largest distance of any
+    // sample from the stored line, replay interpolates between the vertices
+    //-----------------------------------------------------------------------------
+    void SetLinear(bool linear) { m_linear = linear; }
+    bool IsLinear() const { return m_linear; }
+
+    //-----------------------------------------------------------------------------
+    // Largest replay error from now on, and the probe measuring every value read
+    // for the tolerance tuner (NULL when not tuning). A quantizing codec moves the
+    // stored values again, so it and the recording deadband get half each.
+    //-----------------------------------------------------------------------------
+    void SetRecordTolerance(T tolerance)
+    {
+      bool quantized = ((m_codec == kCodecQuant8) || (m_codec == kCodecQuant16)) && (GetBlockCodec<T>(m_codec) != NULL);
+
+      m_tolerance       = tolerance;
+      m_recordTolerance = quantized ? (T)(tolerance / 2) : tolerance;
+      if (quantized)
+        {
+          m_codecParams.maxError = (float)m_recordTolerance;
+        }
+
+      m_record.SetCodec(m_codec, m_codecParams);
+      for (size_t k = 0; k < m_levels.size(); k++)
+        {
+          m_levels[k].SetCodec(m_codec, m_codecParams);
+        }
+    }
+    T GetRecordTolerance() const { return m_tolerance; }
+    void SetToleranceProbe(ToleranceProbe *probe) { m_probe = probe; }
+
+    //-----------------------------------------------------------------------------
+    // Position of the newest sample, for keyframes
+    //-----------------------------------------------------------------------------
+    uint64_t LastPosition()
+    {
+      return m_record.Empty() ? SAMPLE_NO_POSITION : (m_record.EndPosition() - 1);
+    }
+
+    //-----------------------------------------------------------------------------
+    bool GetLastRecordedValue(T &outVal)
+    {
+      const T *last = m_record.Last();
+      if (last != NULL)
+        {
+          outVal = *last;
+          return true;
+        }
+      else
+        {
+          return false;
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    bool RecordValue(float elapsedTime, T val)
+    {
+      if (m_probe != NULL)
+        {
+          m_probe->Add(elapsedTime, (double)val);
+        }
+
+      if (!m_levels.empty() && !m_levels[0].Empty() && (elapsedTime < m_levelEnd[0]))
+        {
+          for (size_t k = 0; k < m_levels.size(); k++)
+            {
+              m_levels[k].TruncateFrom(elapsedTime);
+              m_levelEnd[k] = min(m_levelEnd[k], elapsedTime);
+            }
+        }
+
+      if (m_linear)
+        {
+          bool stored = this->RecordVertex(elapsedTime, val);
+          this->TrimHistory(elapsedTime);
+          return stored;
+        }
+
+      bool stored = false;
+
+      const T *last = m_record.Last();
+      if (last != NULL)
+        {
+          T diff = val - *last;
+          if (diff < 0)
+            {
+              diff = -diff;
+            }
+
+          if (diff > m_recordTolerance)
+            {
+              m_record.Append(elapsedTime, val);
+              stored = true;
+            }
+        }
+      else
+        {
+          m_record.Append(elapsedTime, val);
+          m_lastReplayVal = 0;
+          m_lastReplayValid = false;
+          stored = true;
+        }
+
+      this->TrimHistory(elapsedTime);
+      return stored;
+    }
+
+    //-----------------------------------------------------------------------------
+    // With tiers only whole blocks leave the full rate history, all of them thinned
+    // into level 0, so the keep limits hold to within a block
+    //-----------------------------------------------------------------------------
+    void TrimHistory(float elapsedTime)
+    {
+      if (m_tiers != NULL)
+        {
+          this->AgeHistory(elapsedTime);
+          return;
+        }
+      if (m_maxReplayCount > 0)
+        {
+          m_record.Trim(m_maxReplayCount);
+        }
+      if (m_maxReplaySeconds > 0.0f)
+        {
+          m_record.TrimBefore(elapsedTime - m_maxReplaySeconds);
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    bool ReplayValue(float elapsedTime, T &outVal, uint64_t fromPos = SAMPLE_NO_POSITION)
+    {
+      bool changed = false;
+
+      //
+      // Use the value recorded at or before the elapsed time, or the first one if there is none.
+      // A keyframe position lets the lookup start close to the answer. Linear channels interpolate
+      // towards the next vertex.
+      //
+      // Times the full rate history no longer holds come from the tiers, keyframes only
+      // know positions in the full rate history.
+      //
+      const T                   *val    = NULL;
+      const SampleBlockStore<T> &record = this->StoreFor(elapsedTime);
+      T                          interpolated;
+
+      if (&record != &m_record)
+        {
+          fromPos = SAMPLE_NO_POSITION;
+        }
+
+      if (m_linear)
+        {
+          uint64_t pos = record.FindPosition(elapsedTime, fromPos);
+          if (pos != SAMPLE_NO_POSITION)
+            {
+              float t0 = record.TimeAt(pos);
+
+              interpolated = record.ValueAt(pos);
+              if ((pos + 1 < record.EndPosition()) && (elapsedTime > t0))
+                {
+                  float t1 = record.TimeAt(pos + 1);
+                  T     v1 = record.ValueAt(pos + 1);
+
+                  interpolated = (T)(interpolated + (double)(v1 - interpolated) * (elapsedTime - t0) / (t1 - t0));
+                }
+              val = &interpolated;
+            }
+        }
+      else
+        {
+          val = (fromPos != SAMPLE_NO_POSITION) ? record.FindFrom(fromPos, elapsedTime) : record.Find(elapsedTime);
+        }
+
+      if (val != NULL)
+        {
+          if ((!m_lastReplayValid) || (*val != m_lastReplayVal))
+            {
+              changed = true;
+              outVal = *val;
+              m_lastReplayVal = outVal;
+              m_lastReplayValid = true;
+            }
+        }
+
+      return changed;
+    }
+
+    //-----------------------------------------------------------------------------
+    void Reset()
+    {
+      m_lastReplayVal = 0;
+      m_lastReplayValid = false;
+      m_record.ReleaseCache();
+      for (size_t k = 0; k < m_levels.size(); k++)
+        {
+          m_levels[k].ReleaseCache();
+        }
+    }
+
+    //-----------------------------------------------------------------------------
+    void Clear()
+    {
+      m_record.Clear();
+      for (size_t k = 0; k < m_levels.size(); k++)
+        {
+          m_levels[k].Clear();
+        }
+      this->Reset();
+    }
+
+    //-----------------------------------------------------------------------------
+    size_t NumEventsRecorded()
+    {
+      return m_record.Size() + this->NumTierEvents();
+    }
+
+    //-----------------------------------------------------------------------------
+    size_t StorageBytes()
+    {
+      return m_record.StorageBytes() + this->TierStorageBytes();
+    }
+
+    //-----------------------------------------------------------------------------
+    // Part of the above in the tiers
+    //-----------------------------------------------------------------------------
+    size_t NumTierEvents() const
+    {
+      size_t events = 0;
+      for (size_t k = 0; k < m_levels.size(); k++)
+        {
+          events += m_levels[k].Size();
+        }
+      return events;
+    }
+
+    size_t TierStorageBytes() const
+    {
+      size_t bytes = 0;
+      for (size_t k = 0; k < m_levels.size(); k++)
+        {
+          bytes += m_levels[k].StorageBytes();
+        }
+      return bytes;
+    }
+};
+
+#endif // __VALUE_RECORDER__
+
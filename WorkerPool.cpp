@@ -0,0 +1,154 @@
+/*
+
+  FILE: WorkerPool.cpp
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+*/
+
+#include <algorithm>
+
+#include "WorkerPool.h"
+#include "TraceBuffer.h"
+
+//--------------------------------------------------------------------------------------------------------------------
+// WorkerPool -
+//--------------------------------------------------------------------------------------------------------------------
+WorkerPool::WorkerPool()
+{
+  m_job = NULL;
+  m_count = 0;
+  m_chunk = 1;
+  m_next = 0;
+  m_busy = 0;
+  m_generation = 0;
+  m_quit = false;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ~WorkerPool -
+//--------------------------------------------------------------------------------------------------------------------
+WorkerPool::~WorkerPool()
+{
+  this->Stop();
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Start -
+//--------------------------------------------------------------------------------------------------------------------
+void WorkerPool::Start(unsigned numThreads)
+{
+  this->Stop();
+
+  m_quit = false;
+  for (unsigned i = 0; i < numThreads; i++)
+    {
+      m_threads.push_back(thread(&WorkerPool::ThreadMain, this));
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Stop -
+//--------------------------------------------------------------------------------------------------------------------
+void WorkerPool::Stop()
+{
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_quit = true;
+  }
+  m_wake.notify_all();
+
+  for (size_t i = 0; i < m_threads.size(); i++)
+    {
+      m_threads[i].join();
+    }
+  m_threads.clear();
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// RunChunks - grab chunks of the current job until there are none left
+//--------------------------------------------------------------------------------------------------------------------
+void WorkerPool::RunChunks()
+{
+  TRACE_SCOPE("pool_chunks");
+
+  for (;;)
+    {
+      size_t begin = m_next.fetch_add(m_chunk);
+      if (begin >= m_count)
+        {
+          break;
+        }
+
+      (*m_job)(begin, min(begin + m_chunk, m_count));
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ThreadMain -
+//--------------------------------------------------------------------------------------------------------------------
+void WorkerPool::ThreadMain()
+{
+  uint64_t seen = 0;
+
+  gTraceBuffer.NameThread("pool worker");
+
+  for (;;)
+    {
+      {
+        unique_lock<mutex> lock(m_mutex);
+        m_wake.wait(lock, [&] { return m_quit || (m_generation != seen); });
+        if (m_quit)
+          {
+            break;
+          }
+        seen = m_generation;
+      }
+
+      this->RunChunks();
+
+      {
+        lock_guard<mutex> lock(m_mutex);
+        if (--m_busy == 0)
+          {
+            m_done.notify_one();
+          }
+      }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ParallelFor -
+//--------------------------------------------------------------------------------------------------------------------
+void WorkerPool::ParallelFor(size_t count, size_t chunk, const function<void(size_t, size_t)> &job)
+{
+  if (count == 0)
+    {
+      return;
+    }
+
+  if (m_threads.empty() || (count <= chunk))
+    {
+      job(0, count);
+      return;
+    }
+
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_job = &job;
+    m_count = count;
+    m_chunk = (chunk > 0) ? chunk : 1;
+    m_next = 0;
+    m_busy = (unsigned)m_threads.size();
+    m_generation++;
+  }
+  m_wake.notify_all();
+
+  this->RunChunks();
+
+  unique_lock<mutex> lock(m_mutex);
+  m_done.wait(lock, [&] { return m_busy == 0; });
+  m_job = NULL;
+}
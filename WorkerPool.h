@@ -0,0 +1,67 @@
+/*
+
+  FILE: WorkerPool.h
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Small fixed size thread pool for fork/join work the sim thread waits for, like
+    rebuilding every channel's value after a replay seek. The calling thread helps out.
+
+*/
+
+#ifndef __WORKER_POOL__
+#define __WORKER_POOL__
+
+//--------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//--------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//--------------------------------------------------------------------------------------------------------------------
+// CLASS WorkerPool
+//--------------------------------------------------------------------------------------------------------------------
+class WorkerPool
+{
+  protected:
+    vector<thread>                           m_threads;
+    mutex                                    m_mutex;
+    condition_variable                       m_wake;
+    condition_variable                       m_done;
+    const function<void(size_t, size_t)>     *m_job;
+    size_t                                   m_count;
+    size_t                                   m_chunk;
+    atomic<size_t>                           m_next;
+    unsigned                                 m_busy;
+    uint64_t                                 m_generation;
+    bool                                     m_quit;
+
+    void ThreadMain();
+    void RunChunks();
+
+  public:
+
+    WorkerPool();
+    ~WorkerPool();
+
+    void Start(unsigned numThreads);
+    void Stop();
+
+    unsigned NumThreads() const { return (unsigned)m_threads.size(); }
+
+    //-----------------------------------------------------------------------------
+    // Calls job(begin, end) over [0, count) in chunks and returns when all are done
+    //-----------------------------------------------------------------------------
+    void ParallelFor(size_t count, size_t chunk, const function<void(size_t, size_t)> &job);
+};
+
+#endif // __WORKER_POOL__
@@ -0,0 +1,872 @@
+/*
+
+  FILE: XPLMMock.cpp
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <dlfcn.h>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "XPLMMock.h"
+#include "XPLMPlugin.h"
+#include "XPLMProcessing.h"
+#include "XPLMUtilities.h"
+
+using namespace std;
+
+#define MOCK_PLUGIN_ID          1
+
+typedef int  (* XPluginStart_f)(char *outName, char *outSig, char *outDesc);
+typedef void (* XPluginStop_f)(void);
+typedef int  (* XPluginEnable_f)(void);
+typedef void (* XPluginDisable_f)(void);
+typedef void (* XPluginReceiveMessage_f)(XPLMPluginID inFromWho, long inMessage, void *inParam);
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT MockDataRef
+//--------------------------------------------------------------------------------------------------------------------
+struct MockDataRef
+{
+  string            name;
+  XPLMDataTypeID    type;
+  bool              writable;
+  vector<float>     floats;
+  vector<int>       ints;
+  vector<uint8_t>   bytes;
+  double            doubleVal;
+
+  bool              accessor;       // Registered by the plugin, reads and writes go through its callbacks
+  XPLMGetDatai_f    readInt;
+  XPLMSetDatai_f    writeInt;
+  XPLMGetDataf_f    readFloat;
+  XPLMSetDataf_f    writeFloat;
+  XPLMGetDatad_f    readDouble;
+  XPLMSetDatad_f    writeDouble;
+  XPLMGetDatavi_f   readIntArray;
+  XPLMSetDatavi_f   writeIntArray;
+  XPLMGetDatavf_f   readFloatArray;
+  XPLMSetDatavf_f   writeFloatArray;
+  XPLMGetDatab_f    readData;
+  XPLMSetDatab_f    writeData;
+  void              *readRefcon;
+  void              *writeRefcon;
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT MockFlightLoop
+//--------------------------------------------------------------------------------------------------------------------
+struct MockFlightLoop
+{
+  XPLMCreateFlightLoop_t  params;
+  bool                    scheduled;
+  bool                    destroyed;
+  double                  nextTime;       // Seconds, or
+  int                     nextCycle;      // cycles if the last interval was negative
+  bool                    byCycle;
+  double                  lastCallTime;
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT MockMenu
+//--------------------------------------------------------------------------------------------------------------------
+struct MockMenuItem
+{
+  string          name;
+  void            *itemRef;
+  XPLMMenuCheck   check;
+};
+
+struct MockMenu
+{
+  string                name;
+  XPLMMenuHandler_f     handler;
+  void                  *menuRef;
+  vector<MockMenuItem>  items;
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// Mock state
+//--------------------------------------------------------------------------------------------------------------------
+static vector<unique_ptr<MockDataRef> >     sDataRefs;
+static map<string, MockDataRef *>           sDataRefsByName;
+static vector<unique_ptr<MockFlightLoop> >  sFlightLoops;
+static vector<unique_ptr<MockMenu> >        sMenus;
+static MockMenu                             sPluginsMenu;
+static MockMenu                             sAircraftMenu;
+static bool                                 sAircraftPlugin = true;
+static bool                                 sPluginDisabled = false;
+static string                               sPluginPath;
+static MockDebugString_f                    sDebugStringHandler = NULL;
+static double                               sElapsedTime = 0.0;
+static int                                  sCycle = 0;
+
+static MockDataRef                          *sTotalRunningTime = NULL;
+static MockDataRef                          *sIsInReplay = NULL;
+
+static void                                 *sPluginHandle = NULL;
+static XPluginStop_f                        sPluginStop = NULL;
+static XPluginDisable_f                     sPluginDisable = NULL;
+static XPluginReceiveMessage_f              sPluginReceiveMessage = NULL;
+
+//--------------------------------------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------------------------------------
+static MockDataRef *NewDataRef(const char *inName, XPLMDataTypeID inType, int inWritable)
+{
+  MockDataRef *ref = new MockDataRef();
+
+  ref->name      = inName;
+  ref->type      = inType;
+  ref->writable  = (inWritable != 0);
+  ref->doubleVal = 0.0;
+  ref->accessor  = false;
+
+  sDataRefs.push_back(unique_ptr<MockDataRef>(ref));
+  sDataRefsByName[ref->name] = ref;
+
+  return ref;
+}
+
+//-----------------------------------------------------------------------------
+template <typename T> static int ReadArray(const vector<T> &inData, T *outValues, int inOffset, int inMax)
+{
+  if (outValues == NULL)
+    {
+      return (int)inData.size();
+    }
+
+  if ((inOffset < 0) || (inOffset >= (int)inData.size()) || (inMax <= 0))
+    {
+      return 0;
+    }
+
+  int count = min(inMax, (int)inData.size() - inOffset);
+  memcpy(outValues, &inData[inOffset], count * sizeof(T));
+
+  return count;
+}
+
+//-----------------------------------------------------------------------------
+template <typename T> static void WriteArray(vector<T> &ioData, const T *inValues, int inOffset, int inCount)
+{
+  if ((inValues == NULL) || (inOffset < 0) || (inOffset >= (int)ioData.size()) || (inCount <= 0))
+    {
+      return;
+    }
+
+  int count = min(inCount, (int)ioData.size() - inOffset);
+  memcpy(&ioData[inOffset], inValues, count * sizeof(T));
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Dataref table
+//--------------------------------------------------------------------------------------------------------------------
+MOCK_API void MockReset(void)
+{
+  sDataRefs.clear();
+  sDataRefsByName.clear();
+  sFlightLoops.clear();
+  sMenus.clear();
+  sPluginsMenu = MockMenu();
+  sAircraftMenu = MockMenu();
+  sPluginDisabled = false;
+  sElapsedTime = 0.0;
+  sCycle = 0;
+
+  sTotalRunningTime = NewDataRef(MOCK_TOTAL_RUNNING_TIME, xplmType_Float | xplmType_Double, 0);
+  sTotalRunningTime->floats.resize(1);
+  sIsInReplay = NewDataRef(MOCK_IS_IN_REPLAY, xplmType_Int, 0);
+  sIsInReplay->ints.resize(1);
+}
+
+//-----------------------------------------------------------------------------
+MOCK_API XPLMDataRef MockDefineDataRef(const char *inName, XPLMDataTypeID inType, int inSize, int inWritable)
+{
+  if (sTotalRunningTime == NULL)
+    {
+      MockReset();
+    }
+
+  MockDataRef *ref = NewDataRef(inName, inType, inWritable);
+  size_t      size = (inSize > 0) ? (size_t)inSize : 1;
+
+  if (inType & (xplmType_Float | xplmType_FloatArray))
+    {
+      ref->floats.resize(size);
+    }
+  if (inType & (xplmType_Int | xplmType_IntArray))
+    {
+      ref->ints.resize(size);
+    }
+  if (inType & xplmType_Data)
+    {
+      ref->bytes.resize(size);
+    }
+
+  return ref;
+}
+
+MOCK_API size_t MockNumDataRefs(void)   { return sDataRefs.size(); }
+
+MOCK_API float *MockFloatData(XPLMDataRef inDataRef)
+{
+  MockDataRef *ref = (MockDataRef *)inDataRef;
+  return ref->floats.empty() ? NULL : &ref->floats[0];
+}
+
+MOCK_API int *MockIntData(XPLMDataRef inDataRef)
+{
+  MockDataRef *ref = (MockDataRef *)inDataRef;
+  return ref->ints.empty() ? NULL : &ref->ints[0];
+}
+
+MOCK_API uint8_t *MockByteData(XPLMDataRef inDataRef)
+{
+  MockDataRef *ref = (MockDataRef *)inDataRef;
+  return ref->bytes.empty() ? NULL : &ref->bytes[0];
+}
+
+MOCK_API int MockDataSize(XPLMDataRef inDataRef)
+{
+  MockDataRef *ref = (MockDataRef *)inDataRef;
+  return (int)max(ref->bytes.size(), max(ref->floats.size(), ref->ints.size()));
+}
+
+MOCK_API void MockSetTime(float inTotalRunningTime)
+{
+  if (sTotalRunningTime == NULL)
+    {
+      MockReset();
+    }
+  sTotalRunningTime->floats[0] = inTotalRunningTime;
+}
+
+MOCK_API void MockSetInReplay(int inReplay)
+{
+  if (sIsInReplay == NULL)
+    {
+      MockReset();
+    }
+  sIsInReplay->ints[0] = inReplay;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Flight loops
+//--------------------------------------------------------------------------------------------------------------------
+static void Reschedule(MockFlightLoop *loop, float inInterval, bool inRelativeToNow)
+{
+  double base = inRelativeToNow ? sElapsedTime : loop->lastCallTime;
+
+  loop->scheduled = (inInterval != 0.0f);
+  loop->byCycle   = (inInterval < 0.0f);
+  loop->nextTime  = base + inInterval;
+  loop->nextCycle = sCycle + max(1, (int)(-inInterval + 0.5f));
+}
+
+//-----------------------------------------------------------------------------
+MOCK_API int MockRunFlightLoops(float inElapsed)
+{
+  int ran = 0;
+
+  sElapsedTime += inElapsed;
+  sCycle++;
+
+  for (int phase = xplm_FlightLoop_Phase_BeforeFlightModel; phase <= xplm_FlightLoop_Phase_AfterFlightModel; phase++)
+    {
+      for (size_t i = 0; i < sFlightLoops.size(); i++)      // Callbacks may create loops, index rather than iterate
+        {
+          MockFlightLoop *loop = sFlightLoops[i].get();
+
+          if (loop->destroyed || !loop->scheduled || (loop->params.phase != phase))
+            {
+              continue;
+            }
+
+          bool due = loop->byCycle ? (sCycle >= loop->nextCycle) : (sElapsedTime >= loop->nextTime);
+          if (!due)
+            {
+              continue;
+            }
+
+          float sinceLast = (float)(sElapsedTime - loop->lastCallTime);
+          float next      = loop->params.callbackFunc(sinceLast, inElapsed, sCycle, loop->params.refcon);
+          ran++;
+
+          if (!loop->destroyed)
+            {
+              loop->lastCallTime = sElapsedTime;
+              Reschedule(loop, next, true);
+            }
+        }
+    }
+
+  sFlightLoops.erase(remove_if(sFlightLoops.begin(), sFlightLoops.end(),
+                               [](const unique_ptr<MockFlightLoop> &l) { return l->destroyed; }),
+                     sFlightLoops.end());
+
+  return ran;
+}
+
+MOCK_API size_t MockNumFlightLoops(void)
+{
+  size_t n = 0;
+  for (size_t i = 0; i < sFlightLoops.size(); i++)
+    {
+      n += sFlightLoops[i]->destroyed ? 0 : 1;
+    }
+  return n;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// Menus, plugin and log
+//--------------------------------------------------------------------------------------------------------------------
+MOCK_API int MockSelectMenuItem(const char *inItemName)
+{
+  vector<MockMenu *> menus;
+  menus.push_back(&sPluginsMenu);
+  menus.push_back(&sAircraftMenu);
+  for (size_t i = 0; i < sMenus.size(); i++)
+    {
+      menus.push_back(sMenus[i].get());
+    }
+
+  for (size_t m = 0; m < menus.size(); m++)
+    {
+      for (size_t i = 0; i < menus[m]->items.size(); i++)
+        {
+          if ((menus[m]->items[i].name == inItemName) && (menus[m]->handler != NULL))
+            {
+              menus[m]->handler(menus[m]->menuRef, menus[m]->items[i].itemRef);
+              return 1;
+            }
+        }
+    }
+
+  return 0;
+}
+
+MOCK_API void MockSetPluginPath(const char *inPath)                  { sPluginPath = inPath; }
+MOCK_API void MockSetAircraftPlugin(int inIsAircraftPlugin)          { sAircraftPlugin = (inIsAircraftPlugin != 0); }
+MOCK_API int  MockPluginDisabled(void)                               { return sPluginDisabled ? 1 : 0; }
+MOCK_API void MockSetDebugStringHandler(MockDebugString_f inHandler) { sDebugStringHandler = inHandler; }
+
+//--------------------------------------------------------------------------------------------------------------------
+// Plugin host
+//--------------------------------------------------------------------------------------------------------------------
+MOCK_API int MockLoadPlugin(const char *inXplPath)
+{
+  if (sTotalRunningTime == NULL)
+    {
+      MockReset();
+    }
+
+  sPluginHandle = dlopen(inXplPath, RTLD_NOW | RTLD_LOCAL);
+  if (sPluginHandle == NULL)
+    {
+      fprintf(stderr, "MockLoadPlugin: %s\n", dlerror());
+      return 0;
+    }
+
+  XPluginStart_f  start  = (XPluginStart_f)dlsym(sPluginHandle, "XPluginStart");
+  XPluginEnable_f enable = (XPluginEnable_f)dlsym(sPluginHandle, "XPluginEnable");
+  sPluginStop            = (XPluginStop_f)dlsym(sPluginHandle, "XPluginStop");
+  sPluginDisable         = (XPluginDisable_f)dlsym(sPluginHandle, "XPluginDisable");
+  sPluginReceiveMessage  = (XPluginReceiveMessage_f)dlsym(sPluginHandle, "XPluginReceiveMessage");
+
+  if ((start == NULL) || (enable == NULL) || (sPluginStop == NULL) || (sPluginDisable == NULL) ||
+      (sPluginReceiveMessage == NULL))
+    {
+      fprintf(stderr, "MockLoadPlugin: %s does not export the plugin entry points\n", inXplPath);
+      dlclose(sPluginHandle);
+      sPluginHandle = NULL;
+      return 0;
+    }
+
+  if (sPluginPath.empty())
+    {
+      sPluginPath = inXplPath;
+    }
+
+  char name[256], sig[256], desc[256];
+  if (!start(name, sig, desc))
+    {
+      dlclose(sPluginHandle);
+      sPluginHandle = NULL;
+      return 0;
+    }
+
+  if (!sPluginDisabled)
+    {
+      enable();
+    }
+
+  return 1;
+}
+
+MOCK_API void MockSendMessage(int inMessage, void *inParam)
+{
+  if (sPluginHandle != NULL)
+    {
+      sPluginReceiveMessage(0, inMessage, inParam);
+    }
+}
+
+MOCK_API void MockUnloadPlugin(void)
+{
+  if (sPluginHandle == NULL)
+    {
+      return;
+    }
+
+  if (!sPluginDisabled)
+    {
+      sPluginDisable();
+    }
+  sPluginStop();
+
+  dlclose(sPluginHandle);
+  sPluginHandle = NULL;
+}
+
+//====================================================================================================================
+// XPLM API
+//====================================================================================================================
+
+//--------------------------------------------------------------------------------------------------------------------
+// XPLMDataAccess
+//--------------------------------------------------------------------------------------------------------------------
+XPLM_API XPLMDataRef XPLMFindDataRef(const char *inDataRefName)
+{
+  map<string, MockDataRef *>::iterator iter = sDataRefsByName.find(inDataRefName);
+  return (iter != sDataRefsByName.end()) ? iter->second : NULL;
+}
+
+XPLM_API int XPLMCanWriteDataRef(XPLMDataRef inDataRef)
+{
+  return ((inDataRef != NULL) && ((MockDataRef *)inDataRef)->writable) ? 1 : 0;
+}
+
+XPLM_API int XPLMIsDataRefGood(XPLMDataRef inDataRef)
+{
+  return (inDataRef != NULL) ? 1 : 0;
+}
+
+XPLM_API XPLMDataTypeID XPLMGetDataRefTypes(XPLMDataRef inDataRef)
+{
+  return (inDataRef != NULL) ? ((MockDataRef *)inDataRef)->type : xplmType_Unknown;
+}
+
+XPLM_API int XPLMGetDatai(XPLMDataRef inDataRef)
+{
+  MockDataRef *ref = (MockDataRef *)inDataRef;
+  if ((ref == NULL) || !(ref->type & xplmType_Int))
+    {
+      return 0;
+    }
+  return ref->accessor ? (ref->readInt ? ref->readInt(ref->readRefcon) : 0) : ref->ints[0];
+}
+
+XPLM_API void XPLMSetDatai(XPLMDataRef inDataRef, int inValue)
+{
+  MockDataRef *ref = (MockDataRef *)inDataRef;
+  if ((ref == NULL) || !ref->writable || !(ref->type & xplmType_Int))
+    {
+      return;
+    }
+  if (ref->accessor)
+    {
+      if (ref->writeInt) ref->writeInt(ref->writeRefcon, inValue);
+    }
+  else
+    {
+      ref->ints[0] = inValue;
+    }
+}
+
+XPLM_API float XPLMGetDataf(XPLMDataRef inDataRef)
+{
+  MockDataRef *ref = (MockDataRef *)inDataRef;
+  if ((ref == NULL) || !(ref->type & xplmType_Float))
+    {
+      return 0.0f;
+    }
+  return ref->accessor ? (ref->readFloat ? ref->readFloat(ref->readRefcon) : 0.0f) : ref->floats[0];
+}
+
+XPLM_API void XPLMSetDataf(XPLMDataRef inDataRef, float inValue)
+{
+  MockDataRef *ref = (MockDataRef *)inDataRef;
+  if ((ref == NULL) || !ref->writable || !(ref->type & xplmType_Float))
+    {
+      return;
+    }
+  if (ref->accessor)
+    {
+      if (ref->writeFloat) ref->writeFloat(ref->writeRefcon, inValue);
+    }
+  else
+    {
+      ref->floats[0] = inValue;
+    }
+}
+
+XPLM_API double XPLMGetDatad(XPLMDataRef inDataRef)
+{
+  MockDataRef *ref = (MockDataRef *)inDataRef;
+  if ((ref == NULL) || !(ref->type & xplmType_Double))
+    {
+      return 0.0;
+    }
+  if (ref->accessor)
+    {
+      return ref->readDouble ? ref->readDouble(ref->readRefcon) : 0.0;
+    }
+  return ref->floats.empty() ? ref->doubleVal : ref->floats[0];
+}
+
+XPLM_API void XPLMSetDatad(XPLMDataRef inDataRef, double inValue)
+{
+  MockDataRef *ref = (MockDataRef *)inDataRef;
+  if ((ref == NULL) || !ref->writable || !(ref->type & xplmType_Double))
+    {
+      return;
+    }
+  if (ref->accessor)
+    {
+      if (ref->writeDouble) ref->writeDouble(ref->writeRefcon, inValue);
+    }
+  else if (ref->floats.empty())
+    {
+      ref->doubleVal = inValue;
+    }
+  else
+    {
+      ref->floats[0] = (float)inValue;
+    }
+}
+
+XPLM_API int XPLMGetDatavi(XPLMDataRef inDataRef, int *outValues, int inOffset, int inMax)
+{
+  MockDataRef *ref = (MockDataRef *)inDataRef;
+  if ((ref == NULL) || !(ref->type & xplmType_IntArray))
+    {
+      return 0;
+    }
+  if (ref->accessor)
+    {
+      return ref->readIntArray ? ref->readIntArray(ref->readRefcon, outValues, inOffset, inMax) : 0;
+    }
+  return ReadArray(ref->ints, outValues, inOffset, inMax);
+}
+
+XPLM_API void XPLMSetDatavi(XPLMDataRef inDataRef, int *inValues, int inOffset, int inCount)
+{
+  MockDataRef *ref = (MockDataRef *)inDataRef;
+  if ((ref == NULL) || !ref->writable || !(ref->type & xplmType_IntArray))
+    {
+      return;
+    }
+  if (ref->accessor)
+    {
+      if (ref->writeIntArray) ref->writeIntArray(ref->writeRefcon, inValues, inOffset, inCount);
+    }
+  else
+    {
+      WriteArray(ref->ints, inValues, inOffset, inCount);
+    }
+}
+
+XPLM_API int XPLMGetDatavf(XPLMDataRef inDataRef, float *outValues, int inOffset, int inMax)
+{
+  MockDataRef *ref = (MockDataRef *)inDataRef;
+  if ((ref == NULL) || !(ref->type & xplmType_FloatArray))
+    {
+      return 0;
+    }
+  if (ref->accessor)
+    {
+      return ref->readFloatArray ? ref->readFloatArray(ref->readRefcon, outValues, inOffset, inMax) : 0;
+    }
+  return ReadArray(ref->floats, outValues, inOffset, inMax);
+}
+
+XPLM_API void XPLMSetDatavf(XPLMDataRef inDataRef, float *inValues, int inOffset, int inCount)
+{
+  MockDataRef *ref = (MockDataRef *)inDataRef;
+  if ((ref == NULL) || !ref->writable || !(ref->type & xplmType_FloatArray))
+    {
+      return;
+    }
+  if (ref->accessor)
+    {
+      if (ref->writeFloatArray) ref->writeFloatArray(ref->writeRefcon, inValues, inOffset, inCount);
+    }
+  else
+    {
+      WriteArray(ref->floats, inValues, inOffset, inCount);
+    }
+}
+
+XPLM_API int XPLMGetDatab(XPLMDataRef inDataRef, void *outValue, int inOffset, int inMaxBytes)
+{
+  MockDataRef *ref = (MockDataRef *)inDataRef;
+  if ((ref == NULL) || !(ref->type & xplmType_Data))
+    {
+      return 0;
+    }
+  if (ref->accessor)
+    {
+      return ref->readData ? ref->readData(ref->readRefcon, outValue, inOffset, inMaxBytes) : 0;
+    }
+  return ReadArray(ref->bytes, (uint8_t *)outValue, inOffset, inMaxBytes);
+}
+
+XPLM_API void XPLMSetDatab(XPLMDataRef inDataRef, void *inValue, int inOffset, int inLength)
+{
+  MockDataRef *ref = (MockDataRef *)inDataRef;
+  if ((ref == NULL) || !ref->writable || !(ref->type & xplmType_Data))
+    {
+      return;
+    }
+  if (ref->accessor)
+    {
+      if (ref->writeData) ref->writeData(ref->writeRefcon, inValue, inOffset, inLength);
+    }
+  else
+    {
+      WriteArray(ref->bytes, (const uint8_t *)inValue, inOffset, inLength);
+    }
+}
+
+XPLM_API XPLMDataRef XPLMRegisterDataAccessor(const char *inDataName, XPLMDataTypeID inDataType, int inIsWritable,
+                                              XPLMGetDatai_f inReadInt, XPLMSetDatai_f inWriteInt,
+                                              XPLMGetDataf_f inReadFloat, XPLMSetDataf_f inWriteFloat,
+                                              XPLMGetDatad_f inReadDouble, XPLMSetDatad_f inWriteDouble,
+                                              XPLMGetDatavi_f inReadIntArray, XPLMSetDatavi_f inWriteIntArray,
+                                              XPLMGetDatavf_f inReadFloatArray, XPLMSetDatavf_f inWriteFloatArray,
+                                              XPLMGetDatab_f inReadData, XPLMSetDatab_f inWriteData,
+                                              void *inReadRefcon, void *inWriteRefcon)
+{
+  if (sTotalRunningTime == NULL)
+    {
+      MockReset();
+    }
+
+  MockDataRef *ref = NewDataRef(inDataName, inDataType, inIsWritable);
+
+  ref->accessor        = true;
+  ref->readInt         = inReadInt;
+  ref->writeInt        = inWriteInt;
+  ref->readFloat       = inReadFloat;
+  ref->writeFloat      = inWriteFloat;
+  ref->readDouble      = inReadDouble;
+  ref->writeDouble     = inWriteDouble;
+  ref->readIntArray    = inReadIntArray;
+  ref->writeIntArray   = inWriteIntArray;
+  ref->readFloatArray  = inReadFloatArray;
+  ref->writeFloatArray = inWriteFloatArray;
+  ref->readData        = inReadData;
+  ref->writeData       = inWriteData;
+  ref->readRefcon      = inReadRefcon;
+  ref->writeRefcon     = inWriteRefcon;
+
+  return ref;
+}
+
+XPLM_API void XPLMUnregisterDataAccessor(XPLMDataRef inDataRef)
+{
+  MockDataRef *ref = (MockDataRef *)inDataRef;
+  if ((ref == NULL) || !ref->accessor)
+    {
+      return;
+    }
+
+  sDataRefsByName.erase(ref->name);
+  sDataRefs.erase(remove_if(sDataRefs.begin(), sDataRefs.end(),
+                            [ref](const unique_ptr<MockDataRef> &r) { return r.get() == ref; }),
+                  sDataRefs.end());
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// XPLMProcessing
+//--------------------------------------------------------------------------------------------------------------------
+XPLM_API float XPLMGetElapsedTime(void)
+{
+  return (float)sElapsedTime;
+}
+
+XPLM_API int XPLMGetCycleNumber(void)
+{
+  return sCycle;
+}
+
+XPLM_API XPLMFlightLoopID XPLMCreateFlightLoop(XPLMCreateFlightLoop_t *inParams)
+{
+  MockFlightLoop *loop = new MockFlightLoop();
+
+  loop->params       = *inParams;
+  loop->scheduled    = false;
+  loop->destroyed    = false;
+  loop->nextTime     = 0.0;
+  loop->nextCycle    = 0;
+  loop->byCycle      = false;
+  loop->lastCallTime = sElapsedTime;
+
+  sFlightLoops.push_back(unique_ptr<MockFlightLoop>(loop));
+
+  return loop;
+}
+
+XPLM_API void XPLMDestroyFlightLoop(XPLMFlightLoopID inFlightLoopID)
+{
+  MockFlightLoop *loop = (MockFlightLoop *)inFlightLoopID;
+  if (loop != NULL)
+    {
+      loop->destroyed = true;     // Erased after the current MockRunFlightLoops pass
+      loop->scheduled = false;
+    }
+}
+
+XPLM_API void XPLMScheduleFlightLoop(XPLMFlightLoopID inFlightLoopID, float inInterval, int inRelativeToNow)
+{
+  MockFlightLoop *loop = (MockFlightLoop *)inFlightLoopID;
+  if ((loop != NULL) && !loop->destroyed)
+    {
+      Reschedule(loop, inInterval, inRelativeToNow != 0);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// XPLMMenus
+//--------------------------------------------------------------------------------------------------------------------
+XPLM_API XPLMMenuID XPLMFindPluginsMenu(void)
+{
+  return &sPluginsMenu;
+}
+
+XPLM_API XPLMMenuID XPLMFindAircraftMenu(void)
+{
+  return sAircraftPlugin ? &sAircraftMenu : NULL;
+}
+
+XPLM_API XPLMMenuID XPLMCreateMenu(const char *inName, XPLMMenuID inParentMenu, int inParentItem,
+                                   XPLMMenuHandler_f inHandler, void *inMenuRef)
+{
+  MockMenu *menu = new MockMenu();
+
+  menu->name    = inName;
+  menu->handler = inHandler;
+  menu->menuRef = inMenuRef;
+
+  sMenus.push_back(unique_ptr<MockMenu>(menu));
+
+  return menu;
+}
+
+XPLM_API void XPLMDestroyMenu(XPLMMenuID inMenuID)
+{
+  sMenus.erase(remove_if(sMenus.begin(), sMenus.end(),
+                         [inMenuID](const unique_ptr<MockMenu> &m) { return m.get() == inMenuID; }),
+               sMenus.end());
+}
+
+XPLM_API void XPLMClearAllMenuItems(XPLMMenuID inMenuID)
+{
+  ((MockMenu *)inMenuID)->items.clear();
+}
+
+XPLM_API int XPLMAppendMenuItem(XPLMMenuID inMenu, const char *inItemName, void *inItemRef, int inDeprecatedAndIgnored)
+{
+  MockMenu     *menu = (MockMenu *)inMenu;
+  MockMenuItem item;
+
+  item.name    = inItemName;
+  item.itemRef = inItemRef;
+  item.check   = xplm_Menu_NoCheck;
+  menu->items.push_back(item);
+
+  return (int)menu->items.size() - 1;
+}
+
+XPLM_API void XPLMSetMenuItemName(XPLMMenuID inMenu, int inIndex, const char *inItemName, int inDeprecatedAndIgnored)
+{
+  MockMenu *menu = (MockMenu *)inMenu;
+  if ((inIndex >= 0) && (inIndex < (int)menu->items.size()))
+    {
+      menu->items[inIndex].name = inItemName;
+    }
+}
+
+XPLM_API void XPLMCheckMenuItem(XPLMMenuID inMenu, int inIndex, XPLMMenuCheck inCheck)
+{
+  MockMenu *menu = (MockMenu *)inMenu;
+  if ((inIndex >= 0) && (inIndex < (int)menu->items.size()))
+    {
+      menu->items[inIndex].check = inCheck;
+    }
+}
+
+XPLM_API void XPLMCheckMenuItemState(XPLMMenuID inMenu, int inIndex, XPLMMenuCheck *outCheck)
+{
+  MockMenu *menu = (MockMenu *)inMenu;
+  *outCheck = ((inIndex >= 0) && (inIndex < (int)menu->items.size())) ? menu->items[inIndex].check : xplm_Menu_NoCheck;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// XPLMPlugin and XPLMUtilities
+//--------------------------------------------------------------------------------------------------------------------
+XPLM_API XPLMPluginID XPLMGetMyID(void)
+{
+  return MOCK_PLUGIN_ID;
+}
+
+XPLM_API void XPLMGetPluginInfo(XPLMPluginID inPlugin, char *outName, char *outFilePath,
+                                char *outSignature, char *outDescription)
+{
+  if (outName != NULL)        strcpy(outName, "");
+  if (outSignature != NULL)   strcpy(outSignature, "");
+  if (outDescription != NULL) strcpy(outDescription, "");
+  if (outFilePath != NULL)
+    {
+      snprintf(outFilePath, 256, "%s", (inPlugin == MOCK_PLUGIN_ID) ? sPluginPath.c_str() : "");
+    }
+}
+
+XPLM_API void XPLMDisablePlugin(XPLMPluginID inPluginID)
+{
+  if (inPluginID == MOCK_PLUGIN_ID)
+    {
+      sPluginDisabled = true;
+    }
+}
+
+XPLM_API void XPLMEnableFeature(const char *inFeature, int inEnable)
+{
+}
+
+XPLM_API const char *XPLMGetDirectorySeparator(void)
+{
+  return "/";
+}
+
+XPLM_API void XPLMDebugString(const char *inString)
+{
+  if (sDebugStringHandler != NULL)
+    {
+      sDebugStringHandler(inString);
+    }
+  else
+    {
+      fputs(inString, stdout);
+    }
+}
@@ -0,0 +1,90 @@
+/*
+
+  FILE: XPLMMock.h
+
+  Replay Extender Plugin for X-Plane 11
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Stand-in for the X-Plane plugin library so the plugin can be loaded and driven
+    without the sim. The library exports the XPLM calls the plugin uses, backed by an
+    in-memory dataref table, plus the Mock... calls below for the host program that
+    plays the part of X-Plane.
+
+    Linux only: the plugin is built without linking XPLM and picks these symbols up
+    when the host dlopens it, same as inside X-Plane.
+
+*/
+
+#ifndef __XPLM_MOCK__
+#define __XPLM_MOCK__
+
+//--------------------------------------------------------------------------------------------------------------------
+// INCLUDES
+//--------------------------------------------------------------------------------------------------------------------
+#include <stddef.h>
+#include <stdint.h>
+
+#include "XPLMDefs.h"
+#include "XPLMDataAccess.h"
+#include "XPLMMenus.h"
+
+//--------------------------------------------------------------------------------------------------------------------
+// DEFINES
+//--------------------------------------------------------------------------------------------------------------------
+#define MOCK_API extern "C" __attribute__((visibility("default")))
+
+#define MOCK_TOTAL_RUNNING_TIME     "sim/time/total_running_time_sec"
+#define MOCK_IS_IN_REPLAY           "sim/time/is_in_replay"
+
+typedef void (* MockDebugString_f)(const char *inString);
+
+//--------------------------------------------------------------------------------------------------------------------
+// Dataref table. The sim time datarefs above always exist.
+//--------------------------------------------------------------------------------------------------------------------
+MOCK_API void          MockReset(void);
+
+// inSize is the element count of array types and the byte count of xplmType_Data
+MOCK_API XPLMDataRef   MockDefineDataRef(const char *inName, XPLMDataTypeID inType, int inSize, int inWritable);
+MOCK_API size_t        MockNumDataRefs(void);
+
+// Direct access to the storage, bypassing the writable check and any registered accessor
+MOCK_API float         *MockFloatData(XPLMDataRef inDataRef);
+MOCK_API int           *MockIntData(XPLMDataRef inDataRef);
+MOCK_API uint8_t       *MockByteData(XPLMDataRef inDataRef);
+MOCK_API int           MockDataSize(XPLMDataRef inDataRef);
+
+MOCK_API void          MockSetTime(float inTotalRunningTime);
+MOCK_API void          MockSetInReplay(int inReplay);
+
+//--------------------------------------------------------------------------------------------------------------------
+// Flight loops
+//--------------------------------------------------------------------------------------------------------------------
+
+// Advances the sim clock by inElapsed and runs every flight loop that is due, returns how many ran
+MOCK_API int           MockRunFlightLoops(float inElapsed);
+MOCK_API size_t        MockNumFlightLoops(void);
+
+//--------------------------------------------------------------------------------------------------------------------
+// Menus, plugin and log
+//--------------------------------------------------------------------------------------------------------------------
+
+// Calls the handler of the first menu item with this name, returns 0 if there is none
+MOCK_API int           MockSelectMenuItem(const char *inItemName);
+
+// Path XPLMGetPluginInfo reports for the plugin, which decides where it looks for its files
+MOCK_API void          MockSetPluginPath(const char *inPath);
+MOCK_API void          MockSetAircraftPlugin(int inIsAircraftPlugin);
+MOCK_API int           MockPluginDisabled(void);
+
+// NULL writes the log to stdout
+MOCK_API void          MockSetDebugStringHandler(MockDebugString_f inHandler);
+
+//--------------------------------------------------------------------------------------------------------------------
+// Plugin host: load the .xpl, call XPluginStart and XPluginEnable, deliver messages, unload
+//--------------------------------------------------------------------------------------------------------------------
+MOCK_API int           MockLoadPlugin(const char *inXplPath);
+MOCK_API void          MockSendMessage(int inMessage, void *inParam);
+MOCK_API void          MockUnloadPlugin(void);
+
+#endif // __XPLM_MOCK__
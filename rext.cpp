@@ -1,686 +1,2335 @@
-/*
-
-  FILE: rext.cpp
-
-  Replay Extender Plugin for X-Plane 11
-  Created by Todir 2021
-  Derived from
-  BD-5J Plugin for X-Plane 11
-  Copyright � 2019 by Quantumac
-
-  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
-
-    Record and replay additional dataref values.
-
-*/
-
-
-#include <string.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <stdint.h>
-#include <math.h>
-#include <vector>
-#include <string>
-#include <list>
-#include <map>
-#include <iostream>
-#include <fstream>
-#include <queue>
-#include <stdbool.h>
-#include <algorithm>
-#include <utility>
-
-#include "XPLMPlugin.h"
-#include "XPLMProcessing.h"
-#include "XPLMDataAccess.h"
-#include "XPLMUtilities.h"
-#include "XPLMMenus.h"
-
-#include "DebugPrint.h"
-#include "DataRefRecorder.h"
-
-#define _STR(x) #x
-#define STR(x) _STR(x)
-
-using namespace std;
-
-static void LoadConf();
-static void RegisterDrefs();
-
-static float AfterFlightModelLoopCallBack(float   inElapsedSinceLastCall,
-                                          float   inElapsedTimeSinceLastFlightLoop,
-                                          int     inCounter,
-                                          void    *inRefcon);
-
-
-static void ClearReplayRecorders();
-
-static void HandleRecordAndReplayOfExternalDataRefs(float totalRunningTime,
-                                                    int inReplay,
-                                                    int replayTransition);
-
-static void HandleAirplaneLoaded();
-
-static void GetConfFilePath(string &confPath);
-
-static void GetAircraftPluginFilePath(string &pluginFilePath);
-
-static void GetAircraftPluginTopDirPath(string &pluginDirPath);
-
-static void RegisterPrimaryCallbacks();
-static void UnregisterPrimaryCallbacks();
-
-static void PrintRecorderStatsToLog();
-
-static void menu_handler(void *, void *);
-
-static const char *sPluginName                          = "Replay Extender Plugin";
-static const char *sPluginSig                           =  STR(BUILD_VERSION);//defined in makefile
-static const char *sPluginDescription                   = "Replay Extender for X-Plane";
-
-static const char *sTotalRunningTimeDataRefName         = "sim/time/total_running_time_sec";
-static const char *sInReplayModeDataRefName             = "sim/time/is_in_replay";
-
-
-static XPLMDataRef            sTotalRunningTimeDataRef           = NULL;
-static XPLMDataRef            sInReplayModeDataRef               = NULL;
-
-static XPLMFlightLoopID       sAfterFlightModelLoopID            = 0;
-static XPLMCreateFlightLoop_t sAfterFlightModelLoop;
-
-static int                    sWasInReplay                            = 0;
-static float sIntervalBetweenAfterFlightLoopCallbacks   = 0.01;     // seconds
-static size_t maxReplayCount = 0;
-static float recordTolerance = 0;
-
-static vector <FloatDataRefRecorder> sXPFloatValRecorders;
-static vector <IntDataRefRecorder>   sXPIntValRecorders;
-static vector <ByteArrDataRefRecorder>   sXPByteArrRecorders;
-static queue <pair<string, int> > inDrefs;//queue for saving datarefs until registering is possible
-
-static const char *sMenuRef = "Replay Extender";
-static const char *sStartRecordLabel = "Start Recorder";
-static const char *sStopRecordLabel = "Stop Recorder";
-static bool record = false;
-static int g_menu_container_idx; // The index of our menu item in the Plugins menu
-static int mindex = 0;
-static XPLMMenuID g_menu_id; // The menu container we'll append all our menu items to
-
-
-//--------------------------------------------------------------------------------------------------------------------
-// PLUGIN_API XPluginStart -
-//--------------------------------------------------------------------------------------------------------------------
-PLUGIN_API int XPluginStart(char *outName,
-                            char *outSig,
-                            char *outDesc)
-{
-
-  XPLMEnableFeature("XPLM_USE_NATIVE_PATHS", 1);  // Use POSIX paths
-
-  LoadConf();
-
-  // Plugin Info
-  strcpy(outName, sPluginName);
-  strcpy(outSig,  sPluginSig);
-  strcpy(outDesc, sPluginDescription);
-
-    g_menu_container_idx = XPLMAppendMenuItem(XPLMFindPluginsMenu(), sMenuRef, 0, 0);
-	g_menu_id = XPLMCreateMenu(sMenuRef, XPLMFindPluginsMenu(), g_menu_container_idx, menu_handler, (void *) sMenuRef);
-	//XPLMAppendMenuItem(g_menu_id, "Toggle Record", (void *)"record", 1);
-
-	XPLMMenuID aircraft_menu = XPLMFindAircraftMenu();
-	if(aircraft_menu) // This will be NULL unless this plugin was loaded with an aircraft (i.e., it was located in the current aircraft's "plugins" subdirectory)
-	{
-		mindex = XPLMAppendMenuItem(g_menu_id, sStartRecordLabel, (void *)"rec", 1);
-        XPLMCheckMenuItem(g_menu_id, mindex, xplm_Menu_Unchecked);
-	}
-  //
-  // Find X-Plane datarefs we need
-  //
-
-  sTotalRunningTimeDataRef            = XPLMFindDataRef(sTotalRunningTimeDataRefName);
-  sInReplayModeDataRef                = XPLMFindDataRef(sInReplayModeDataRefName);
-
-
-  RegisterPrimaryCallbacks();
-
-  return 1;
-}
-
-//--------------------------------------------------------------------------------------------------------------------
-// PLUGIN_API XPluginStop -
-//--------------------------------------------------------------------------------------------------------------------
-PLUGIN_API void XPluginStop(void)
-{
-  XPLMDestroyMenu(g_menu_id);
-  UnregisterPrimaryCallbacks();
-  PrintRecorderStatsToLog();
-}
-
-//--------------------------------------------------------------------------------------------------------------------
-// XPluginDisable -
-//--------------------------------------------------------------------------------------------------------------------
-PLUGIN_API void XPluginDisable(void)
-{
-  UnregisterPrimaryCallbacks();
-}
-
-//--------------------------------------------------------------------------------------------------------------------
-// XPluginEnable -
-//--------------------------------------------------------------------------------------------------------------------
-PLUGIN_API int XPluginEnable(void)
-{
-  RegisterPrimaryCallbacks();
-
-  return 1;   // Yeah, we're here...
-}
-
-//--------------------------------------------------------------------------------------------------------------------
-// PLUGIN_API RegisterPrimaryCallbacks -
-//--------------------------------------------------------------------------------------------------------------------
-static void RegisterPrimaryCallbacks()
-{
-  //
-  // Register our after flight model loop callback and schedule it
-  //
-  if (!sAfterFlightModelLoopID)
-    {
-      memset(&sAfterFlightModelLoop, 0, sizeof(sAfterFlightModelLoop));
-      sAfterFlightModelLoop.structSize   = sizeof(sAfterFlightModelLoop);
-      sAfterFlightModelLoop.phase        = xplm_FlightLoop_Phase_AfterFlightModel;
-      sAfterFlightModelLoop.callbackFunc = AfterFlightModelLoopCallBack;
-
-      sAfterFlightModelLoopID = XPLMCreateFlightLoop(&sAfterFlightModelLoop);
-
-      XPLMScheduleFlightLoop(sAfterFlightModelLoopID, -1, 1);
-    }
-}
-
-//--------------------------------------------------------------------------------------------------------------------
-// UnregisterPrimaryCallbacks -
-//--------------------------------------------------------------------------------------------------------------------
-void UnregisterPrimaryCallbacks()
-{
-
-  if (sAfterFlightModelLoopID)
-    {
-      XPLMDestroyFlightLoop(sAfterFlightModelLoopID);
-      sAfterFlightModelLoopID = 0;
-    }
-
-}
-
-//--------------------------------------------------------------------------------------------------------------------
-// ClearReplayRecorders -
-//--------------------------------------------------------------------------------------------------------------------
-static void ClearReplayRecorders()
-{
-  unsigned i;
-
-  for (i = 0; i < sXPFloatValRecorders.size(); i++)
-    {
-      sXPFloatValRecorders[i].Init();
-    }
-
-  for (i = 0; i < sXPIntValRecorders.size(); i++)
-    {
-      sXPIntValRecorders[i].Init();
-    }
-  for (i = 0; i < sXPByteArrRecorders.size(); i++)
-    {
-      sXPByteArrRecorders[i].Init();
-    }
-
-  sWasInReplay = 0;
-}
-
-//--------------------------------------------------------------------------------------------------------------------
-// XPluginReceiveMessage -
-//--------------------------------------------------------------------------------------------------------------------
-PLUGIN_API void XPluginReceiveMessage(XPLMPluginID    inFromWho,
-                                      long            inMessage,
-                                      void            *inParam)
-{
-  switch (inMessage)
-    {
-      case XPLM_MSG_PLANE_LOADED:
-        {
-          HandleAirplaneLoaded();
-        }
-        break;
-      case XPLM_MSG_AIRPORT_LOADED:
-      case XPLM_MSG_PLANE_UNLOADED:
-      case XPLM_MSG_WILL_WRITE_PREFS:
-      break;
-
-      //default:
-      // DPRINT("XPluginReceiveMessage: message %ld recieved from %u\n", inMessage, inFromWho);
-
-    }
-}
-
-//--------------------------------------------------------------------------------------------------------------------
-// HandleAirplaneLoaded -
-//--------------------------------------------------------------------------------------------------------------------
-static void HandleAirplaneLoaded()
-{
-  DPUTS("HandleAirplaneLoaded called\n");
-  ClearReplayRecorders();
-}
-
-//--------------------------------------------------------------------------------------------------------------------
-// AfterFlightModelLoopCallBack - our flight loop callback routine after flight model integrated
-//--------------------------------------------------------------------------------------------------------------------
-static float AfterFlightModelLoopCallBack(float   inElapsedSinceLastCall,
-                                          float   inElapsedTimeSinceLastFlightLoop,
-                                          int     inCounter,
-                                          void    *inRefcon)
-{
-    if(!inDrefs.empty())//stop if queue is empty
-    {
-        RegisterDrefs();//lazy register datarefs
-    }
-
-  float totalRunningTime = XPLMGetDataf(sTotalRunningTimeDataRef);
-
-  int inReplay         = XPLMGetDatai(sInReplayModeDataRef);
-  int replayTransition = (inReplay != sWasInReplay);
-  sWasInReplay         = inReplay;
-
-    if(record == true)
-    {
-        HandleRecordAndReplayOfExternalDataRefs(totalRunningTime, inReplay, replayTransition);
-    }
-
-
-
-  return sIntervalBetweenAfterFlightLoopCallbacks;
-}
-
-//--------------------------------------------------------------------------------------------------------------------
-// HandleRecordAndReplayOfExternalDataRefs -
-//--------------------------------------------------------------------------------------------------------------------
-static void HandleRecordAndReplayOfExternalDataRefs(float totalRunningTime,
-                                                    int inReplay,
-                                                    int replayTransition)
-{
-  unsigned i;
-
-  if (replayTransition)
-    {
-      for (i = 0; i < sXPFloatValRecorders.size(); i++)
-        {
-          sXPFloatValRecorders[i].Reset();
-        }
-
-      for (i = 0; i < sXPIntValRecorders.size(); i++)
-        {
-          sXPIntValRecorders[i].Reset();
-        }
-      for (i = 0; i < sXPByteArrRecorders.size(); i++)
-        {
-          sXPByteArrRecorders[i].Reset();
-        }
-    }
-
-  if (!inReplay)
-    {
-      //
-      // Not in replay mode
-      //
-
-      if (replayTransition)
-        {
-          for (i = 0; i < sXPFloatValRecorders.size(); i++)
-            {
-              sXPFloatValRecorders[i].RestoreDataRef();
-            }
-
-          for (i = 0; i < sXPIntValRecorders.size(); i++)
-            {
-              sXPIntValRecorders[i].RestoreDataRef();
-            }
-          for (i = 0; i < sXPByteArrRecorders.size(); i++)
-            {
-              sXPByteArrRecorders[i].RestoreDataRef();
-            }
-        }
-      else
-        {
-          for (i = 0; i < sXPFloatValRecorders.size(); i++)
-            {
-              sXPFloatValRecorders[i].RecordDataRef(totalRunningTime);
-            }
-
-          for (i = 0; i < sXPIntValRecorders.size(); i++)
-            {
-              sXPIntValRecorders[i].RecordDataRef(totalRunningTime);
-            }
-          for (i = 0; i < sXPByteArrRecorders.size(); i++)
-            {
-              sXPByteArrRecorders[i].RecordDataRef(totalRunningTime);
-            }
-        }
-    }
-  else
-    {
-      //
-      // In replay mode
-      //
-      for (i = 0; i < sXPFloatValRecorders.size(); i++)
-        {
-          sXPFloatValRecorders[i].ReplayDataRef(totalRunningTime);
-        }
-
-      for (i = 0; i < sXPIntValRecorders.size(); i++)
-        {
-          sXPIntValRecorders[i].ReplayDataRef(totalRunningTime);
-        }
-      for (i = 0; i < sXPByteArrRecorders.size(); i++)
-        {
-          sXPByteArrRecorders[i].ReplayDataRef(totalRunningTime);
-        }
-    }
-}
-
-
-//--------------------------------------------------------------------------------------------------------------------
-// GetConfFilePath - return a path to our conf file
-//--------------------------------------------------------------------------------------------------------------------
-static void GetConfFilePath(string &confPath)
-{
-  string temp;
-  GetAircraftPluginTopDirPath(temp);
-
-  confPath = temp;
-  confPath += XPLMGetDirectorySeparator();
-  confPath += "rextconfig.txt";
-}
-
-//--------------------------------------------------------------------------------------------------------------------
-// LoadConf - load preferences
-//--------------------------------------------------------------------------------------------------------------------
-static void LoadConf()
-{
-  string confPath;
-  GetConfFilePath(confPath);
-
-    //Read conf file C++ way, skip empty lines and comments #
-
-    fstream conffile;
-    DPRINT("Loading datarefs from: %s\n",confPath.c_str());
-    conffile.open(confPath,ios::in);
-    if (conffile.is_open())
-    {
-      string line;
-
-      while(getline(conffile, line))
-      {
-        if(!line.empty())
-        {
-          //deal with spaces and multyplatform line endings
-          std::string chars = " \r\n";
-
-          for (char c: chars) {
-              line.erase(std::remove(line.begin(), line.end(), c), line.end());
-          }
-
-          if(line.empty()) continue;
-
-          if(line.substr(0,1) == "%")//config symbol
-          {
-              float interval = stof(line.substr(1),nullptr);
-
-              if(interval != NAN)
-              {
-                  if(interval == 0.0f)
-                        interval = -1.0f;
-
-                sIntervalBetweenAfterFlightLoopCallbacks = interval;
-              }
-
-
-            DPRINT("Recording interval set to: %f seconds\n",sIntervalBetweenAfterFlightLoopCallbacks)
-          }
-          else if(line.substr(0,1) == "#")//comment symbol
-          {
-            continue;
-          }
-          else if(line.substr(0,1) == "$")//max recorded samples
-          {
-              size_t samples = stoul(line.substr(1),nullptr);
-
-              if(samples > 0)
-              {
-
-                maxReplayCount = samples;
-              }
-
-
-            DPRINT("Maximum recorded samples set to: %zu\n",maxReplayCount)
-          }
-          else if(line.substr(0,1) == "&")//float point value change
-          {
-              float tolerance = stof(line.substr(1),nullptr);
-
-              if(tolerance != NAN)
-              {
-                  if(tolerance < 0.0f)
-                        tolerance = 0.0f;
-
-                recordTolerance = tolerance;
-              }
-
-            DPRINT("Float recording tolerance set to: %f \n",recordTolerance)
-          }
-          else
-          {
-            //find out if dref is in array and save index
-            size_t startIndex = line.find('[');
-            size_t endIndex = line.find(']');
-            if (startIndex != string::npos && endIndex != string::npos)
-            {
-                int i = -1;
-                startIndex++;
-                string index;
-                if(endIndex>startIndex)//check if the user made a mistake and protect stoi
-                {
-                    index = line.substr(startIndex, endIndex - startIndex);
-                    if(!index.empty())//protect stoi
-                    {
-                        i = stoi(index,nullptr,10);//save index as int
-                    }
-                }
-                inDrefs.push(make_pair(line.substr(0, startIndex-1), i));
-            }
-            else//if not in array dref
-            {
-                inDrefs.push(make_pair(line, -1));
-            }
-          }
-        }
-      }
-      conffile.close();
-    }
-    else
-    {
-       DPUTS("Config file not found. Stopping...");
-       XPLMDisablePlugin(XPLMGetMyID());//does it work?
-    }
-}
-
-static void RegisterDrefs()
-{
-    static unsigned attempts = 0;
-    static unsigned remaining = 0;
-        if(remaining != inDrefs.size()){
-          DPRINT("Daterefs remaining %zu\n",inDrefs.size());
-          remaining = inDrefs.size();
-        }
-        for (long long unsigned i=0; i<inDrefs.size(); i++)
-        {
-                //If dataref exsists push it to the coresponding vecor
-                XPLMDataRef temp = XPLMFindDataRef(inDrefs.front().first.c_str());
-                if (temp != NULL)
-                {
-                    XPLMDataTypeID type = XPLMGetDataRefTypes(temp);
-                    if(XPLMCanWriteDataRef(temp))//try to find out if the dataref is writable. Else ignore it.
-                    {
-                        //Try to guess what is the type of the dataref and register it accordingly.
-                        if((type & xplmType_Float) == xplmType_Float)
-                        {
-                            sXPFloatValRecorders.push_back(FloatDataRefRecorder(inDrefs.front().first, temp, -1, maxReplayCount, recordTolerance));
-                            DPRINT("Float type dateref registered %s\n",inDrefs.front().first.c_str());
-                        }
-                        else if((type & xplmType_Int) == xplmType_Int)
-                        {
-                            sXPIntValRecorders.push_back(IntDataRefRecorder(inDrefs.front().first, temp));
-                            DPRINT("Int type dateref registered %s\n",inDrefs.front().first.c_str());
-                        }
-                        else if((type & xplmType_Data) == xplmType_Data)
-                        {
-                            sXPByteArrRecorders.push_back(ByteArrDataRefRecorder(inDrefs.front().first, temp));
-                            DPRINT("Byte array type dateref registered %s\n",inDrefs.front().first.c_str());
-                        }
-                        else if((type & xplmType_FloatArray) == xplmType_FloatArray)
-                        {
-                            if(inDrefs.front().second >= 0)
-                            {
-                                string dref_name = inDrefs.front().first+"[" + to_string(inDrefs.front().second)+"]";//Restore the name with the index
-                                sXPFloatValRecorders.push_back(FloatDataRefRecorder(dref_name, temp, inDrefs.front().second, maxReplayCount, recordTolerance));
-                                DPRINT("Float type array member dateref registered %s\n",dref_name.c_str());
-                            }
-                            else
-                            {
-                                //If the user missed the index of an array member dataref tell him and skip.
-                                DPRINT("Dateref is type FloatArray, but no index is provided. Skipping... %s\n",inDrefs.front().first.c_str());
-                            }
-                        }
-                        else if((type & xplmType_IntArray) == xplmType_IntArray)
-                        {
-                            if(inDrefs.front().second >= 0)
-                            {
-                                string dref_name = inDrefs.front().first+"[" + to_string(inDrefs.front().second)+"]";
-                                sXPIntValRecorders.push_back(IntDataRefRecorder(dref_name, temp, inDrefs.front().second));
-                                DPRINT("Int type array member dateref registered %s\n",dref_name.c_str());
-                            }
-                            else
-                            {
-                                DPRINT("Dateref is type IntArray, but no index is provided. Skipping... %s\n",inDrefs.front().first.c_str());
-                            }
-                        }
-                        else
-                        {
-                            DPRINT("Dateref type not supported %s.\n", inDrefs.front().first.c_str());
-
-                        }
-                    }
-                    else
-                    {
-                        DPRINT("Dateref not writable and will not be used %s\n",inDrefs.front().first.c_str());
-                    }
-
-                    inDrefs.pop();//Remove the dataref we have just registered from the queue
-                }
-                else
-                {
-                    //If the dataref does not exist yet during this iteration push it at the back of the queue for the next attempt.
-                    inDrefs.push(inDrefs.front());
-                    inDrefs.pop();
-                }
-
-        }
-        if(++attempts > 200)//Enough is enough. If a dataref does not exist/is created in, lets say 200 loops, it is probably wrong. Give up.
-        {
-            for(size_t i = 0; i<inDrefs.size(); i++)
-            {
-              DPRINT("Dataref not found in 200 flight loops. Skipping... %s\n", inDrefs.front().first.c_str());
-              inDrefs.pop();
-            }
-        }
-}
-
-
-//--------------------------------------------------------------------------------------------------------------------
-// GetAircraftPluginFilePath - return path to the aircraft's plugin directory
-//--------------------------------------------------------------------------------------------------------------------
-static void GetAircraftPluginFilePath(string &pluginFilePath)
-{
-  char temp[1024];
-  XPLMGetPluginInfo(XPLMGetMyID(), NULL, temp, NULL, NULL);
-
-  pluginFilePath = temp;
-}
-
-//--------------------------------------------------------------------------------------------------------------------
-// GetAircraftPluginTopDirPath - return top directory of the plugin
-//--------------------------------------------------------------------------------------------------------------------
-static void GetAircraftPluginTopDirPath(string &pluginDirPath)
-{
-  string path;
-  GetAircraftPluginFilePath(path);
-
-  string dirSep = XPLMGetDirectorySeparator();
-
-  size_t pos = path.rfind(dirSep);
-  if (pos != string::npos)
-    {
-      pos = path.rfind(dirSep, pos - 1);
-      if (pos != string::npos)
-        {
-            pluginDirPath = path.substr(0, pos);
-        }
-    }
-}
-
-//--------------------------------------------------------------------------------------------------------------------
-// PrintRecorderStatsToLog -
-//--------------------------------------------------------------------------------------------------------------------
-static void PrintRecorderStatsToLog()
-{
-  unsigned i;
-
-  DPUTS("\n");
-  DPRINT("Total Elapsed Time Recorded: %.3f\n", XPLMGetDataf(sTotalRunningTimeDataRef));
-
-  for (i = 0; i < sXPFloatValRecorders.size(); i++)
-    {
-      DPRINT("%-60s has %zu recorded elements\n",
-              sXPFloatValRecorders[i].GetDataRefName(), sXPFloatValRecorders[i].NumEventsRecorded());
-    }
-
-  for (i = 0; i < sXPIntValRecorders.size(); i++)
-    {
-      DPRINT("%-60s has %zu recorded elements\n",
-              sXPIntValRecorders[i].GetDataRefName(), sXPIntValRecorders[i].NumEventsRecorded());
-    }
-  for (i = 0; i < sXPByteArrRecorders.size(); i++)
-    {
-      DPRINT("%-60s has %zu recorded elements\n",
-              sXPByteArrRecorders[i].GetDataRefName(), sXPByteArrRecorders[i].NumEventsRecorded());
-    }
-  DPUTS("\n");
-}
-
-
-static void menu_handler(void * in_menu_ref, void * in_item_ref)
-{
-
-	if(!strcmp((const char *)in_item_ref, "rec") && XPLMGetDatai(sInReplayModeDataRef) == 0)
-	{
-        XPLMMenuCheck check;
-        XPLMCheckMenuItemState(g_menu_id, mindex,  &check);
-		if (check == xplm_Menu_Unchecked){
-            XPLMCheckMenuItem(g_menu_id, mindex, xplm_Menu_Checked);
-            XPLMSetMenuItemName(g_menu_id, mindex, sStopRecordLabel, 0);
-            record = true;
-		}
-		else if (check == xplm_Menu_Checked){
-            XPLMCheckMenuItem(g_menu_id, mindex, xplm_Menu_Unchecked);
-            XPLMSetMenuItemName(g_menu_id, mindex, sStartRecordLabel, 0);
-            record = false;
-		}
-	}
-
-}
+/*
+
+  FILE: rext.cpp
+
+  Replay Extender Plugin for X-Plane 11
+  Created by Todir 2021
+  Derived from
+  BD-5J Plugin for X-Plane 11
+  Copyright � 2019 by Quantumac
+
+  GNU GENERAL PUBLIC LICENSE, Version 2, June 1991
+
+    Record and replay additional dataref values.
+
+*/
+
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
+#include <vector>
+#include <string>
+#include <list>
+#include <map>
+#include <iostream>
+#include <fstream>
+#include <queue>
+#include <stdbool.h>
+#include <algorithm>
+#include <utility>
+#include <time.h>
+#include <chrono>
+
+#include "XPLMPlugin.h"
+#include "XPLMProcessing.h"
+#include "XPLMDataAccess.h"
+#include "XPLMUtilities.h"
+#include "XPLMMenus.h"
+
+#include "DebugPrint.h"
+#include "DataRefRecorder.h"
+#include "RecordingWriter.h"
+#include "RecordingJournal.h"
+#include "RecordPipeline.h"
+#include "WorkerPool.h"
+#include "TickStats.h"
+#include "TraceBuffer.h"
+#include "AllocTracker.h"
+#include "RecordGovernor.h"
+#include "ToleranceTuner.h"
+
+#define _STR(x) #x
+#define STR(x) _STR(x)
+
+#define SEEK_DETECT_SECONDS     2.0f    // A replay time jump larger than this is a seek
+#define SEEK_CHUNK_CHANNELS     256
+#define BUDGET_FIRST_CHANNELS   256     // Channels per tick until the record cost per channel is measured
+#define BUDGET_MIN_CHANNELS     64      // Keeps a rotation moving however small the budget
+
+using namespace std;
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT ChannelPolicy - key=value options of a dataref line or an @policy section. Negative or empty fields are
+//                        unset, a dataref line falls back on its section, then on & and $.
+//--------------------------------------------------------------------------------------------------------------------
+struct ChannelPolicy
+{
+  float     tolerance;        // tol=0.5
+  long long keepSamples;      // keep=2000
+  float     keepSeconds;      // keep=600s, also m and h
+  float     rate;             // rate=0.2, 0 - the % interval
+  int       linear;           // mode=linear 1, mode=step 0
+  string    codec;            // codec=q8
+  float     rangeLo;          // range=-1:1, rangeLo >= rangeHi - unset
+  float     rangeHi;
+
+  ChannelPolicy() : tolerance(-1.0f), keepSamples(-1), keepSeconds(-1.0f), rate(-1.0f), linear(-1),
+                    rangeLo(0.0f), rangeHi(0.0f) {}
+
+  //-----------------------------------------------------------------------------
+  // Fields set in over replace these
+  //-----------------------------------------------------------------------------
+  void Apply(const ChannelPolicy &over)
+  {
+    tolerance   = (over.tolerance >= 0.0f) ? over.tolerance : tolerance;
+    keepSamples = (over.keepSamples >= 0) ? over.keepSamples : keepSamples;
+    keepSeconds = (over.keepSeconds >= 0.0f) ? over.keepSeconds : keepSeconds;
+    rate        = (over.rate >= 0.0f) ? over.rate : rate;
+    linear      = (over.linear >= 0) ? over.linear : linear;
+    codec       = over.codec.empty() ? codec : over.codec;
+    rangeLo     = (over.rangeLo < over.rangeHi) ? over.rangeLo : rangeLo;
+    rangeHi     = (over.rangeLo < over.rangeHi) ? over.rangeHi : rangeHi;
+  }
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT ConfDataRef - a dataref line of the conf file waiting to be registered
+//--------------------------------------------------------------------------------------------------------------------
+struct ConfDataRef
+{
+  string        name;
+  int           index;          // Array member, -1 for a whole dataref
+  bool          lowPriority;
+  size_t        rateGroup;
+  ChannelPolicy policy;         // Section and line options, rate already resolved to rateGroup
+
+  ConfDataRef(const string &inName, int inIndex, bool inLowPriority, size_t inRateGroup, const ChannelPolicy &inPolicy) :
+    name(inName), index(inIndex), lowPriority(inLowPriority), rateGroup(inRateGroup), policy(inPolicy) {}
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+// STRUCT RateGroup - channels recorded by one flight loop. Group 0 is the main flight loop at the % interval,
+//                    every @rate section adds a group with a flight loop of its own.
+//--------------------------------------------------------------------------------------------------------------------
+struct RateGroup
+{
+  float               interval;           // Seconds, unused for group 0
+  XPLMFlightLoopID    loop;
+  vector<uint32_t>    floats;             // Channel indices per type
+  vector<uint32_t>    ints;
+  vector<uint32_t>    bytes;
+  size_t              cursor;             // First channel of the next budgeted tick
+  double              microsPerChannel;   // Measured, sizes the budgeted ticks
+  int                 cycleTicks;         // Ticks the latest full rotation took
+  int                 cycleCount;
+
+  RateGroup() : interval(0.0f), loop(0), cursor(0), microsPerChannel(0.0), cycleTicks(1), cycleCount(0) {}
+};
+
+static void LoadConf();
+static void ParseDirective(const string &line, const string &options);
+static bool ParsePolicy(const string &options, ChannelPolicy &outPolicy);
+static size_t FindRateGroup(float seconds);
+static void RegisterDrefs();
+static ChannelPolicy ResolvePolicy(const ConfDataRef &conf, bool isFloat);
+template <typename R> static void DeclareChannel(R &recorders, RecordType type, const ConfDataRef &conf);
+static void BindPipelineChannels();
+
+static float AfterFlightModelLoopCallBack(float   inElapsedSinceLastCall,
+                                          float   inElapsedTimeSinceLastFlightLoop,
+                                          int     inCounter,
+                                          void    *inRefcon);
+
+
+static void ClearReplayRecorders();
+
+static TickPhase HandleRecordAndReplayOfExternalDataRefs(float totalRunningTime,
+                                                         int inReplay,
+                                                         int replayTransition);
+
+static int ReconstructReplayState(float totalRunningTime);
+
+static int StageRecordTick(RateGroup &group, float totalRunningTime);
+template <typename R> static bool SkipChannel(R &recorder, bool drop, float totalRunningTime,
+                                              int &dropped, int &skipped);
+static float RateGroupLoopCallBack(float   inElapsedSinceLastCall,
+                                   float   inElapsedTimeSinceLastFlightLoop,
+                                   int     inCounter,
+                                   void    *inRefcon);
+
+static void HandleAirplaneLoaded();
+
+static void GetConfFilePath(string &confPath);
+
+static void GetRecordingFilePath(string &recordingPath);
+
+static void DumpTrace();
+static void UpdateToleranceTuner(float time);
+static void WriteToleranceReport();
+
+static void StartRecordPipeline();
+
+static void CheckRecordingJournal();
+static void OpenRecordingJournal();
+
+static void GetAircraftPluginFilePath(string &pluginFilePath);
+
+static void GetAircraftPluginTopDirPath(string &pluginDirPath);
+
+static void RegisterPrimaryCallbacks();
+static void UnregisterPrimaryCallbacks();
+
+static void PrintRecorderStatsToLog();
+static void CountPollTiers(int *outTiers);
+
+static void RegisterStatsDataRefs();
+static void UnregisterStatsDataRefs();
+
+static void menu_handler(void *, void *);
+
+static const char *sPluginName                          = "Replay Extender Plugin";
+static const char *sPluginSig                           =  STR(BUILD_VERSION);//defined in makefile
+static const char *sPluginDescription                   = "Replay Extender for X-Plane";
+
+static const char *sTotalRunningTimeDataRefName         = "sim/time/total_running_time_sec";
+static const char *sInReplayModeDataRefName             = "sim/time/is_in_replay";
+
+
+static XPLMDataRef            sTotalRunningTimeDataRef           = NULL;
+static XPLMDataRef            sInReplayModeDataRef               = NULL;
+
+static XPLMFlightLoopID       sAfterFlightModelLoopID            = 0;
+static XPLMCreateFlightLoop_t sAfterFlightModelLoop;
+
+static int                    sWasInReplay                            = 0;
+static float sIntervalBetweenAfterFlightLoopCallbacks   = 0.01;     // seconds
+static size_t maxReplayCount = 0;
+static float recordTolerance = 0;
+static size_t sWriterRingBytes = 0;                                 // 0 - do not stream to disk
+static uint32_t sNextChannelId = 1;
+static RecordingWriter sRecordingWriter;
+static size_t sJournalBytes = 0;                                    // 0 - no crash journal
+static RecordingJournal sRecordingJournal;
+static bool             sJournalLapLogged;
+static bool             sJournalOverflowLogged;
+static unsigned sNumRecordWorkers = 1;                              // 0 - record on the sim thread
+static size_t sStagingBytes = 1024 * 1024;
+static RecordPipeline sRecordPipeline;
+static float sKeyframeInterval = 10.0f;                             // Seconds between replay keyframes, 0 - none
+static unsigned sNumSeekThreads = 2;                                // 0 - seek on the sim thread only
+static WorkerPool sSeekPool;
+static float sLastReplayTime = 0.0f;
+static unsigned sNumSeeks = 0;
+static long long sLastSeekMicros = 0;
+static long long sMaxSeekMicros = 0;
+static vector<XPLMDataRef> sStatsDataRefs;
+static TickStats sTickStats;
+static int sTickChannels = 0;                                       // Channels read or written this tick
+static int sTickXPLMCalls = 0;
+static size_t sTraceEvents = 0;                                     // 0 - tracing off
+static float sRecordBudgetMicros = 0.0f;                            // 0 - every channel every record tick
+static vector<RateGroup> sRateGroups(1);                            // [0] is the main flight loop's
+static size_t sConfRateGroup = 0;                                   // @rate group of the datarefs that follow
+static ChannelPolicy sConfPolicy;                                   // @policy options of the datarefs that follow
+static RecordGovernor sGovernor;                                    // @fps, off by default
+static int sGovernorDropped = 0;                                    // Low priority channels skipped this tick
+static float sEffectiveInterval = 0.0f;                             // Interval the flight loop last asked for
+static float sMaxStaleness = 0.0f;                                  // @staleness, 0 - adaptive polling off
+static int sPollSkipped = 0;                                        // Quiet channels not polled this tick
+static long long sPollSkippedTotal = 0;
+static long long sPollReadsTotal = 0;
+static ToleranceTuner sToleranceTuner;                              // @autotol, off by default
+static vector<uint32_t> sAutoTolChannels;                           // Float recorders without a tol of their own
+static float sCodecBudgetMicros = 20.0f;                            // Auto codec trials per sealed block, 0 - no limit
+static RetentionTiers sRetention;                                   // @retain, off by default
+
+static vector <FloatDataRefRecorder> sXPFloatValRecorders;
+static vector <IntDataRefRecorder>   sXPIntValRecorders;
+static vector <ByteArrDataRefRecorder>   sXPByteArrRecorders;
+static queue <ConfDataRef> inDrefs;//queue for saving datarefs until registering is possible
+static bool sConfLowPriority = false;                               // @priority0 marks the datarefs after it
+
+static const char *sMenuRef = "Replay Extender";
+static const char *sStartRecordLabel = "Start Recorder";
+static const char *sStopRecordLabel = "Stop Recorder";
+static bool record = false;
+static int g_menu_container_idx; // The index of our menu item in the Plugins menu
+static int mindex = 0;
+static XPLMMenuID g_menu_id; // The menu container we'll append all our menu items to
+
+
+//--------------------------------------------------------------------------------------------------------------------
+// PLUGIN_API XPluginStart -
+//--------------------------------------------------------------------------------------------------------------------
+PLUGIN_API int XPluginStart(char *outName,
+                            char *outSig,
+                            char *outDesc)
+{
+
+  XPLMEnableFeature("XPLM_USE_NATIVE_PATHS", 1);  // Use POSIX paths
+
+  LoadConf();
+
+  // Plugin Info
+  strcpy(outName, sPluginName);
+  strcpy(outSig,  sPluginSig);
+  strcpy(outDesc, sPluginDescription);
+
+    g_menu_container_idx = XPLMAppendMenuItem(XPLMFindPluginsMenu(), sMenuRef, 0, 0);
+	g_menu_id = XPLMCreateMenu(sMenuRef, XPLMFindPluginsMenu(), g_menu_container_idx, menu_handler, (void *) sMenuRef);
+	//XPLMAppendMenuItem(g_menu_id, "Toggle Record", (void *)"record", 1);
+
+	XPLMMenuID aircraft_menu = XPLMFindAircraftMenu();
+	if(aircraft_menu) // This will be NULL unless this plugin was loaded with an aircraft (i.e., it was located in the current aircraft's "plugins" subdirectory)
+	{
+		mindex = XPLMAppendMenuItem(g_menu_id, sStartRecordLabel, (void *)"rec", 1);
+        XPLMCheckMenuItem(g_menu_id, mindex, xplm_Menu_Unchecked);
+	}
+
+  if (sTraceEvents > 0 && gTraceBuffer.Start(sTraceEvents))
+    {
+      gTraceBuffer.NameThread("sim");
+      XPLMAppendMenuItem(g_menu_id, "Dump Trace", (void *)"trace", 1);
+    }
+  //
+  // Find X-Plane datarefs we need
+  //
+
+  sTotalRunningTimeDataRef            = XPLMFindDataRef(sTotalRunningTimeDataRefName);
+  sInReplayModeDataRef                = XPLMFindDataRef(sInReplayModeDataRefName);
+
+
+  RegisterPrimaryCallbacks();
+  RegisterStatsDataRefs();
+
+  StartRecordPipeline();
+  sSeekPool.Start(sNumSeekThreads);
+
+  return 1;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// PLUGIN_API XPluginStop -
+//--------------------------------------------------------------------------------------------------------------------
+PLUGIN_API void XPluginStop(void)
+{
+  XPLMDestroyMenu(g_menu_id);
+  UnregisterPrimaryCallbacks();
+  UnregisterStatsDataRefs();
+  sRecordPipeline.Stop();
+  sRecordingWriter.Stop();
+  sSeekPool.Stop();
+  if (sToleranceTuner.IsStarted())
+    {
+      WriteToleranceReport();
+    }
+  PrintRecorderStatsToLog();
+  sRecordingJournal.Close();
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// XPluginDisable -
+//--------------------------------------------------------------------------------------------------------------------
+PLUGIN_API void XPluginDisable(void)
+{
+  UnregisterPrimaryCallbacks();
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// XPluginEnable -
+//--------------------------------------------------------------------------------------------------------------------
+PLUGIN_API int XPluginEnable(void)
+{
+  RegisterPrimaryCallbacks();
+
+  return 1;   // Yeah, we're here...
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// PLUGIN_API RegisterPrimaryCallbacks -
+//--------------------------------------------------------------------------------------------------------------------
+static void RegisterPrimaryCallbacks()
+{
+  //
+  // Register our after flight model loop callback and schedule it
+  //
+  if (!sAfterFlightModelLoopID)
+    {
+      memset(&sAfterFlightModelLoop, 0, sizeof(sAfterFlightModelLoop));
+      sAfterFlightModelLoop.structSize   = sizeof(sAfterFlightModelLoop);
+      sAfterFlightModelLoop.phase        = xplm_FlightLoop_Phase_AfterFlightModel;
+      sAfterFlightModelLoop.callbackFunc = AfterFlightModelLoopCallBack;
+
+      sAfterFlightModelLoopID = XPLMCreateFlightLoop(&sAfterFlightModelLoop);
+
+      XPLMScheduleFlightLoop(sAfterFlightModelLoopID, -1, 1);
+    }
+
+  //
+  // One more flight loop per @rate group, after the main one so it registers the datarefs first
+  //
+  for (size_t g = 1; g < sRateGroups.size(); g++)
+    {
+      if (!sRateGroups[g].loop)
+        {
+          XPLMCreateFlightLoop_t loop;
+
+          memset(&loop, 0, sizeof(loop));
+          loop.structSize   = sizeof(loop);
+          loop.phase        = xplm_FlightLoop_Phase_AfterFlightModel;
+          loop.callbackFunc = RateGroupLoopCallBack;
+          loop.refcon       = (void *)(intptr_t)g;
+
+          sRateGroups[g].loop = XPLMCreateFlightLoop(&loop);
+          XPLMScheduleFlightLoop(sRateGroups[g].loop, sRateGroups[g].interval, 1);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// UnregisterPrimaryCallbacks -
+//--------------------------------------------------------------------------------------------------------------------
+void UnregisterPrimaryCallbacks()
+{
+
+  if (sAfterFlightModelLoopID)
+    {
+      XPLMDestroyFlightLoop(sAfterFlightModelLoopID);
+      sAfterFlightModelLoopID = 0;
+    }
+
+  for (size_t g = 1; g < sRateGroups.size(); g++)
+    {
+      if (sRateGroups[g].loop)
+        {
+          XPLMDestroyFlightLoop(sRateGroups[g].loop);
+          sRateGroups[g].loop = 0;
+        }
+    }
+
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ClearReplayRecorders -
+//--------------------------------------------------------------------------------------------------------------------
+static void ClearReplayRecorders()
+{
+  unsigned i;
+
+  sRecordPipeline.Drain(true);
+  sRecordPipeline.ClearKeyframes();
+
+  for (i = 0; i < sXPFloatValRecorders.size(); i++)
+    {
+      sXPFloatValRecorders[i].Init();
+    }
+
+  for (i = 0; i < sXPIntValRecorders.size(); i++)
+    {
+      sXPIntValRecorders[i].Init();
+    }
+  for (i = 0; i < sXPByteArrRecorders.size(); i++)
+    {
+      sXPByteArrRecorders[i].Init();
+    }
+
+  sRecordPipeline.StartSession();
+
+  sWasInReplay = 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// XPluginReceiveMessage -
+//--------------------------------------------------------------------------------------------------------------------
+PLUGIN_API void XPluginReceiveMessage(XPLMPluginID    inFromWho,
+                                      long            inMessage,
+                                      void            *inParam)
+{
+  switch (inMessage)
+    {
+      case XPLM_MSG_PLANE_LOADED:
+        {
+          HandleAirplaneLoaded();
+        }
+        break;
+      case XPLM_MSG_AIRPORT_LOADED:
+      case XPLM_MSG_PLANE_UNLOADED:
+      case XPLM_MSG_WILL_WRITE_PREFS:
+      break;
+
+      //default:
+      // DPRINT("XPluginReceiveMessage: message %ld recieved from %u\n", inMessage, inFromWho);
+
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// HandleAirplaneLoaded -
+//--------------------------------------------------------------------------------------------------------------------
+static void HandleAirplaneLoaded()
+{
+  DPUTS("HandleAirplaneLoaded called\n");
+  ClearReplayRecorders();
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// MicrosSince -
+//--------------------------------------------------------------------------------------------------------------------
+static float MicrosSince(chrono::steady_clock::time_point start)
+{
+  return chrono::duration<float, micro>(chrono::steady_clock::now() - start).count();
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// AfterFlightModelLoopCallBack - our flight loop callback routine after flight model integrated
+//--------------------------------------------------------------------------------------------------------------------
+static float AfterFlightModelLoopCallBack(float   inElapsedSinceLastCall,
+                                          float   inElapsedTimeSinceLastFlightLoop,
+                                          int     inCounter,
+                                          void    *inRefcon)
+{
+  TRACE_SCOPE("flight_loop");
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  sTickChannels    = 0;
+  sTickXPLMCalls   = 0;
+  sGovernorDropped = 0;
+  sPollSkipped     = 0;
+
+    if(!inDrefs.empty())//stop if queue is empty
+    {
+        RegisterDrefs();//lazy register datarefs
+        sTickStats.Add(kTickRegister, MicrosSince(start));
+        start = chrono::steady_clock::now();
+    }
+
+  float totalRunningTime = XPLMGetDataf(sTotalRunningTimeDataRef);
+
+  int inReplay         = XPLMGetDatai(sInReplayModeDataRef);
+  int replayTransition = (inReplay != sWasInReplay);
+  sWasInReplay         = inReplay;
+  sTickXPLMCalls      += 2;
+
+  sEffectiveInterval = sIntervalBetweenAfterFlightLoopCallbacks;
+
+    if(record == true)
+    {
+        TickPhase phase = HandleRecordAndReplayOfExternalDataRefs(totalRunningTime, inReplay, replayTransition);
+
+        if ((phase == kTickRecord) && inDrefs.empty() && sToleranceTuner.IsDue(totalRunningTime))
+          {
+            UpdateToleranceTuner(totalRunningTime);
+          }
+
+        if (phase == kTickRecord)
+          {
+            CheckRecordingJournal();
+          }
+
+        float     cost  = MicrosSince(start);
+        sTickStats.Add(phase, cost);
+
+        if (sGovernor.IsEnabled() && (phase == kTickRecord))
+          {
+            if (sGovernor.Update(inElapsedTimeSinceLastFlightLoop, inElapsedSinceLastCall, cost, totalRunningTime))
+              {
+                DPRINT("Record governor level %d at %.1f fps: interval x%.0f%s\n", sGovernor.GetLevel(),
+                       sGovernor.GetFps(), sGovernor.IntervalScale(),
+                       sGovernor.DropLowPriority() ? ", low priority datarefs paused" : "");
+              }
+            sEffectiveInterval *= sGovernor.IntervalScale();      // Negative intervals count frames, that scales too
+          }
+    }
+
+
+
+  return sEffectiveInterval;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// SetDataRun - count members of an array dataref in one call
+//--------------------------------------------------------------------------------------------------------------------
+static void SetDataRun(XPLMDataRef dataRef, float *values, int offset, int count)
+{
+  XPLMSetDatavf(dataRef, values, offset, count);
+}
+
+static void SetDataRun(XPLMDataRef dataRef, int *values, int offset, int count)
+{
+  XPLMSetDatavi(dataRef, values, offset, count);
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ApplyReplayRuns - writes what ResolveReplay left pending. Members of one array dataref listed one after the other
+//                   with consecutive indices, a bank of switches or a table, go out in one call. Returns the number
+//                   of datarefs written, the tick's XPLM calls count the runs.
+//--------------------------------------------------------------------------------------------------------------------
+template <typename T, typename R> static int ApplyReplayRuns(vector<R> &recorders)
+{
+  static vector<T> run;
+  int    written = 0;
+  size_t i       = 0;
+
+  while (i < recorders.size())
+    {
+      R &first = recorders[i++];
+      T val;
+
+      if (first.GetIndex() < 0)
+        {
+          written += first.ApplyReplay();
+          continue;
+        }
+      if (!first.TakePending(val))
+        {
+          continue;
+        }
+
+      run.assign(1, val);
+      while ((i < recorders.size()) && (recorders[i].GetDataRef() == first.GetDataRef()) &&
+             (recorders[i].GetIndex() == first.GetIndex() + (int)run.size()) && recorders[i].TakePending(val))
+        {
+          run.push_back(val);
+          i++;
+        }
+
+      SetDataRun(first.GetDataRef(), &run[0], first.GetIndex(), (int)run.size());
+      written        += (int)run.size();
+      sTickXPLMCalls -= (int)run.size() - 1;        // Counted once per dataref written
+    }
+
+  return written;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// HandleRecordAndReplayOfExternalDataRefs - returns the phase the tick went through, for the tick stats
+//--------------------------------------------------------------------------------------------------------------------
+static TickPhase HandleRecordAndReplayOfExternalDataRefs(float totalRunningTime,
+                                                         int inReplay,
+                                                         int replayTransition)
+{
+  unsigned  i;
+  TickPhase phase;
+  int       written = 0;
+
+  if (replayTransition)
+    {
+      sRecordPipeline.Drain();
+
+      for (i = 0; i < sXPFloatValRecorders.size(); i++)
+        {
+          sXPFloatValRecorders[i].Reset();
+        }
+
+      for (i = 0; i < sXPIntValRecorders.size(); i++)
+        {
+          sXPIntValRecorders[i].Reset();
+        }
+      for (i = 0; i < sXPByteArrRecorders.size(); i++)
+        {
+          sXPByteArrRecorders[i].Reset();
+        }
+    }
+
+  if (!inReplay)
+    {
+      //
+      // Not in replay mode
+      //
+
+      if (replayTransition)
+        {
+          TRACE_SCOPE("restore");
+          ALLOC_SCOPE(kAllocRestore, kRecordTypeNone);
+
+          ALLOC_TAG(kAllocRestore, kRecordTypeFloat);
+          for (i = 0; i < sXPFloatValRecorders.size(); i++)
+            {
+              written += sXPFloatValRecorders[i].RestoreDataRef();
+            }
+
+          ALLOC_TAG(kAllocRestore, kRecordTypeInt);
+          for (i = 0; i < sXPIntValRecorders.size(); i++)
+            {
+              written += sXPIntValRecorders[i].RestoreDataRef();
+            }
+          ALLOC_TAG(kAllocRestore, kRecordTypeBytes);
+          for (i = 0; i < sXPByteArrRecorders.size(); i++)
+            {
+              written += sXPByteArrRecorders[i].RestoreDataRef();
+            }
+
+          phase = kTickRestore;
+        }
+      else
+        {
+          //
+          // Only snapshot raw values here, change detection and storage happen on the record workers
+          //
+          TRACE_SCOPE("record");
+          ALLOC_SCOPE(kAllocRecord, kRecordTypeNone);
+
+          sTickChannels += StageRecordTick(sRateGroups[0], totalRunningTime);
+          phase = kTickRecord;
+        }
+    }
+  else
+    {
+      //
+      // In replay mode
+      //
+      bool seek = replayTransition || (fabsf(totalRunningTime - sLastReplayTime) > SEEK_DETECT_SECONDS);
+      sLastReplayTime = totalRunningTime;
+
+      if (seek)
+        {
+          written = ReconstructReplayState(totalRunningTime);
+          phase   = kTickSeek;
+        }
+      else
+        {
+          TRACE_SCOPE("replay");
+          ALLOC_SCOPE(kAllocReplay, kRecordTypeNone);
+
+          ALLOC_TAG(kAllocReplay, kRecordTypeFloat);
+          for (i = 0; i < sXPFloatValRecorders.size(); i++)
+            {
+              sXPFloatValRecorders[i].ResolveReplay(totalRunningTime);
+            }
+          written += ApplyReplayRuns<float>(sXPFloatValRecorders);
+
+          ALLOC_TAG(kAllocReplay, kRecordTypeInt);
+          for (i = 0; i < sXPIntValRecorders.size(); i++)
+            {
+              sXPIntValRecorders[i].ResolveReplay(totalRunningTime);
+            }
+          written += ApplyReplayRuns<int>(sXPIntValRecorders);
+          ALLOC_TAG(kAllocReplay, kRecordTypeBytes);
+          for (i = 0; i < sXPByteArrRecorders.size(); i++)
+            {
+              written += sXPByteArrRecorders[i].ReplayDataRef(totalRunningTime);
+            }
+
+          phase = kTickReplay;
+        }
+    }
+
+  sTickChannels  += written;
+  sTickXPLMCalls += written;
+
+  return phase;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ClipRange - position of index within the count channels starting at first, clamped to them
+//--------------------------------------------------------------------------------------------------------------------
+static size_t ClipRange(size_t index, size_t first, size_t count)
+{
+  return (index > first) ? min(index - first, count) : 0;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// SkipChannel - whether a channel is left unread this record tick, paused by the governor or, with @staleness,
+//               not due for a poll yet
+//--------------------------------------------------------------------------------------------------------------------
+template <typename R> static bool SkipChannel(R &recorder, bool drop, float totalRunningTime,
+                                              int &dropped, int &skipped)
+{
+  if (drop && recorder.IsLowPriority())
+    {
+      dropped++;
+      return true;
+    }
+
+  if ((sMaxStaleness > 0.0f) && !recorder.Poll().Due(totalRunningTime, sMaxStaleness))
+    {
+      skipped++;
+      return true;
+    }
+
+  return false;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// StageRecordTick - snapshot the channels of a rate group for this record tick, returns how many were read. Without
+//                   rate groups the default group is every channel and staged as dense ranges, otherwise each
+//                   group stages its own channel lists sparsely. Without a budget the whole group is read. With
+//                   @budget the group's channels (floats, ints, then byte arrays) are read in a fixed rotation,
+//                   each tick taking as many as the measured cost per channel fits in the budget and the next
+//                   tick carrying on after them. Every sample is stamped with the tick it was read in.
+//--------------------------------------------------------------------------------------------------------------------
+static int StageRecordTick(RateGroup &group, float totalRunningTime)
+{
+  bool   sparse   = (sRateGroups.size() > 1);
+  size_t numFloat = sparse ? group.floats.size() : sXPFloatValRecorders.size();
+  size_t numInt   = sparse ? group.ints.size() : sXPIntValRecorders.size();
+  size_t numBytes = sparse ? group.bytes.size() : sXPByteArrRecorders.size();
+  size_t total    = numFloat + numInt + numBytes;
+  size_t begin    = 0;
+  size_t end      = total;
+  size_t k;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  if ((sRecordBudgetMicros > 0.0f) && (total > 0))
+    {
+      size_t chunk = (group.microsPerChannel > 0.0) ? (size_t)(sRecordBudgetMicros / group.microsPerChannel)
+                                                    : BUDGET_FIRST_CHANNELS;
+
+      begin = (group.cursor < total) ? group.cursor : 0;
+      end   = min(begin + max(chunk, (size_t)BUDGET_MIN_CHANNELS), total);
+
+      group.cursor = (end < total) ? end : 0;
+      group.cycleCount++;
+      if (group.cursor == 0)
+        {
+          group.cycleTicks = group.cycleCount;
+          group.cycleCount = 0;
+        }
+    }
+
+  if (sparse)
+    {
+      sRecordPipeline.BeginSparseTick(totalRunningTime);
+    }
+  else
+    {
+      sRecordPipeline.BeginTick(totalRunningTime,
+                                ClipRange(begin, 0, numFloat), ClipRange(end, 0, numFloat),
+                                ClipRange(begin, numFloat, numInt), ClipRange(end, numFloat, numInt));
+    }
+
+  //
+  // Paused low priority channels and quiet channels not due for a poll are left out of sparse ticks. Dense
+  // ticks repeat their previous read, the workers see no change.
+  //
+  bool drop    = sGovernor.DropLowPriority();
+  int  dropped = 0;
+  int  skipped = 0;
+
+  ALLOC_TAG(kAllocRecord, kRecordTypeFloat);
+  for (k = ClipRange(begin, 0, numFloat); k < ClipRange(end, 0, numFloat); k++)
+    {
+      size_t               i        = sparse ? group.floats[k] : k;
+      FloatDataRefRecorder &recorder = sXPFloatValRecorders[i];
+
+      if (SkipChannel(recorder, drop, totalRunningTime, dropped, skipped))
+        {
+          if (!sparse)
+            {
+              sRecordPipeline.StageFloat(i, recorder.LastRead());
+            }
+          continue;
+        }
+
+      float last = recorder.LastRead();
+      float val  = recorder.ReadDataRef();
+      recorder.Poll().Observe(val != last, totalRunningTime, sMaxStaleness);
+      sRecordPipeline.StageFloat(i, val);
+    }
+
+  ALLOC_TAG(kAllocRecord, kRecordTypeInt);
+  for (k = ClipRange(begin, numFloat, numInt); k < ClipRange(end, numFloat, numInt); k++)
+    {
+      size_t             i        = sparse ? group.ints[k] : k;
+      IntDataRefRecorder &recorder = sXPIntValRecorders[i];
+
+      if (SkipChannel(recorder, drop, totalRunningTime, dropped, skipped))
+        {
+          if (!sparse)
+            {
+              sRecordPipeline.StageInt(i, recorder.LastRead());
+            }
+          continue;
+        }
+
+      int last = recorder.LastRead();
+      int val  = recorder.ReadDataRef();
+      recorder.Poll().Observe(val != last, totalRunningTime, sMaxStaleness);
+      sRecordPipeline.StageInt(i, val);
+    }
+
+  size_t bytesBegin = ClipRange(begin, numFloat + numInt, numBytes);
+  size_t bytesEnd   = ClipRange(end, numFloat + numInt, numBytes);
+  int    bytesRead  = 0;
+
+  ALLOC_TAG(kAllocRecord, kRecordTypeBytes);
+  for (k = bytesBegin; k < bytesEnd; k++)
+    {
+      size_t                 i        = sparse ? group.bytes[k] : k;
+      ByteArrDataRefRecorder &recorder = sXPByteArrRecorders[i];
+
+      if (SkipChannel(recorder, drop, totalRunningTime, dropped, skipped))
+        {
+          continue;
+        }
+
+      sRecordPipeline.StageBytes(i, recorder.ReadDataRef());
+      recorder.Poll().Observe(recorder.ReadChanged(), totalRunningTime, sMaxStaleness);
+      bytesRead++;
+    }
+
+  ALLOC_TAG(kAllocRecord, kRecordTypeNone);
+  sRecordPipeline.CommitTick();
+
+  if ((sRecordBudgetMicros > 0.0f) && (end > begin))
+    {
+      double perChannel = MicrosSince(start) / (double)(end - begin);
+      group.microsPerChannel = (group.microsPerChannel > 0.0) ? 0.9 * group.microsPerChannel + 0.1 * perChannel
+                                                              : perChannel;
+    }
+
+  int read = (int)(end - begin) - dropped - skipped;
+
+  sGovernorDropped  += dropped;
+  sPollSkipped      += skipped;
+  sPollSkippedTotal += skipped;
+  sPollReadsTotal   += read;
+  sTickXPLMCalls    += read + bytesRead;                             // Byte arrays take two calls
+  return read;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// RateGroupLoopCallBack - records the channels of one @rate group at its own interval. Replay, restore and seeks
+//                         stay with the main flight loop, which also notices the replay transitions first.
+//--------------------------------------------------------------------------------------------------------------------
+static float RateGroupLoopCallBack(float   inElapsedSinceLastCall,
+                                   float   inElapsedTimeSinceLastFlightLoop,
+                                   int     inCounter,
+                                   void    *inRefcon)
+{
+  RateGroup &group   = sRateGroups[(size_t)(intptr_t)inRefcon];
+  float     interval = group.interval * sGovernor.IntervalScale();
+
+  if (!record || sWasInReplay || XPLMGetDatai(sInReplayModeDataRef))
+    {
+      return interval;
+    }
+
+  TRACE_SCOPE("record_group");
+  ALLOC_SCOPE(kAllocRecord, kRecordTypeNone);
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  sTickChannels  += StageRecordTick(group, XPLMGetDataf(sTotalRunningTimeDataRef));
+  sTickXPLMCalls += 2;
+  sTickStats.Add(kTickRecord, MicrosSince(start));
+
+  return interval;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ReconstructReplayState - after a seek, look every channel up on the seek pool starting from the nearest
+//                          keyframe, then write them in one batch. Returns the number of datarefs written.
+//--------------------------------------------------------------------------------------------------------------------
+static int ReconstructReplayState(float totalRunningTime)
+{
+  TRACE_SCOPE("seek");
+  ALLOC_SCOPE(kAllocSeek, kRecordTypeNone);
+  unsigned i;
+  int      written = 0;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  sSeekPool.ParallelFor(sXPFloatValRecorders.size(), SEEK_CHUNK_CHANNELS,
+                        [totalRunningTime](size_t begin, size_t end)
+                        {
+                          ALLOC_SCOPE(kAllocSeek, kRecordTypeFloat);
+                          for (size_t k = begin; k < end; k++)
+                            {
+                              sXPFloatValRecorders[k].ResolveReplay(totalRunningTime,
+                                sRecordPipeline.KeyframePosition(kRecordTypeFloat, k, totalRunningTime));
+                            }
+                        });
+
+  sSeekPool.ParallelFor(sXPIntValRecorders.size(), SEEK_CHUNK_CHANNELS,
+                        [totalRunningTime](size_t begin, size_t end)
+                        {
+                          ALLOC_SCOPE(kAllocSeek, kRecordTypeInt);
+                          for (size_t k = begin; k < end; k++)
+                            {
+                              sXPIntValRecorders[k].ResolveReplay(totalRunningTime,
+                                sRecordPipeline.KeyframePosition(kRecordTypeInt, k, totalRunningTime));
+                            }
+                        });
+
+  sSeekPool.ParallelFor(sXPByteArrRecorders.size(), SEEK_CHUNK_CHANNELS,
+                        [totalRunningTime](size_t begin, size_t end)
+                        {
+                          ALLOC_SCOPE(kAllocSeek, kRecordTypeBytes);
+                          for (size_t k = begin; k < end; k++)
+                            {
+                              sXPByteArrRecorders[k].ResolveReplay(totalRunningTime,
+                                sRecordPipeline.KeyframePosition(kRecordTypeBytes, k, totalRunningTime));
+                            }
+                        });
+
+  //
+  // XPLM is only allowed on this thread
+  //
+  ALLOC_TAG(kAllocSeek, kRecordTypeFloat);
+  written += ApplyReplayRuns<float>(sXPFloatValRecorders);
+
+  ALLOC_TAG(kAllocSeek, kRecordTypeInt);
+  written += ApplyReplayRuns<int>(sXPIntValRecorders);
+  ALLOC_TAG(kAllocSeek, kRecordTypeBytes);
+  for (i = 0; i < sXPByteArrRecorders.size(); i++)
+    {
+      written += sXPByteArrRecorders[i].ApplyReplay();
+    }
+
+  sLastSeekMicros = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+  sMaxSeekMicros  = max(sMaxSeekMicros, sLastSeekMicros);
+  sNumSeeks++;
+
+  return written;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------
+// GetConfFilePath - return a path to our conf file
+//--------------------------------------------------------------------------------------------------------------------
+static void GetConfFilePath(string &confPath)
+{
+  string temp;
+  GetAircraftPluginTopDirPath(temp);
+
+  confPath = temp;
+  confPath += XPLMGetDirectorySeparator();
+  confPath += "rextconfig.txt";
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// GetRecordingFilePath - return a path for a new recording file next to our conf file
+//--------------------------------------------------------------------------------------------------------------------
+static void GetRecordingFilePath(string &recordingPath)
+{
+  char stamp[32];
+  time_t now = time(NULL);
+  strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", localtime(&now));
+
+  string temp;
+  GetAircraftPluginTopDirPath(temp);
+
+  recordingPath = temp;
+  recordingPath += XPLMGetDirectorySeparator();
+  recordingPath += "rext_";
+  recordingPath += stamp;
+  recordingPath += ".rrec";
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// DumpTrace - write the trace buffer next to our conf file
+//--------------------------------------------------------------------------------------------------------------------
+static void DumpTrace()
+{
+  string tracePath;
+  GetRecordingFilePath(tracePath);
+  tracePath.replace(tracePath.rfind(".rrec"), string::npos, ".json");
+  tracePath.insert(tracePath.rfind("rext_") + 5, "trace_");
+
+  long numEvents = gTraceBuffer.Dump(tracePath);
+  if (numEvents >= 0)
+    {
+      DPRINT("Trace with %ld events written to: %s\n", numEvents, tracePath.c_str());
+    }
+  else
+    {
+      DPRINT("Could not write trace file %s\n", tracePath.c_str());
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// WriteToleranceReport - the tuned tolerances as conf file lines, rext_tolerances.txt next to our conf file
+//--------------------------------------------------------------------------------------------------------------------
+static void WriteToleranceReport()
+{
+  string reportPath;
+  GetAircraftPluginTopDirPath(reportPath);
+  reportPath += XPLMGetDirectorySeparator();
+  reportPath += "rext_tolerances.txt";
+
+  fstream report(reportPath, ios::out | ios::trunc);
+  if (!report.is_open())
+    {
+      DPRINT("Could not write tolerance report %s\n", reportPath.c_str());
+      return;
+    }
+
+  char line[512];
+  snprintf(line, sizeof(line), "#Float tolerances tuned by @autotol for %.0f MB over %g h, %.1f MB projected.\n"
+                               "#Paste the dataref lines into rextconfig.txt in place of the ones without tol= to keep them.\n",
+           sToleranceTuner.GetBudgetBytes() / (1024 * 1024), sToleranceTuner.GetFlightHours(),
+           sToleranceTuner.GetProjectedBytes() / (1024 * 1024));
+  report << line;
+
+  for (size_t c = 0; c < sToleranceTuner.NumChannels(); c++)
+    {
+      snprintf(line, sizeof(line), "#noise %g, %.2f samples/s\n%s tol=%g\n",
+               sToleranceTuner.GetNoise(c), sToleranceTuner.GetRate(c),
+               sXPFloatValRecorders[sAutoTolChannels[c]].GetDataRefName(), sToleranceTuner.GetTolerance(c));
+      report << line;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// UpdateToleranceTuner - @autotol, opens the measuring window on the first record tick after the datarefs are all
+//                        registered and retunes at every check. Record ticks only. Storage is read as the record
+//                        workers published it, they are drained only to hand out or collect the probes and to
+//                        change tolerances. The report is written once the window ends and again at XPluginStop.
+//--------------------------------------------------------------------------------------------------------------------
+static void UpdateToleranceTuner(float time)
+{
+  double total   = (double)sRecordPipeline.StorageBytes(kRecordTypeNone);
+  double tuned   = 0.0;
+  double samples = 0.0;
+  size_t c;
+
+  for (c = 0; c < sAutoTolChannels.size(); c++)
+    {
+      tuned   += sRecordPipeline.ChannelStorageBytes(kRecordTypeFloat, sAutoTolChannels[c]);
+      samples += sRecordPipeline.ChannelSamples(kRecordTypeFloat, sAutoTolChannels[c]);
+    }
+
+  if (!sToleranceTuner.IsStarted())
+    {
+      sRecordPipeline.Drain();    // Recorders belong to the workers while recording
+
+      sToleranceTuner.Start(sAutoTolChannels.size(), time, tuned, total - tuned);
+      for (c = 0; c < sAutoTolChannels.size(); c++)
+        {
+          sXPFloatValRecorders[sAutoTolChannels[c]].SetToleranceProbe(sToleranceTuner.Probe(c));
+        }
+
+      DPRINT("Measuring %zu float datarefs for %.0f s to tune their tolerances\n", sAutoTolChannels.size(),
+             TUNER_WINDOW_SECONDS)
+      return;
+    }
+
+  bool windowEnds = sToleranceTuner.IsMeasuring();
+  if (windowEnds)
+    {
+      sRecordPipeline.Drain();    // The workers fill the probes Update reads
+    }
+
+  bool changed = sToleranceTuner.Update(time, tuned, total - tuned, samples);
+  if (changed && !windowEnds)
+    {
+      sRecordPipeline.Drain();
+    }
+
+  for (c = 0; c < sToleranceTuner.NumChannels(); c++)
+    {
+      if (windowEnds)
+        {
+          sXPFloatValRecorders[sAutoTolChannels[c]].SetToleranceProbe(NULL);
+        }
+      if (changed)
+        {
+          sXPFloatValRecorders[sAutoTolChannels[c]].SetRecordTolerance(sToleranceTuner.GetTolerance(c));
+        }
+    }
+
+  if (windowEnds)
+    {
+      WriteToleranceReport();
+    }
+
+  if (changed)
+    {
+      DPRINT("Float tolerances retuned: %.1f of %.1f MB used, %.1f MB projected\n", total / (1024 * 1024),
+             sToleranceTuner.GetBudgetBytes() / (1024 * 1024), sToleranceTuner.GetProjectedBytes() / (1024 * 1024))
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// StartRecordPipeline - spawn the record workers and, if the conf file asked for it, the disk writer
+//--------------------------------------------------------------------------------------------------------------------
+static void StartRecordPipeline()
+{
+  OpenRecordingJournal();
+
+  string recordingPath;
+  if (sWriterRingBytes > 0)
+    {
+      GetRecordingFilePath(recordingPath);
+    }
+
+  if (!recordingPath.empty() || sRecordingJournal.IsOpen())
+    {
+      unsigned numProducers = max(sNumRecordWorkers, 1u);
+      size_t   ringBytes    = (sWriterRingBytes > 0) ? sWriterRingBytes : 256 * 1024;
+
+      if (sRecordingWriter.Start(recordingPath, sRecordingJournal.IsOpen() ? &sRecordingJournal : NULL,
+                                 numProducers, ringBytes / numProducers))
+        {
+          if (!recordingPath.empty())
+            {
+              DPRINT("Streaming recorded changes to: %s\n", recordingPath.c_str());
+            }
+        }
+      else
+        {
+          DPRINT("Could not open recording file %s. Streaming disabled.\n", recordingPath.c_str());
+          sRecordingJournal.Close();
+        }
+    }
+
+  sRecordPipeline.SetKeyframeInterval(sKeyframeInterval);
+  sRecordPipeline.Start(sNumRecordWorkers, sStagingBytes, &sRecordingWriter);
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// CheckRecordingJournal - log the first time the journal wraps around and the first record it could not take
+//--------------------------------------------------------------------------------------------------------------------
+static void CheckRecordingJournal()
+{
+  if (!sJournalLapLogged && (sRecordingJournal.NumLaps() > 0))
+    {
+      sJournalLapLogged = true;
+      DPRINT("Crash journal full, it keeps the newest %zu to %zu bytes of the flight from now on\n",
+             sJournalBytes / 2, sJournalBytes)
+    }
+
+  if (!sJournalOverflowLogged && (sRecordingJournal.NumOverflowed() > 0))
+    {
+      sJournalOverflowLogged = true;
+      DPUTS("Crash journal too small to hold one lap of the datarefs, records are being dropped. Raise @journal.\n");
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// OpenRecordingJournal - recover an unclean previous session, then start journaling this one
+//--------------------------------------------------------------------------------------------------------------------
+static void OpenRecordingJournal()
+{
+  if (sJournalBytes == 0)
+    {
+      return;
+    }
+
+  string journalPath;
+  GetAircraftPluginTopDirPath(journalPath);
+  journalPath += XPLMGetDirectorySeparator();
+  journalPath += "rext_journal.bin";
+
+  string recoveredPath;
+  GetRecordingFilePath(recoveredPath);
+  recoveredPath.insert(recoveredPath.rfind("rext_") + 5, "recovered_");
+
+  size_t numRecovered = RecordingJournal::Recover(journalPath, recoveredPath);
+  if (numRecovered > 0)
+    {
+      DPRINT("Previous session did not end cleanly. Recovered %zu records to: %s\n", numRecovered, recoveredPath.c_str());
+    }
+
+  sJournalLapLogged      = false;
+  sJournalOverflowLogged = false;
+
+  if (sRecordingJournal.Open(journalPath, sJournalBytes))
+    {
+      DPRINT("Journaling recorded changes to: %s\n", journalPath.c_str());
+    }
+  else
+    {
+      DPRINT("Could not map journal file %s. Journaling disabled.\n", journalPath.c_str());
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// LoadConf - load preferences
+//--------------------------------------------------------------------------------------------------------------------
+static void LoadConf()
+{
+  string confPath;
+  GetConfFilePath(confPath);
+
+    //Read conf file C++ way, skip empty lines and comments #
+
+    fstream conffile;
+    DPRINT("Loading datarefs from: %s\n",confPath.c_str());
+    conffile.open(confPath,ios::in);
+    if (conffile.is_open())
+    {
+      string line;
+
+      while(getline(conffile, line))
+      {
+        if(!line.empty())
+        {
+          //key=value options go to dataref and @policy lines, split them off before the spaces go
+          string options;
+          size_t optionsPos = line.find('=');
+          if (optionsPos != string::npos && line.find_first_not_of(" \t") != line.find('#'))
+          {
+              optionsPos = line.find_last_of(" \t", optionsPos);
+              options = (optionsPos != string::npos) ? line.substr(optionsPos + 1) : string();
+              line = (optionsPos != string::npos) ? line.substr(0, optionsPos) : line;
+          }
+
+          //deal with spaces and multyplatform line endings
+          std::string chars = " \t\r\n";
+
+          for (char c: chars) {
+              line.erase(std::remove(line.begin(), line.end(), c), line.end());
+          }
+
+          if(line.empty()) continue;
+
+          if(line.substr(0,1) == "%")//config symbol
+          {
+              float interval = stof(line.substr(1),nullptr);
+
+              if(interval != NAN)
+              {
+                  if(interval == 0.0f)
+                        interval = -1.0f;
+
+                sIntervalBetweenAfterFlightLoopCallbacks = interval;
+              }
+
+
+            DPRINT("Recording interval set to: %f seconds\n",sIntervalBetweenAfterFlightLoopCallbacks)
+          }
+          else if(line.substr(0,1) == "#")//comment symbol
+          {
+            continue;
+          }
+          else if(line.substr(0,1) == "@")//named setting, e.g. @writer1024
+          {
+            ParseDirective(line, options);
+          }
+          else if(line.substr(0,1) == "$")//max recorded samples
+          {
+              size_t samples = stoul(line.substr(1),nullptr);
+
+              if(samples > 0)
+              {
+
+                maxReplayCount = samples;
+              }
+
+
+            DPRINT("Maximum recorded samples set to: %zu\n",maxReplayCount)
+          }
+          else if(line.substr(0,1) == "&")//float point value change
+          {
+              float tolerance = stof(line.substr(1),nullptr);
+
+              if(tolerance != NAN)
+              {
+                  if(tolerance < 0.0f)
+                        tolerance = 0.0f;
+
+                recordTolerance = tolerance;
+              }
+
+            DPRINT("Float recording tolerance set to: %f \n",recordTolerance)
+          }
+          else
+          {
+            ChannelPolicy policy = sConfPolicy;
+            ChannelPolicy linePolicy;
+            size_t rateGroup = sConfRateGroup;
+
+            if (!options.empty() && ParsePolicy(options, linePolicy))
+            {
+                policy.Apply(linePolicy);
+                rateGroup = (linePolicy.rate >= 0.0f) ? FindRateGroup(linePolicy.rate) : rateGroup;
+            }
+
+            //find out if dref is in array and save index
+            size_t startIndex = line.find('[');
+            size_t endIndex = line.find(']');
+            if (startIndex != string::npos && endIndex != string::npos)
+            {
+                int i = -1;
+                startIndex++;
+                string index;
+                if(endIndex>startIndex)//check if the user made a mistake and protect stoi
+                {
+                    index = line.substr(startIndex, endIndex - startIndex);
+                    if(!index.empty())//protect stoi
+                    {
+                        i = stoi(index,nullptr,10);//save index as int
+                    }
+                }
+                inDrefs.push(ConfDataRef(line.substr(0, startIndex-1), i, sConfLowPriority, rateGroup, policy));
+            }
+            else//if not in array dref
+            {
+                inDrefs.push(ConfDataRef(line, -1, sConfLowPriority, rateGroup, policy));
+            }
+          }
+        }
+      }
+      conffile.close();
+    }
+    else
+    {
+       DPUTS("Config file not found. Stopping...");
+       XPLMDisablePlugin(XPLMGetMyID());//does it work?
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ResolvePolicy - options of a conf line with & and $ standing in for the unset tolerance and sample count. & is the
+//                 float tolerance, ints without a tol of their own record every change.
+//--------------------------------------------------------------------------------------------------------------------
+static ChannelPolicy ResolvePolicy(const ConfDataRef &conf, bool isFloat)
+{
+  ChannelPolicy policy = conf.policy;
+
+  policy.tolerance   = (policy.tolerance >= 0.0f) ? policy.tolerance : isFloat ? recordTolerance : 0.0f;
+  policy.keepSamples = (policy.keepSamples >= 0) ? policy.keepSamples : (long long)maxReplayCount;
+
+  return policy;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// DeclareChannel - give a newly registered recorder its channel id and conf line settings, and announce it to the
+//                  recording file
+//--------------------------------------------------------------------------------------------------------------------
+template <typename R> static void DeclareChannel(R &recorders, RecordType type, const ConfDataRef &conf)
+{
+  recorders.back().SetChannelId(sNextChannelId++);
+  recorders.back().SetLowPriority(conf.lowPriority);
+  recorders.back().SetMaxReplaySeconds(conf.policy.keepSeconds > 0.0f ? conf.policy.keepSeconds : 0.0f);
+
+  CodecParams params;
+
+  params.maxError     = ResolvePolicy(conf, type == kRecordTypeFloat).tolerance;
+  params.rangeLo      = conf.policy.rangeLo;
+  params.rangeHi      = conf.policy.rangeHi;
+  params.budgetMicros = sCodecBudgetMicros;
+  recorders.back().SetBlockCodec(conf.policy.codec.empty() ? kCodecAuto : BlockCodecFromName(conf.policy.codec.c_str()),
+                                 params);
+
+  if ((type == kRecordTypeFloat) && (conf.policy.tolerance < 0.0f))
+    {
+      sAutoTolChannels.push_back((uint32_t)(recorders.size() - 1));
+    }
+
+  RateGroup &group = sRateGroups[conf.rateGroup];
+  vector<uint32_t> &channels = (type == kRecordTypeFloat) ? group.floats : (type == kRecordTypeInt) ? group.ints : group.bytes;
+  channels.push_back((uint32_t)(recorders.size() - 1));
+
+  sRecordPipeline.DeclareChannel(type, recorders.size() - 1,
+                                 recorders.back().GetChannelId(), recorders.back().GetDataRefName());
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// BindPipelineChannels - the recorder vectors may have moved, hand fresh pointers to the record workers
+//--------------------------------------------------------------------------------------------------------------------
+static void BindPipelineChannels()
+{
+  vector<ValueRecorder<float> *> floatChannels;
+  vector<ValueRecorder<int> *>   intChannels;
+  vector<DataRecorder *>         bytesChannels;
+  unsigned i;
+
+  for (i = 0; i < sXPFloatValRecorders.size(); i++)
+    {
+      floatChannels.push_back(&sXPFloatValRecorders[i]);
+    }
+
+  for (i = 0; i < sXPIntValRecorders.size(); i++)
+    {
+      intChannels.push_back(&sXPIntValRecorders[i]);
+    }
+  for (i = 0; i < sXPByteArrRecorders.size(); i++)
+    {
+      bytesChannels.push_back(&sXPByteArrRecorders[i]);
+    }
+
+  sRecordPipeline.BindChannels(floatChannels, intChannels, bytesChannels);
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// FindRateGroup - index of the rate group recording every that many seconds, added if there is none yet. 0 or less
+//                 is the main flight loop's group.
+//--------------------------------------------------------------------------------------------------------------------
+static size_t FindRateGroup(float seconds)
+{
+  if (seconds <= 0.0f)
+    {
+      return 0;
+    }
+
+  for (size_t g = 1; g < sRateGroups.size(); g++)
+    {
+      if (sRateGroups[g].interval == seconds)
+        {
+          return g;
+        }
+    }
+
+  sRateGroups.push_back(RateGroup());
+  sRateGroups.back().interval = seconds;
+  return sRateGroups.size() - 1;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ParsePolicy - space separated key=value options into outPolicy, unknown keys and bad values are logged and skipped.
+//               Returns false if nothing was understood.
+//--------------------------------------------------------------------------------------------------------------------
+static bool ParsePolicy(const string &options, ChannelPolicy &outPolicy)
+{
+  size_t start  = 0;
+  bool   parsed = false;
+
+  while ((start = options.find_first_not_of(" \t\r\n", start)) != string::npos)
+    {
+      size_t end   = options.find_first_of(" \t\r\n", start);
+      string entry = options.substr(start, (end == string::npos) ? string::npos : end - start);
+      size_t eq    = entry.find('=');
+      string key   = entry.substr(0, eq);
+      string value = (eq != string::npos) ? entry.substr(eq + 1) : string();
+      char   *unit  = NULL;
+      double number = strtod(value.c_str(), &unit);
+      bool   valid  = !value.empty() && (unit != value.c_str()) && (number >= 0.0);
+
+      start = end;
+
+      if (valid && (key == "tol") && (*unit == '\0'))
+        {
+          outPolicy.tolerance = (float)number;
+        }
+      else if (valid && (key == "keep") && (*unit == '\0'))
+        {
+          outPolicy.keepSamples = (long long)number;
+        }
+      else if (valid && (key == "keep") && (!strcmp(unit, "s") || !strcmp(unit, "m") || !strcmp(unit, "h")))
+        {
+          outPolicy.keepSeconds = (float)(number * ((*unit == 'h') ? 3600.0 : (*unit == 'm') ? 60.0 : 1.0));
+        }
+      else if (valid && (key == "rate") && (*unit == '\0'))
+        {
+          outPolicy.rate = (float)number;
+        }
+      else if ((key == "mode") && ((value == "linear") || (value == "step")))
+        {
+          outPolicy.linear = (value == "linear") ? 1 : 0;
+        }
+      else if ((key == "codec") && (BlockCodecFromName(value.c_str()) < kNumBlockCodecs))
+        {
+          outPolicy.codec = value;
+        }
+      else if ((key == "range") && (unit != value.c_str()) && (*unit == ':') && (strtod(unit + 1, NULL) > number))
+        {
+          outPolicy.rangeLo = (float)number;
+          outPolicy.rangeHi = (float)strtod(unit + 1, NULL);
+        }
+      else
+        {
+          DPRINT("Unknown dataref option ignored: %s\n", entry.c_str())
+          continue;
+        }
+
+      parsed = true;
+    }
+
+  return parsed;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// ParseDirective - named settings. Spaces are already stripped, the keyword runs up to the first non letter.
+//                  Options are the key=value words split off the line, only @policy and @autotol take them.
+//--------------------------------------------------------------------------------------------------------------------
+static void ParseDirective(const string &line, const string &options)
+{
+  size_t pos = 1;
+  while (pos < line.size() && isalpha((unsigned char)line[pos]))
+    {
+      pos++;
+    }
+
+  string keyword = line.substr(1, pos - 1);
+  string value   = line.substr(pos);
+
+  if (keyword == "writer")//stream recorded changes to disk, value is the ring buffer size in KB
+    {
+      long kb = value.empty() ? 0 : stol(value, nullptr);
+      sWriterRingBytes = (kb > 0) ? (size_t)kb * 1024 : 0;
+
+      DPRINT("Recording writer buffer set to: %zu bytes\n", sWriterRingBytes)
+    }
+  else if (keyword == "workers")//record worker threads, 0 records on the sim thread
+    {
+      long workers = value.empty() ? 0 : stol(value, nullptr);
+      sNumRecordWorkers = (workers > 0) ? (unsigned)min(workers, (long)PIPELINE_MAX_WORKERS) : 0;
+
+      DPRINT("Record worker threads set to: %u\n", sNumRecordWorkers)
+    }
+  else if (keyword == "staging")//sim thread to record worker buffer size in KB
+    {
+      long kb = value.empty() ? 0 : stol(value, nullptr);
+      if (kb > 0)
+        {
+          sStagingBytes = (size_t)kb * 1024;
+        }
+
+      DPRINT("Record staging buffer set to: %zu bytes\n", sStagingBytes)
+    }
+  else if (keyword == "seekthreads")//threads rebuilding channel values after a replay seek, 0 disables
+    {
+      long threads = value.empty() ? 0 : stol(value, nullptr);
+      sNumSeekThreads = (threads > 0) ? (unsigned)min(threads, 16L) : 0;
+
+      DPRINT("Replay seek threads set to: %u\n", sNumSeekThreads)
+    }
+  else if (keyword == "keyframe")//seconds between replay seek keyframes, 0 disables
+    {
+      float seconds = value.empty() ? 0.0f : stof(value, nullptr);
+      sKeyframeInterval = (seconds > 0.0f) ? seconds : 0.0f;
+
+      DPRINT("Replay keyframe interval set to: %.1f s\n", sKeyframeInterval)
+    }
+  else if (keyword == "trace")//record a timeline for chrome://tracing, value is the number of events kept
+    {
+      long events = value.empty() ? 0 : stol(value, nullptr);
+      sTraceEvents = (events > 0) ? (size_t)events : 0;
+
+      DPRINT("Trace buffer set to: %zu events\n", sTraceEvents)
+    }
+  else if (keyword == "budget")//record tick time budget in microseconds, channels rotate over ticks, 0 disables
+    {
+      float micros = value.empty() ? 0.0f : stof(value, nullptr);
+      sRecordBudgetMicros = (micros > 0.0f) ? micros : 0.0f;
+
+      DPRINT("Record tick budget set to: %.0f us\n", sRecordBudgetMicros)
+    }
+  else if (keyword == "fps")//record governor target frame rate, 0 disables
+    {
+      float fps = value.empty() ? 0.0f : stof(value, nullptr);
+      sGovernor.SetTargetFps(fps);
+
+      DPRINT("Record governor target set to: %.1f fps\n", sGovernor.GetTargetFps())
+    }
+  else if (keyword == "priority")//priority of the datarefs that follow, 0 - low, paused first by the governor
+    {
+      sConfLowPriority = !value.empty() && (stol(value, nullptr) <= 0);
+
+      DPRINT("Following datarefs are %s priority\n", sConfLowPriority ? "low" : "normal")
+    }
+  else if (keyword == "rate")//record the datarefs that follow every that many seconds on a flight loop of their own
+    {
+      float seconds = value.empty() ? 0.0f : stof(value, nullptr);
+
+      sConfRateGroup = FindRateGroup(seconds);
+
+      DPRINT("Following datarefs recorded every: %.3f s\n", sConfRateGroup ? seconds : sIntervalBetweenAfterFlightLoopCallbacks)
+    }
+  else if (keyword == "staleness")//adaptive polling, seconds a quiet dataref may go unread, 0 disables
+    {
+      float seconds = value.empty() ? 0.0f : stof(value, nullptr);
+      sMaxStaleness = (seconds > 0.0f) ? seconds : 0.0f;
+
+      DPRINT("Adaptive polling max staleness set to: %.3f s\n", sMaxStaleness)
+    }
+  else if (keyword == "policy")//key=value options of the datarefs that follow, a bare @policy clears them
+    {
+      sConfPolicy = ChannelPolicy();
+      if (!options.empty())
+        {
+          ParsePolicy(options, sConfPolicy);
+        }
+      if (sConfPolicy.rate >= 0.0f)
+        {
+          sConfRateGroup = FindRateGroup(sConfPolicy.rate);
+        }
+
+      DPRINT("Following datarefs use options: %s\n", options.empty() ? "none" : options.c_str())
+    }
+  else if (keyword == "codecbudget")//microseconds auto may spend trying codecs on a sealed block, 0 tries them all
+    {
+      float micros = value.empty() ? 0.0f : stof(value, nullptr);
+      sCodecBudgetMicros = (micros > 0.0f) ? micros : 0.0f;
+
+      DPRINT("Block codec trial budget set to: %.0f us\n", sCodecBudgetMicros)
+    }
+  else if (keyword == "autotol")//float tolerances tuned to a memory budget in MB, hours= the flight it must last
+    {
+      long   mb    = value.empty() ? 0 : stol(value, nullptr);
+      size_t hours = options.find("hours=");
+
+      sToleranceTuner.SetBudget((mb > 0) ? (double)mb * 1024 * 1024 : 0.0,
+                                (hours != string::npos) ? strtof(options.c_str() + hours + 6, NULL) : TUNER_DEFAULT_HOURS);
+
+      DPRINT("Float tolerance budget set to: %.0f MB over %g h\n",
+             sToleranceTuner.GetBudgetBytes() / (1024 * 1024), sToleranceTuner.GetFlightHours())
+    }
+  else if (keyword == "retain")//seconds of full rate history, older history thinned out into coarser tiers, 0 disables
+    {
+      float seconds = value.empty() ? 0.0f : stof(value, nullptr);
+      sRetention.Set((seconds > 0.0f) ? seconds : 0.0f);
+
+      DPRINT("Full rate history set to: %.0f s, then %g s buckets, %g s buckets after %.0f s\n", sRetention.fullSeconds,
+             sRetention.bucketSeconds[0], sRetention.bucketSeconds[1], sRetention.ageSeconds[1])
+    }
+  else if (keyword == "journal")//crash-safe journal, value is the journal file size in MB
+    {
+      long mb = value.empty() ? 0 : stol(value, nullptr);
+      sJournalBytes = (mb > 0) ? (size_t)mb * 1024 * 1024 : 0;
+
+      DPRINT("Crash journal size set to: %zu bytes\n", sJournalBytes)
+    }
+  else
+    {
+      DPRINT("Unknown setting ignored: %s\n", line.c_str())
+    }
+}
+
+static void RegisterDrefs()
+{
+    static unsigned attempts = 0;
+    static unsigned remaining = 0;
+    bool drained = false;
+    TRACE_SCOPE("register");
+    ALLOC_SCOPE(kAllocRegister, kRecordTypeNone);
+
+        if(remaining != inDrefs.size()){
+          DPRINT("Daterefs remaining %zu\n",inDrefs.size());
+          remaining = inDrefs.size();
+        }
+        for (long long unsigned i=0; i<inDrefs.size(); i++)
+        {
+                //If dataref exsists push it to the coresponding vecor
+                XPLMDataRef temp = XPLMFindDataRef(inDrefs.front().name.c_str());
+                sTickXPLMCalls++;
+                if (temp != NULL)
+                {
+                    XPLMDataTypeID type = XPLMGetDataRefTypes(temp);
+                    ChannelPolicy policy = ResolvePolicy(inDrefs.front(), (type & (xplmType_Float | xplmType_FloatArray)) != 0);
+                    sTickXPLMCalls += 2;
+                    sTickChannels++;
+                    if(XPLMCanWriteDataRef(temp))//try to find out if the dataref is writable. Else ignore it.
+                    {
+                        if(!drained)
+                        {
+                            sRecordPipeline.Drain();//recorders are about to move, let the workers finish with them
+                            drained = true;
+                        }
+                        //Try to guess what is the type of the dataref and register it accordingly.
+                        if((type & xplmType_Float) == xplmType_Float)
+                        {
+                            sXPFloatValRecorders.push_back(FloatDataRefRecorder(inDrefs.front().name, temp, -1, (size_t)policy.keepSamples, policy.tolerance));
+                            sXPFloatValRecorders.back().SetLinear(policy.linear > 0);
+                            sXPFloatValRecorders.back().SetRetention(&sRetention);//byte arrays have no min or max to thin out to
+                            DeclareChannel(sXPFloatValRecorders, kRecordTypeFloat, inDrefs.front());
+                            DPRINT("Float type dateref registered %s\n",inDrefs.front().name.c_str());
+                        }
+                        else if((type & xplmType_Int) == xplmType_Int)
+                        {
+                            sXPIntValRecorders.push_back(IntDataRefRecorder(inDrefs.front().name, temp, -1, (size_t)policy.keepSamples, (int)policy.tolerance));
+                            sXPIntValRecorders.back().SetRetention(&sRetention);
+                            DeclareChannel(sXPIntValRecorders, kRecordTypeInt, inDrefs.front());
+                            DPRINT("Int type dateref registered %s\n",inDrefs.front().name.c_str());
+                        }
+                        else if((type & xplmType_Data) == xplmType_Data)
+                        {
+                            sXPByteArrRecorders.push_back(ByteArrDataRefRecorder(inDrefs.front().name, temp, (size_t)policy.keepSamples));
+                            DeclareChannel(sXPByteArrRecorders, kRecordTypeBytes, inDrefs.front());
+                            DPRINT("Byte array type dateref registered %s\n",inDrefs.front().name.c_str());
+                        }
+                        else if((type & xplmType_FloatArray) == xplmType_FloatArray)
+                        {
+                            if(inDrefs.front().index >= 0)
+                            {
+                                string dref_name = inDrefs.front().name+"[" + to_string(inDrefs.front().index)+"]";//Restore the name with the index
+                                sXPFloatValRecorders.push_back(FloatDataRefRecorder(dref_name, temp, inDrefs.front().index, (size_t)policy.keepSamples, policy.tolerance));
+                                sXPFloatValRecorders.back().SetLinear(policy.linear > 0);
+                                sXPFloatValRecorders.back().SetRetention(&sRetention);
+                                DeclareChannel(sXPFloatValRecorders, kRecordTypeFloat, inDrefs.front());
+                                DPRINT("Float type array member dateref registered %s\n",dref_name.c_str());
+                            }
+                            else
+                            {
+                                //No index records the whole array, storing only the elements that change
+                                sXPByteArrRecorders.push_back(ByteArrDataRefRecorder(inDrefs.front().name, temp, (size_t)policy.keepSamples,
+                                                                                     vector<uint8_t>(), xplmType_FloatArray));
+                                DeclareChannel(sXPByteArrRecorders, kRecordTypeBytes, inDrefs.front());
+                                DPRINT("Float array dateref registered whole %s\n",inDrefs.front().name.c_str());
+                            }
+                        }
+                        else if((type & xplmType_IntArray) == xplmType_IntArray)
+                        {
+                            if(inDrefs.front().index >= 0)
+                            {
+                                string dref_name = inDrefs.front().name+"[" + to_string(inDrefs.front().index)+"]";
+                                sXPIntValRecorders.push_back(IntDataRefRecorder(dref_name, temp, inDrefs.front().index, (size_t)policy.keepSamples, (int)policy.tolerance));
+                                sXPIntValRecorders.back().SetRetention(&sRetention);
+                                DeclareChannel(sXPIntValRecorders, kRecordTypeInt, inDrefs.front());
+                                DPRINT("Int type array member dateref registered %s\n",dref_name.c_str());
+                            }
+                            else
+                            {
+                                sXPByteArrRecorders.push_back(ByteArrDataRefRecorder(inDrefs.front().name, temp, (size_t)policy.keepSamples,
+                                                                                     vector<uint8_t>(), xplmType_IntArray));
+                                DeclareChannel(sXPByteArrRecorders, kRecordTypeBytes, inDrefs.front());
+                                DPRINT("Int array dateref registered whole %s\n",inDrefs.front().name.c_str());
+                            }
+                        }
+                        else
+                        {
+                            DPRINT("Dateref type not supported %s.\n", inDrefs.front().name.c_str());
+
+                        }
+                    }
+                    else
+                    {
+                        DPRINT("Dateref not writable and will not be used %s\n",inDrefs.front().name.c_str());
+                    }
+
+                    inDrefs.pop();//Remove the dataref we have just registered from the queue
+                }
+                else
+                {
+                    //If the dataref does not exist yet during this iteration push it at the back of the queue for the next attempt.
+                    inDrefs.push(inDrefs.front());
+                    inDrefs.pop();
+                }
+
+        }
+        if(++attempts > 200)//Enough is enough. If a dataref does not exist/is created in, lets say 200 loops, it is probably wrong. Give up.
+        {
+            for(size_t i = 0; i<inDrefs.size(); i++)
+            {
+              DPRINT("Dataref not found in 200 flight loops. Skipping... %s\n", inDrefs.front().name.c_str());
+              inDrefs.pop();
+            }
+        }
+
+    if(drained)
+    {
+        BindPipelineChannels();
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------
+// GetAircraftPluginFilePath - return path to the aircraft's plugin directory
+//--------------------------------------------------------------------------------------------------------------------
+static void GetAircraftPluginFilePath(string &pluginFilePath)
+{
+  char temp[1024];
+  XPLMGetPluginInfo(XPLMGetMyID(), NULL, temp, NULL, NULL);
+
+  pluginFilePath = temp;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// GetAircraftPluginTopDirPath - return top directory of the plugin
+//--------------------------------------------------------------------------------------------------------------------
+static void GetAircraftPluginTopDirPath(string &pluginDirPath)
+{
+  string path;
+  GetAircraftPluginFilePath(path);
+
+  string dirSep = XPLMGetDirectorySeparator();
+
+  size_t pos = path.rfind(dirSep);
+  if (pos != string::npos)
+    {
+      pos = path.rfind(dirSep, pos - 1);
+      if (pos != string::npos)
+        {
+            pluginDirPath = path.substr(0, pos);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// PrintRecorderStatsToLog -
+//--------------------------------------------------------------------------------------------------------------------
+static void PrintRecorderStatsToLog()
+{
+  unsigned i;
+
+  DPUTS("\n");
+  DPRINT("Total Elapsed Time Recorded: %.3f\n", XPLMGetDataf(sTotalRunningTimeDataRef));
+
+  for (i = 0; i < sXPFloatValRecorders.size(); i++)
+    {
+      DPRINT("%-60s has %zu recorded elements\n",
+              sXPFloatValRecorders[i].GetDataRefName(), sXPFloatValRecorders[i].NumEventsRecorded());
+    }
+
+  for (i = 0; i < sXPIntValRecorders.size(); i++)
+    {
+      DPRINT("%-60s has %zu recorded elements\n",
+              sXPIntValRecorders[i].GetDataRefName(), sXPIntValRecorders[i].NumEventsRecorded());
+    }
+  for (i = 0; i < sXPByteArrRecorders.size(); i++)
+    {
+      DPRINT("%-60s has %zu recorded elements\n",
+              sXPByteArrRecorders[i].GetDataRefName(), sXPByteArrRecorders[i].NumEventsRecorded());
+    }
+
+  RecordPipelineStats pipelineStats = sRecordPipeline.GetStats();
+
+  DPRINT("Record pipeline: %u workers, %llu changes recorded, %llu of %llu staged ticks dropped\n",
+         pipelineStats.numWorkers, (unsigned long long)pipelineStats.changesRecorded,
+         (unsigned long long)pipelineStats.framesDropped,
+         (unsigned long long)(pipelineStats.framesStaged + pipelineStats.framesDropped));
+  DPRINT("Record pipeline: staging high-water mark %zu of %zu bytes, %zu keyframes\n",
+         pipelineStats.stagingHighWater, pipelineStats.stagingCapacity, pipelineStats.keyframes);
+
+  for (size_t g = 0; g < sRateGroups.size(); g++)
+    {
+      RateGroup &group = sRateGroups[g];
+
+      if (sRateGroups.size() > 1)
+        {
+          DPRINT("Rate group %zu: every %.3f s, %zu float, %zu int, %zu byte array datarefs\n", g,
+                 g ? group.interval : sIntervalBetweenAfterFlightLoopCallbacks,
+                 group.floats.size(), group.ints.size(), group.bytes.size());
+        }
+      if (sRecordBudgetMicros > 0.0f)
+        {
+          DPRINT("Record budget: %.0f us per tick, %.3f us per channel, a rotation took %d ticks\n",
+                 sRecordBudgetMicros, group.microsPerChannel, group.cycleTicks);
+        }
+    }
+
+  if (sMaxStaleness > 0.0f)
+    {
+      int    tiers[POLL_NUM_TIERS];
+      string perTier;
+
+      CountPollTiers(tiers);
+      for (int t = 0; t < POLL_NUM_TIERS; t++)
+        {
+          perTier += " " + to_string(tiers[t]);
+        }
+
+      DPRINT("Adaptive polling: %lld of %lld polls skipped, max staleness %.3f s, channels per tier:%s\n",
+             sPollSkippedTotal, sPollSkippedTotal + sPollReadsTotal, sMaxStaleness, perTier.c_str());
+    }
+
+  if (sGovernor.IsEnabled())
+    {
+      DPRINT("Record governor: target %.1f fps, now %.1f fps, level %d, %u level changes\n",
+             sGovernor.GetTargetFps(), sGovernor.GetFps(), sGovernor.GetLevel(), sGovernor.NumChanges());
+    }
+
+  if (sToleranceTuner.IsStarted())
+    {
+      DPRINT("Float tolerance tuning: %zu datarefs, %u retunes, %.1f of %.1f MB projected\n",
+             sToleranceTuner.NumChannels(), sToleranceTuner.NumTunings(),
+             sToleranceTuner.GetProjectedBytes() / (1024 * 1024), sToleranceTuner.GetBudgetBytes() / (1024 * 1024));
+    }
+
+  if (sRetention.IsEnabled())
+    {
+      size_t tierBytes;
+      size_t tierEvents = 0;
+      size_t bytes      = sRecordPipeline.StorageBytes(kRecordTypeNone, &tierBytes);
+
+      for (i = 0; i < sXPFloatValRecorders.size(); i++)
+        {
+          tierEvents += sXPFloatValRecorders[i].NumTierEvents();
+        }
+      for (i = 0; i < sXPIntValRecorders.size(); i++)
+        {
+          tierEvents += sXPIntValRecorders[i].NumTierEvents();
+        }
+
+      DPRINT("Retention tiers: %zu elements in %.1f of %.1f MB, full rate for the last %.0f s\n", tierEvents,
+             tierBytes / (1024.0 * 1024.0), bytes / (1024.0 * 1024.0), sRetention.fullSeconds)
+    }
+
+  if (sNumSeeks > 0)
+    {
+      DPRINT("Replay seeks: %u, last took %lld us, slowest %lld us\n", sNumSeeks, sLastSeekMicros, sMaxSeekMicros);
+    }
+
+  for (int p = 0; p < kNumTickPhases; p++)
+    {
+      TickPhaseSummary summary = sTickStats.Summary((TickPhase)p);
+      if (summary.ticks > 0)
+        {
+          DPRINT("Tick cost %-8s: %llu ticks, latest p50 %.1f us, p99 %.1f us, max %.1f us\n",
+                 TickStats::PhaseName((TickPhase)p), (unsigned long long)summary.ticks,
+                 summary.p50Us, summary.p99Us, summary.maxUs);
+        }
+    }
+
+  CodecStats &codecStats = GetCodecStats();
+  for (int c = kCodecRaw; c < kCodecAuto; c++)
+    {
+      uint64_t blocks = codecStats.blocks[c].load(memory_order_relaxed);
+      uint64_t packed = codecStats.packedBytes[c].load(memory_order_relaxed);
+      if (blocks > 0)
+        {
+          DPRINT("Block codec %-4s: %llu blocks, %llu bytes packed to %llu, ratio %.2f\n",
+                 BlockCodecName((BlockCodecId)c), (unsigned long long)blocks,
+                 (unsigned long long)codecStats.rawBytes[c].load(memory_order_relaxed), (unsigned long long)packed,
+                 packed ? (double)codecStats.rawBytes[c].load(memory_order_relaxed) / packed : 0.0);
+        }
+    }
+
+  for (int p = 0; AllocTracker::IsEnabled() && (p < kNumAllocPhases); p++)
+    {
+      AllocCounts counts = AllocTracker::Get((AllocPhase)p);
+      if (counts.allocs > 0)
+        {
+          DPRINT("Allocations %-8s: %llu, %llu bytes\n", AllocTracker::PhaseName((AllocPhase)p),
+                 (unsigned long long)counts.allocs, (unsigned long long)counts.bytes);
+        }
+    }
+
+  if (sRecordingWriter.GetStats().ringCapacity > 0)
+    {
+      RecordingWriterStats stats = sRecordingWriter.GetStats();
+
+      DPRINT("Recording writer: %llu records written, %llu bytes, %llu dropped, %llu write errors\n",
+             (unsigned long long)stats.recordsWritten, (unsigned long long)stats.bytesWritten,
+             (unsigned long long)stats.recordsDropped, (unsigned long long)stats.writeErrors);
+      DPRINT("Recording writer: ring high-water mark %zu of %zu bytes\n", stats.ringHighWater, stats.ringCapacity);
+    }
+
+  if (sRecordingJournal.IsOpen())
+    {
+      RecordingJournalStats stats = sRecordingJournal.GetStats();
+
+      DPRINT("Crash journal: %zu of %zu bytes used, %llu records, %llu commits, %u laps, %llu records did not fit\n",
+             stats.used, stats.capacity, (unsigned long long)stats.recordsAppended,
+             (unsigned long long)stats.commits, stats.laps, (unsigned long long)stats.recordsOverflowed);
+    }
+  DPUTS("\n");
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// GetStorageBytes - rext/stats/storage/<type> accessor, refcon is the RecordType. Heap bytes held by the history of
+//                   each channel as the record workers last published them, clamped to int.
+//--------------------------------------------------------------------------------------------------------------------
+static int GetStorageBytes(void *inRefcon, int *outValues, int inOffset, int inMax)
+{
+  RecordType type        = (RecordType)(intptr_t)inRefcon;
+  size_t     numChannels = (type == kRecordTypeFloat) ? sXPFloatValRecorders.size() :
+                           (type == kRecordTypeInt)   ? sXPIntValRecorders.size() :
+                           (type == kRecordTypeBytes) ? sXPByteArrRecorders.size() : 0;
+
+  if ((outValues == NULL) || (numChannels == 0))
+    {
+      return (int)numChannels;
+    }
+
+  int n = 0;
+  for (size_t i = (size_t)max(inOffset, 0); (i < numChannels) && (n < inMax); i++)
+    {
+      outValues[n++] = (int)min(sRecordPipeline.ChannelStorageBytes(type, i), (size_t)INT_MAX);
+    }
+  return n;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// GetAllocCounts - rext/stats/alloc/<phase>/allocs and bytes, indexed by RecordType, refcon is phase * 2 + field.
+//                  Totals since load, they wrap at 32 bits so readers should diff them as unsigned.
+//--------------------------------------------------------------------------------------------------------------------
+static int GetAllocCounts(void *inRefcon, int *outValues, int inOffset, int inMax)
+{
+  intptr_t id = (intptr_t)inRefcon;
+
+  if (outValues == NULL)
+    {
+      return ALLOC_NUM_TYPES;
+    }
+
+  int n = 0;
+  for (int t = max(inOffset, 0); (t < ALLOC_NUM_TYPES) && (n < inMax); t++)
+    {
+      AllocCounts counts = AllocTracker::Get((AllocPhase)(id / 2), (RecordType)t);
+      outValues[n++] = (int)(uint32_t)((id % 2) ? counts.bytes : counts.allocs);
+    }
+  return n;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// GetCodecCounts - rext/stats/codec/blocks and ratio, indexed by BlockCodecId, refcon 0 for blocks packed and 1 for
+//                  raw bytes per packed byte times 100. Totals since load.
+//--------------------------------------------------------------------------------------------------------------------
+static int GetCodecCounts(void *inRefcon, int *outValues, int inOffset, int inMax)
+{
+  CodecStats &stats = GetCodecStats();
+
+  if (outValues == NULL)
+    {
+      return kNumBlockCodecs;
+    }
+
+  int n = 0;
+  for (int c = max(inOffset, 0); (c < kNumBlockCodecs) && (n < inMax); c++)
+    {
+      uint64_t packed = stats.packedBytes[c].load(memory_order_relaxed);
+
+      if (inRefcon == NULL)
+        {
+          outValues[n++] = (int)(uint32_t)stats.blocks[c].load(memory_order_relaxed);
+        }
+      else
+        {
+          outValues[n++] = packed ? (int)(stats.rawBytes[c].load(memory_order_relaxed) * 100 / packed) : 0;
+        }
+    }
+  return n;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// GetPhaseStat - rext/stats/<phase>/p50_us, p99_us and max_us, refcon is phase * 3 + field
+//--------------------------------------------------------------------------------------------------------------------
+static float GetPhaseStat(void *inRefcon)
+{
+  intptr_t         id      = (intptr_t)inRefcon;
+  TickPhaseSummary summary = sTickStats.Summary((TickPhase)(id / 3));
+
+  switch (id % 3)
+    {
+      case 0:  return summary.p50Us;
+      case 1:  return summary.p99Us;
+      default: return summary.maxUs;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// GetPhaseTicks - rext/stats/<phase>/ticks
+//--------------------------------------------------------------------------------------------------------------------
+static int GetPhaseTicks(void *inRefcon)
+{
+  return (int)min(sTickStats.Summary((TickPhase)(intptr_t)inRefcon).ticks, (uint64_t)INT_MAX);
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// GetTickCounter - rext/stats/tick/..., refcon points at the counter
+//--------------------------------------------------------------------------------------------------------------------
+static int GetTickCounter(void *inRefcon)
+{
+  return *(int *)inRefcon;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// GetRotationTicks - rext/stats/record/rotation_ticks, of the main flight loop's channels
+//--------------------------------------------------------------------------------------------------------------------
+static int GetRotationTicks(void *inRefcon)
+{
+  return sRateGroups[0].cycleTicks;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// GetGovernorLevel / GetGovernorFps / GetGovernorInterval - rext/stats/governor/...
+//--------------------------------------------------------------------------------------------------------------------
+static int GetGovernorLevel(void *inRefcon)
+{
+  return sGovernor.GetLevel();
+}
+
+static float GetGovernorFps(void *inRefcon)
+{
+  return sGovernor.GetFps();
+}
+
+static float GetGovernorInterval(void *inRefcon)
+{
+  return sEffectiveInterval;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// CountPollTiers - channels per adaptive polling tier, outTiers has POLL_NUM_TIERS entries
+//--------------------------------------------------------------------------------------------------------------------
+static void CountPollTiers(int *outTiers)
+{
+  unsigned i;
+
+  fill(outTiers, outTiers + POLL_NUM_TIERS, 0);
+
+  for (i = 0; i < sXPFloatValRecorders.size(); i++)
+    {
+      outTiers[sXPFloatValRecorders[i].Poll().tier]++;
+    }
+  for (i = 0; i < sXPIntValRecorders.size(); i++)
+    {
+      outTiers[sXPIntValRecorders[i].Poll().tier]++;
+    }
+  for (i = 0; i < sXPByteArrRecorders.size(); i++)
+    {
+      outTiers[sXPByteArrRecorders[i].Poll().tier]++;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// GetPollTiers - rext/stats/poll/tiers, channels per adaptive polling tier. Tier 0 is polled every record tick,
+//                each tier above it half as often as the one below.
+//--------------------------------------------------------------------------------------------------------------------
+static int GetPollTiers(void *inRefcon, int *outValues, int inOffset, int inMax)
+{
+  if (outValues == NULL)
+    {
+      return POLL_NUM_TIERS;
+    }
+
+  int tiers[POLL_NUM_TIERS];
+  CountPollTiers(tiers);
+
+  int n = 0;
+  for (int t = max(inOffset, 0); (t < POLL_NUM_TIERS) && (n < inMax); t++)
+    {
+      outValues[n++] = tiers[t];
+    }
+  return n;
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// GetProjectedKb - rext/stats/autotol/projected_kb, storage @autotol expects at the end of the flight
+//--------------------------------------------------------------------------------------------------------------------
+static int GetProjectedKb(void *inRefcon)
+{
+  return (int)min(sToleranceTuner.GetProjectedBytes() / 1024, (double)INT_MAX);
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// GetStorageKb - rext/stats/storage_kb, total of all channels as the record workers last published it
+//--------------------------------------------------------------------------------------------------------------------
+static int GetStorageKb(void *inRefcon)
+{
+  return (int)min(sRecordPipeline.StorageBytes(kRecordTypeNone) / 1024, (size_t)INT_MAX);
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// GetTierKb - rext/stats/retain/tier_kb, the part of rext/stats/storage_kb in the @retain tiers
+//--------------------------------------------------------------------------------------------------------------------
+static int GetTierKb(void *inRefcon)
+{
+  size_t tiers;
+
+  sRecordPipeline.StorageBytes(kRecordTypeNone, &tiers);
+  return (int)min(tiers / 1024, (size_t)INT_MAX);
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// RegisterStat -
+//--------------------------------------------------------------------------------------------------------------------
+static void RegisterStat(const string &name, XPLMGetDatai_f readInt, XPLMGetDataf_f readFloat, void *refcon)
+{
+  sStatsDataRefs.push_back(XPLMRegisterDataAccessor(name.c_str(), readInt ? xplmType_Int : xplmType_Float, 0,
+                                                    readInt, NULL, readFloat, NULL, NULL, NULL,
+                                                    NULL, NULL, NULL, NULL, NULL, NULL, refcon, NULL));
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// RegisterStatsDataRefs - read only rext/stats/... datarefs for DataRefEditor and tools watching the plugin.
+//                         Tick costs are over the latest TICK_STATS_WINDOW ticks of each phase, the tick counters
+//                         are for the latest flight loop. Channels are in registration order per type.
+//--------------------------------------------------------------------------------------------------------------------
+static void RegisterStatsDataRefs()
+{
+  static const char *fields[3] = { "p50_us", "p99_us", "max_us" };
+
+  for (int p = 0; p < kNumTickPhases; p++)
+    {
+      string prefix = string("rext/stats/") + TickStats::PhaseName((TickPhase)p) + "/";
+
+      for (int f = 0; f < 3; f++)
+        {
+          RegisterStat(prefix + fields[f], NULL, GetPhaseStat, (void *)(intptr_t)(p * 3 + f));
+        }
+      RegisterStat(prefix + "ticks", GetPhaseTicks, NULL, (void *)(intptr_t)p);
+    }
+
+  RegisterStat("rext/stats/tick/channels", GetTickCounter, NULL, &sTickChannels);
+  RegisterStat("rext/stats/tick/xplm_calls", GetTickCounter, NULL, &sTickXPLMCalls);
+  RegisterStat("rext/stats/record/rotation_ticks", GetRotationTicks, NULL, NULL);
+  RegisterStat("rext/stats/governor/level", GetGovernorLevel, NULL, NULL);
+  RegisterStat("rext/stats/governor/fps", NULL, GetGovernorFps, NULL);
+  RegisterStat("rext/stats/governor/interval", NULL, GetGovernorInterval, NULL);
+  RegisterStat("rext/stats/governor/dropped", GetTickCounter, NULL, &sGovernorDropped);
+  RegisterStat("rext/stats/poll/skipped", GetTickCounter, NULL, &sPollSkipped);
+  RegisterStat("rext/stats/storage_kb", GetStorageKb, NULL, NULL);
+  RegisterStat("rext/stats/autotol/projected_kb", GetProjectedKb, NULL, NULL);
+  RegisterStat("rext/stats/retain/tier_kb", GetTierKb, NULL, NULL);
+
+  sStatsDataRefs.push_back(XPLMRegisterDataAccessor("rext/stats/poll/tiers", xplmType_IntArray, 0,
+                                                    NULL, NULL, NULL, NULL, NULL, NULL,
+                                                    GetPollTiers, NULL, NULL, NULL, NULL, NULL, NULL, NULL));
+
+  for (int f = 0; f < 2; f++)
+    {
+      sStatsDataRefs.push_back(XPLMRegisterDataAccessor(f ? "rext/stats/codec/ratio" : "rext/stats/codec/blocks",
+                                                        xplmType_IntArray, 0,
+                                                        NULL, NULL, NULL, NULL, NULL, NULL,
+                                                        GetCodecCounts, NULL, NULL, NULL, NULL, NULL,
+                                                        (void *)(intptr_t)f, NULL));
+    }
+
+  static const struct { const char *name; RecordType type; } storage[] =
+    {
+      { "rext/stats/storage/float", kRecordTypeFloat },
+      { "rext/stats/storage/int",   kRecordTypeInt   },
+      { "rext/stats/storage/bytes", kRecordTypeBytes }
+    };
+
+  for (size_t i = 0; i < sizeof(storage) / sizeof(storage[0]); i++)
+    {
+      sStatsDataRefs.push_back(XPLMRegisterDataAccessor(storage[i].name, xplmType_IntArray, 0,
+                                                        NULL, NULL, NULL, NULL, NULL, NULL,
+                                                        GetStorageBytes, NULL, NULL, NULL, NULL, NULL,
+                                                        (void *)(intptr_t)storage[i].type, NULL));
+    }
+
+  //
+  // Profiling builds only, see AllocTracker.h
+  //
+  for (int p = 0; AllocTracker::IsEnabled() && (p < kNumAllocPhases); p++)
+    {
+      string prefix = string("rext/stats/alloc/") + AllocTracker::PhaseName((AllocPhase)p) + "/";
+
+      for (int f = 0; f < 2; f++)
+        {
+          sStatsDataRefs.push_back(XPLMRegisterDataAccessor((prefix + (f ? "bytes" : "allocs")).c_str(),
+                                                            xplmType_IntArray, 0,
+                                                            NULL, NULL, NULL, NULL, NULL, NULL,
+                                                            GetAllocCounts, NULL, NULL, NULL, NULL, NULL,
+                                                            (void *)(intptr_t)(p * 2 + f), NULL));
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------
+// UnregisterStatsDataRefs -
+//--------------------------------------------------------------------------------------------------------------------
+static void UnregisterStatsDataRefs()
+{
+  for (size_t i = 0; i < sStatsDataRefs.size(); i++)
+    {
+      XPLMUnregisterDataAccessor(sStatsDataRefs[i]);
+    }
+  sStatsDataRefs.clear();
+}
+
+
+static void menu_handler(void * in_menu_ref, void * in_item_ref)
+{
+
+	if(!strcmp((const char *)in_item_ref, "trace"))
+	{
+        DumpTrace();
+	}
+	else if(!strcmp((const char *)in_item_ref, "rec") && XPLMGetDatai(sInReplayModeDataRef) == 0)
+	{
+        XPLMMenuCheck check;
+        XPLMCheckMenuItemState(g_menu_id, mindex,  &check);
+		if (check == xplm_Menu_Unchecked){
+            XPLMCheckMenuItem(g_menu_id, mindex, xplm_Menu_Checked);
+            XPLMSetMenuItemName(g_menu_id, mindex, sStopRecordLabel, 0);
+            record = true;
+            sGovernor.Reset();
+		}
+		else if (check == xplm_Menu_Checked){
+            XPLMCheckMenuItem(g_menu_id, mindex, xplm_Menu_Unchecked);
+            XPLMSetMenuItemName(g_menu_id, mindex, sStartRecordLabel, 0);
+            record = false;
+		}
+	}
+
+}